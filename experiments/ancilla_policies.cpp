@@ -0,0 +1,135 @@
+/* caterpillar: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file ancilla_policies.cpp
+  \brief Compares ancilla allocation policies of LUT-based hierarchical synthesis
+
+  Each benchmark is synthesized with every mapping strategy and ancilla
+  policy.  Depth and T-depth are reported with their change relative to the
+  LIFO policy, which is the default.  Benchmarks are read from
+  EXPERIMENTS_BENCHMARKS_PATH, missing benchmarks are skipped.
+*/
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <caterpillar/details/ancilla_pool.hpp>
+#include <caterpillar/details/resource_estimation.hpp>
+#include <caterpillar/structures/stg_gate.hpp>
+#include <caterpillar/synthesis/lhrs.hpp>
+#include <caterpillar/synthesis/strategies/bennett_mapping_strategy.hpp>
+#include <caterpillar/synthesis/strategies/eager_mapping_strategy.hpp>
+#include <caterpillar/synthesis/strategies/xag_mapping_strategy.hpp>
+#include <mockturtle/networks/xag.hpp>
+#include <tweedledum/networks/netlist.hpp>
+
+#include "experiments.hpp"
+
+using namespace caterpillar;
+using experiment_t = experiments::experiment<std::string, uint32_t, uint32_t, int32_t, uint32_t, int32_t>;
+
+struct strategy_entry
+{
+  std::string name;
+  std::function<std::unique_ptr<mapping_strategy<xag_network>>()> make;
+  bool low_tdepth{false};
+};
+
+static const std::vector<std::pair<std::string, ancilla_policy>> policies = {
+    {"lifo", ancilla_policy::lifo},
+    {"fifo", ancilla_policy::fifo},
+    {"least_recently_busy", ancilla_policy::least_recently_busy},
+    {"lowest_index", ancilla_policy::lowest_index}};
+
+static resource_estimation_stats run( xag_network const& xag, strategy_entry const& strategy, ancilla_policy policy )
+{
+  tweedledum::netlist<stg_gate> circ;
+  logic_network_synthesis_params ps;
+  ps.ancilla_allocation = policy;
+
+  auto s = strategy.make();
+  logic_network_synthesis( circ, xag, *s, {}, ps );
+
+  resource_estimation_params rps;
+  rps.use_tdepth1 = strategy.low_tdepth;
+  return estimate_resources( circ, rps );
+}
+
+int main()
+{
+  std::vector<strategy_entry> strategies = {
+      {"bennett", []() { return std::make_unique<bennett_mapping_strategy<xag_network>>(); }},
+      {"eager", []() { return std::make_unique<eager_mapping_strategy<xag_network>>(); }},
+      {"xag_lowt", []() { return std::make_unique<xag_mapping_strategy>(); }},
+      {"xag_lowd", []() { return std::make_unique<xag_low_depth_mapping_strategy>( true ); }, true}};
+
+  std::vector<std::pair<std::string, xag_network>> suite;
+  for ( auto const& name : experiments::epfl_arithmetic )
+  {
+    if ( auto xag = experiments::read_benchmark( experiments::benchmark_path( "arithmetic", name, "aig" ) ) )
+    {
+      suite.emplace_back( name, *xag );
+    }
+  }
+  for ( auto const& name : experiments::crypto )
+  {
+    if ( auto xag = experiments::read_benchmark( experiments::benchmark_path( "crypto", name, "v" ) ) )
+    {
+      suite.emplace_back( name, *xag );
+    }
+  }
+
+  for ( auto const& strategy : strategies )
+  {
+    experiment_t exp( "ancilla_policies_" + strategy.name, "benchmark", "qubits", "depth", "depth_delta", "t_depth", "t_depth_delta" );
+
+    for ( auto const& [benchmark, xag] : suite )
+    {
+      fmt::print( "[i] processing {} with {}\n", benchmark, strategy.name );
+
+      resource_estimation_stats lifo;
+      for ( auto const& [name, policy] : policies )
+      {
+        const auto res = run( xag, strategy, policy );
+        if ( policy == ancilla_policy::lifo )
+        {
+          lifo = res;
+        }
+        exp( fmt::format( "{}/{}", benchmark, name ), res.num_qubits, res.depth, static_cast<int32_t>( res.depth ) - static_cast<int32_t>( lifo.depth ),
+             res.t_depth, static_cast<int32_t>( res.t_depth ) - static_cast<int32_t>( lifo.t_depth ) );
+      }
+    }
+
+    exp.save();
+    exp.table();
+    exp.compare( {}, {}, {"depth", "t_depth"} );
+  }
+
+  return 0;
+}
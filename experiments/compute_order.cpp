@@ -0,0 +1,146 @@
+/* caterpillar: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file compute_order.cpp
+  \brief Compares the topological and the ancilla-aware compute order
+
+  Each benchmark is synthesized with the eager and the Bennett strategy in
+  both compute orders.  The number of required ancillae is reported with
+  its change relative to the topological order, together with the time to
+  compute the ancilla-aware order.  Benchmarks are read from
+  EXPERIMENTS_BENCHMARKS_PATH, missing benchmarks are skipped; synthetic
+  adders and multipliers whose outputs are created interleaved are always
+  included.
+*/
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <caterpillar/details/compute_order.hpp>
+#include <caterpillar/structures/stg_gate.hpp>
+#include <caterpillar/synthesis/lhrs.hpp>
+#include <caterpillar/synthesis/strategies/bennett_mapping_strategy.hpp>
+#include <caterpillar/synthesis/strategies/eager_mapping_strategy.hpp>
+#include <mockturtle/generators/arithmetic.hpp>
+#include <mockturtle/networks/xag.hpp>
+#include <mockturtle/utils/stopwatch.hpp>
+#include <tweedledum/networks/netlist.hpp>
+
+#include "experiments.hpp"
+
+using namespace caterpillar;
+using experiment_t = experiments::experiment<std::string, uint32_t, uint32_t, uint32_t, int32_t, float>;
+
+/* `count` circuits of width `bitwidth` whose gates and outputs are created bit by bit */
+template<class Fn>
+static xag_network interleaved( uint32_t count, uint32_t bitwidth, Fn&& make )
+{
+  xag_network xag;
+  std::vector<std::vector<xag_network::signal>> outputs;
+  for ( auto k = 0u; k < count; ++k )
+  {
+    std::vector<xag_network::signal> a( bitwidth ), b( bitwidth );
+    std::generate( a.begin(), a.end(), [&]() { return xag.create_pi(); } );
+    std::generate( b.begin(), b.end(), [&]() { return xag.create_pi(); } );
+    outputs.push_back( make( xag, a, b ) );
+  }
+  for ( auto i = 0u; i < outputs.front().size(); ++i )
+  {
+    for ( auto const& word : outputs )
+    {
+      xag.create_po( word[i] );
+    }
+  }
+  return xag;
+}
+
+template<class Strategy>
+static uint32_t required_ancillae( xag_network const& xag, compute_order order )
+{
+  tweedledum::netlist<stg_gate> circ;
+  logic_network_synthesis_stats st;
+  Strategy strategy( order );
+  logic_network_synthesis( circ, xag, strategy, {}, {}, &st );
+  return st.required_ancillae;
+}
+
+int main()
+{
+  std::vector<std::pair<std::string, xag_network>> suite;
+  for ( auto const& name : experiments::epfl_arithmetic )
+  {
+    if ( auto xag = experiments::read_benchmark( experiments::benchmark_path( "arithmetic", name, "aig" ) ) )
+    {
+      suite.emplace_back( name, *xag );
+    }
+  }
+  for ( auto const& name : experiments::crypto )
+  {
+    if ( auto xag = experiments::read_benchmark( experiments::benchmark_path( "crypto", name, "v" ) ) )
+    {
+      suite.emplace_back( name, *xag );
+    }
+  }
+
+  auto adder = []( xag_network& xag, auto a, auto const& b ) {
+    auto carry = xag.get_constant( false );
+    mockturtle::carry_ripple_adder_inplace( xag, a, b, carry );
+    a.push_back( carry );
+    return a;
+  };
+  auto multiplier = []( xag_network& xag, auto const& a, auto const& b ) {
+    return mockturtle::carry_ripple_multiplier( xag, a, b );
+  };
+  suite.emplace_back( "adders_16x32", interleaved( 16u, 32u, adder ) );
+  suite.emplace_back( "multipliers_4x8", interleaved( 4u, 8u, multiplier ) );
+  suite.emplace_back( "multipliers_8x16", interleaved( 8u, 16u, multiplier ) );
+
+  experiment_t exp( "compute_order", "benchmark", "gates", "topological", "ancilla_aware", "delta", "order_time" );
+  for ( auto const& [benchmark, xag] : suite )
+  {
+    fmt::print( "[i] processing {}\n", benchmark );
+
+    mockturtle::stopwatch<>::duration time_order{0};
+    mockturtle::call_with_stopwatch( time_order, [&]() { ancilla_aware_order( xag ); } );
+
+    const auto eager_topo = required_ancillae<eager_mapping_strategy<xag_network>>( xag, compute_order::topological );
+    const auto eager_aware = required_ancillae<eager_mapping_strategy<xag_network>>( xag, compute_order::ancilla_aware );
+    exp( fmt::format( "{}/eager", benchmark ), xag.num_gates(), eager_topo, eager_aware,
+         static_cast<int32_t>( eager_aware ) - static_cast<int32_t>( eager_topo ), mockturtle::to_seconds( time_order ) );
+
+    const auto bennett_topo = required_ancillae<bennett_mapping_strategy<xag_network>>( xag, compute_order::topological );
+    const auto bennett_aware = required_ancillae<bennett_mapping_strategy<xag_network>>( xag, compute_order::ancilla_aware );
+    exp( fmt::format( "{}/bennett", benchmark ), xag.num_gates(), bennett_topo, bennett_aware,
+         static_cast<int32_t>( bennett_aware ) - static_cast<int32_t>( bennett_topo ), mockturtle::to_seconds( time_order ) );
+  }
+
+  exp.save();
+  exp.table();
+  exp.compare( {}, {}, {"ancilla_aware", "delta"} );
+
+  return 0;
+}
@@ -31,16 +31,20 @@
 */
 
 #include <array>
+#include <cstdint>
 #include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <optional>
 #include <tuple>
 #include <type_traits>
 #include <vector>
 
+#include <sys/resource.h>
+
 #include <fmt/color.h>
 #include <fmt/format.h>
 #include <json.hpp>
@@ -53,8 +57,12 @@
 #include <mockturtle/networks/xag.hpp>
 #include <mockturtle/networks/abstract_xag.hpp>
 #include <kitty/dynamic_truth_table.hpp>
+#include <lorina/aiger.hpp>
+#include <lorina/verilog.hpp>
 #include <mockturtle/algorithms/equivalence_checking.hpp>
 #include <mockturtle/algorithms/miter.hpp>
+#include <mockturtle/io/aiger_reader.hpp>
+#include <mockturtle/io/verilog_reader.hpp>
 #include <mockturtle/views/depth_view.hpp>
 
 using namespace mockturtle;
@@ -373,6 +381,82 @@ private:
   nlohmann::json data_;
 };
 
+/* benchmark suites, stored in EXPERIMENTS_BENCHMARKS_PATH/<suite>/<name>.<ext> */
+static const std::vector<std::string> epfl_arithmetic = {"adder", "bar", "div", "hyp", "log2", "max", "multiplier", "sin", "sqrt", "square"};
+static const std::vector<std::string> epfl_random_control = {"arbiter", "cavlc", "ctrl", "dec", "i2c", "int2float", "mem_ctrl", "priority", "router", "voter"};
+static const std::vector<std::string> crypto = {"adder_32bit", "adder_64bit", "comparator_32bit_signed_lt", "comparator_32bit_signed_lteq",
+                                                "comparator_32bit_unsigned_lt", "comparator_32bit_unsigned_lteq", "mult_32x32",
+                                                "aes_128", "des", "md5", "sha_1", "sha_256"};
+
+inline std::string benchmark_path( std::string const& suite, std::string const& name, std::string const& extension )
+{
+#ifndef EXPERIMENTS_BENCHMARKS_PATH
+  return fmt::format( "benchmarks/{}/{}.{}", suite, name, extension );
+#else
+  return fmt::format( "{}{}/{}.{}", EXPERIMENTS_BENCHMARKS_PATH, suite, name, extension );
+#endif
+}
+
+/*! \brief Reads an AIGER (.aig) or Verilog (.v) benchmark into an XAG, `nullopt` if not available. */
+inline std::optional<xag_network> read_benchmark( std::string const& filename )
+{
+  if ( !std::ifstream( filename ).good() )
+  {
+    fmt::print( "[w] benchmark {} not found\n", filename );
+    return std::nullopt;
+  }
+
+  xag_network xag;
+  lorina::return_code result;
+  if ( filename.size() > 4u && filename.compare( filename.size() - 4u, 4u, ".aig" ) == 0 )
+  {
+    result = lorina::read_aiger( filename, aiger_reader( xag ) );
+  }
+  else
+  {
+    result = lorina::read_verilog( filename, verilog_reader( xag ) );
+  }
+
+  if ( result != lorina::return_code::success )
+  {
+    fmt::print( "[w] could not parse {}\n", filename );
+    return std::nullopt;
+  }
+  return xag;
+}
+
+/*! \brief Resets the peak resident set size of the process (Linux only). */
+inline void reset_peak_rss()
+{
+  std::ofstream os( "/proc/self/clear_refs" );
+  if ( os.good() )
+  {
+    os << "5";
+  }
+}
+
+/*! \brief Peak resident set size in MB since the last call to `reset_peak_rss`.
+ *
+ * Falls back to the peak of the whole process, if the value cannot be read
+ * from `/proc/self/status`.
+ */
+inline float peak_rss()
+{
+  std::ifstream in( "/proc/self/status" );
+  std::string line;
+  while ( std::getline( in, line ) )
+  {
+    if ( line.compare( 0u, 6u, "VmHWM:" ) == 0 )
+    {
+      return std::stoul( line.substr( 6u ) ) / 1024.0f;
+    }
+  }
+
+  rusage usage;
+  getrusage( RUSAGE_SELF, &usage );
+  return usage.ru_maxrss / 1024.0f;
+}
+
 template <typename Ntk>
 bool check_equivalence_tt(Ntk const& ntk, tweedledum::netlist<caterpillar::stg_gate> const& rev, std::vector<uint32_t> const pi_lines, std::vector<uint32_t> const po_lines)
 {
@@ -0,0 +1,174 @@
+/* caterpillar: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file lhrs_strategies.cpp
+  \brief Runs LUT-based hierarchical synthesis with all mapping strategies
+
+  Benchmarks are read from EXPERIMENTS_BENCHMARKS_PATH (EPFL suites as
+  AIGER, crypto suite as Verilog), missing benchmarks are skipped.  Adders
+  and multipliers generated with mockturtle are always synthesized, such
+  that the stored baseline covers every strategy.  One result file is
+  written per strategy and compared to the previous run.
+
+  The 16 inputs of gen_multiplier_8 fit into a single cut of best_fit
+  (cut_size 16), such that each output is synthesized from the PPRM of a
+  16-input function, which explains its T-count.
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <caterpillar/details/resource_estimation.hpp>
+#include <caterpillar/structures/stg_gate.hpp>
+#include <caterpillar/synthesis/lhrs.hpp>
+#include <caterpillar/synthesis/strategies/bennett_mapping_strategy.hpp>
+#include <caterpillar/synthesis/strategies/best_fit_mapping_strategy.hpp>
+#include <caterpillar/synthesis/strategies/eager_mapping_strategy.hpp>
+#include <caterpillar/synthesis/strategies/xag_mapping_strategy.hpp>
+#include <caterpillar/verification/simulate_circuit.hpp>
+#include <mockturtle/generators/arithmetic.hpp>
+#include <mockturtle/networks/xag.hpp>
+#include <mockturtle/utils/stopwatch.hpp>
+#include <tweedledum/networks/netlist.hpp>
+
+#include "experiments.hpp"
+
+using namespace caterpillar;
+using experiment_t = experiments::experiment<std::string, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, float, float, bool>;
+
+struct strategy_entry
+{
+  std::string name;
+  std::function<std::unique_ptr<mapping_strategy<xag_network>>()> make;
+  bool low_tdepth{false};
+};
+
+static xag_network adder( uint32_t bitwidth )
+{
+  xag_network xag;
+  std::vector<xag_network::signal> a( bitwidth ), b( bitwidth );
+  std::generate( a.begin(), a.end(), [&]() { return xag.create_pi(); } );
+  std::generate( b.begin(), b.end(), [&]() { return xag.create_pi(); } );
+  auto carry = xag.get_constant( false );
+  mockturtle::carry_ripple_adder_inplace( xag, a, b, carry );
+  std::for_each( a.begin(), a.end(), [&]( auto f ) { xag.create_po( f ); } );
+  xag.create_po( carry );
+  return xag;
+}
+
+static xag_network multiplier( uint32_t bitwidth )
+{
+  xag_network xag;
+  std::vector<xag_network::signal> a( bitwidth ), b( bitwidth );
+  std::generate( a.begin(), a.end(), [&]() { return xag.create_pi(); } );
+  std::generate( b.begin(), b.end(), [&]() { return xag.create_pi(); } );
+  for ( auto const& f : mockturtle::carry_ripple_multiplier( xag, a, b ) )
+  {
+    xag.create_po( f );
+  }
+  return xag;
+}
+
+static void run( experiment_t& exp, std::string const& benchmark, xag_network const& xag, strategy_entry const& strategy )
+{
+  tweedledum::netlist<stg_gate> circ;
+  logic_network_synthesis_stats st;
+
+  experiments::reset_peak_rss();
+  auto s = strategy.make();
+  logic_network_synthesis( circ, xag, *s, {}, {}, &st );
+  const auto rss = experiments::peak_rss();
+
+  resource_estimation_params ps;
+  ps.use_tdepth1 = strategy.low_tdepth;
+  const auto res = estimate_resources( circ, ps );
+
+  simulation_checking_params sim_ps;
+  const auto eq = simulation_checking( circ, xag, st.i_indexes, st.o_indexes, sim_ps );
+
+  exp( benchmark, xag.num_gates(), res.num_qubits, static_cast<uint32_t>( res.cnot_count ), static_cast<uint32_t>( res.t_count ), res.t_depth,
+       mockturtle::to_seconds( st.time_total ), rss, eq && *eq );
+}
+
+int main()
+{
+  std::vector<strategy_entry> strategies = {
+      {"bennett", []() { return std::make_unique<bennett_mapping_strategy<xag_network>>(); }},
+      {"bennett_inplace", []() { return std::make_unique<bennett_inplace_mapping_strategy<xag_network>>(); }},
+      {"best_fit", []() { return std::make_unique<best_fit_mapping_strategy<xag_network>>(); }},
+      {"eager", []() { return std::make_unique<eager_mapping_strategy<xag_network>>(); }},
+      {"xag_lowt", []() { return std::make_unique<xag_mapping_strategy>(); }},
+      {"xag_fast_lowt", []() { return std::make_unique<xag_fast_lowt_mapping_strategy>(); }},
+      {"xag_lowd", []() { return std::make_unique<xag_low_depth_mapping_strategy>( true ); }, true}};
+
+  std::vector<std::pair<std::string, xag_network>> suite;
+  for ( auto const& name : experiments::epfl_arithmetic )
+  {
+    if ( auto xag = experiments::read_benchmark( experiments::benchmark_path( "arithmetic", name, "aig" ) ) )
+    {
+      suite.emplace_back( name, *xag );
+    }
+  }
+  for ( auto const& name : experiments::epfl_random_control )
+  {
+    if ( auto xag = experiments::read_benchmark( experiments::benchmark_path( "random_control", name, "aig" ) ) )
+    {
+      suite.emplace_back( name, *xag );
+    }
+  }
+  for ( auto const& name : experiments::crypto )
+  {
+    if ( auto xag = experiments::read_benchmark( experiments::benchmark_path( "crypto", name, "v" ) ) )
+    {
+      suite.emplace_back( name, *xag );
+    }
+  }
+  suite.emplace_back( "gen_adder_32", adder( 32u ) );
+  suite.emplace_back( "gen_adder_64", adder( 64u ) );
+  suite.emplace_back( "gen_multiplier_8", multiplier( 8u ) );
+  suite.emplace_back( "gen_multiplier_16", multiplier( 16u ) );
+
+  for ( auto const& strategy : strategies )
+  {
+    experiment_t exp( "lhrs_" + strategy.name, "benchmark", "gates", "qubits", "cnots", "t_count", "t_depth", "time", "rss", "equivalent" );
+
+    for ( auto const& [benchmark, xag] : suite )
+    {
+      fmt::print( "[i] processing {} with {}\n", benchmark, strategy.name );
+      run( exp, benchmark, xag, strategy );
+    }
+
+    exp.save();
+    exp.table();
+    exp.compare( {}, {}, {"qubits", "cnots", "t_count", "t_depth"} );
+  }
+
+  return 0;
+}
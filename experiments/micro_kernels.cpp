@@ -0,0 +1,460 @@
+/* caterpillar: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file micro_kernels.cpp
+  \brief Micro-benchmarks of hot kernels on synthetic scaled inputs
+
+  Usage: micro_kernels [max_size]
+
+  Each kernel runs on inputs of size 1k, 10k, ... up to `max_size`
+  (default 1M, at most 10M).  Kernels with super-linear complexity are
+  capped at smaller sizes.  Results are keyed by kernel and size and
+  compared to the previous run.
+
+  Heap allocations are counted by replacing the global `operator new`.  The
+  gate emission kernels synthesize into a sink that only counts gates, such
+  that the allocations are those of the synthesis, and their size is the
+  number of emitted gates.
+*/
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <caterpillar/details/reed_muller.hpp>
+#include <caterpillar/details/utils.hpp>
+#include <caterpillar/optimization/post_opt_esop.hpp>
+#include <caterpillar/solvers/bsat_solver.hpp>
+#include <caterpillar/structures/stg_gate.hpp>
+#include <caterpillar/synthesis/lhrs.hpp>
+#include <caterpillar/synthesis/stg_to_mcx.hpp>
+#include <caterpillar/synthesis/strategies/bennett_mapping_strategy.hpp>
+#include <caterpillar/synthesis/strategies/xag_mapping_strategy.hpp>
+#include <caterpillar/synthesis/xag_tracer.hpp>
+#include <kitty/constructors.hpp>
+#include <kitty/cube.hpp>
+#include <kitty/dynamic_truth_table.hpp>
+#include <kitty/esop.hpp>
+#include <mockturtle/generators/arithmetic.hpp>
+#include <mockturtle/networks/xag.hpp>
+#include <tweedledum/gates/gate_base.hpp>
+#include <tweedledum/networks/netlist.hpp>
+#include <tweedledum/networks/qubit.hpp>
+
+#include "experiments.hpp"
+
+using namespace caterpillar;
+using experiment_t = experiments::experiment<std::string, uint32_t, float, float, float>;
+
+static std::atomic<uint64_t> num_allocations{0u};
+
+void* operator new( std::size_t size )
+{
+  ++num_allocations;
+  if ( auto* p = std::malloc( size ? size : 1u ) )
+  {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete( void* p ) noexcept
+{
+  std::free( p );
+}
+
+void operator delete( void* p, std::size_t ) noexcept
+{
+  std::free( p );
+}
+
+/* quantum network that only counts qubits and gates */
+class null_network
+{
+public:
+  tweedledum::qubit_id add_qubit()
+  {
+    return tweedledum::qubit_id( _num_qubits++ );
+  }
+
+  uint32_t num_qubits() const
+  {
+    return _num_qubits;
+  }
+
+  uint64_t num_gates() const
+  {
+    return _num_gates;
+  }
+
+  void add_gate( tweedledum::gate_base const&, tweedledum::qubit_id )
+  {
+    ++_num_gates;
+  }
+
+  void add_gate( tweedledum::gate_base const&, tweedledum::qubit_id, tweedledum::qubit_id )
+  {
+    ++_num_gates;
+  }
+
+  void add_gate( tweedledum::gate_base const&, std::vector<tweedledum::qubit_id> const&, std::vector<tweedledum::qubit_id> const& )
+  {
+    ++_num_gates;
+  }
+
+private:
+  uint32_t _num_qubits{0u};
+  uint64_t _num_gates{0u};
+};
+
+enum class gate_mix
+{
+  and_only,
+  xor_only,
+  mixed
+};
+
+/* replays the steps of a strategy, such that only the gate emission is measured */
+class replay_mapping_strategy : public mapping_strategy<xag_network>
+{
+public:
+  replay_mapping_strategy( mapping_strategy<xag_network>& strategy, xag_network const& xag )
+      : _policy( strategy.preferred_ancilla_policy() )
+  {
+    strategy.compute_steps( xag );
+    strategy.foreach_step( [&]( auto const& n, auto const& action ) { steps().emplace_back( n, action ); } );
+  }
+
+  bool compute_steps( xag_network const& ) override
+  {
+    return true;
+  }
+
+  ancilla_policy preferred_ancilla_policy() const override
+  {
+    return _policy;
+  }
+
+private:
+  ancilla_policy _policy;
+};
+
+/* random XAG with `num_gates` gates whose fanins are drawn from the last 64 signals */
+static xag_network synthetic_xag( uint32_t num_gates, gate_mix mix, uint64_t seed = 1u )
+{
+  std::mt19937_64 gen( seed );
+  xag_network xag;
+  std::vector<xag_network::signal> window;
+  for ( auto i = 0u; i < 64u; ++i )
+  {
+    window.push_back( xag.create_pi() );
+  }
+
+  for ( auto i = 0u; i < num_gates; ++i )
+  {
+    const auto a = window[gen() % window.size()] ^ static_cast<bool>( gen() & 1 );
+    auto b = window[gen() % window.size()];
+    if ( xag.get_node( a ) == xag.get_node( b ) )
+    {
+      b = window[( std::find( window.begin(), window.end(), b ) - window.begin() + 1 ) % window.size()];
+    }
+
+    const auto use_and = mix == gate_mix::and_only || ( mix == gate_mix::mixed && ( gen() & 1 ) );
+    const auto f = use_and ? xag.create_and( a, b ) : xag.create_xor( a, b );
+    window[i % window.size()] = f;
+  }
+
+  for ( auto const& f : window )
+  {
+    xag.create_po( f );
+  }
+  return xag;
+}
+
+/* random circuit of X, CX, and Toffoli gates */
+static tweedledum::netlist<stg_gate> synthetic_circuit( uint32_t num_gates, uint32_t num_qubits = 256u, uint64_t seed = 1u )
+{
+  std::mt19937_64 gen( seed );
+  tweedledum::netlist<stg_gate> circ;
+  for ( auto i = 0u; i < num_qubits; ++i )
+  {
+    circ.add_qubit();
+  }
+
+  for ( auto i = 0u; i < num_gates; ++i )
+  {
+    const auto t = tweedledum::qubit_id( gen() % num_qubits );
+    const auto c1 = tweedledum::qubit_id( ( t + 1u + gen() % ( num_qubits / 2u ) ) % num_qubits );
+    const auto c2 = tweedledum::qubit_id( ( t + 1u + num_qubits / 2u + gen() % ( num_qubits / 2u - 1u ) ) % num_qubits );
+    switch ( gen() % 3u )
+    {
+    case 0u:
+      circ.add_gate( tweedledum::gate::pauli_x, t );
+      break;
+    case 1u:
+      circ.add_gate( tweedledum::gate::cx, c1, t );
+      break;
+    default:
+      circ.add_gate( tweedledum::gate::mcx, std::vector<tweedledum::qubit_id>{c1, c2}, std::vector<tweedledum::qubit_id>{t} );
+      break;
+    }
+  }
+  return circ;
+}
+
+/* random ESOP with `num_cubes` cubes over 6 variables */
+static std::vector<kitty::cube> synthetic_esop( uint32_t num_cubes, uint64_t seed = 1u )
+{
+  std::mt19937_64 gen( seed );
+  std::vector<kitty::cube> esop;
+  for ( auto i = 0u; i < num_cubes; ++i )
+  {
+    const auto mask = static_cast<uint32_t>( gen() & 0x3f );
+    esop.emplace_back( static_cast<uint32_t>( gen() ) & mask, mask );
+  }
+  return esop;
+}
+
+template<class Fn>
+static void measure( experiment_t& exp, std::string const& kernel, uint32_t size, Fn&& fn )
+{
+  const auto allocations = num_allocations.load();
+  const auto start = std::chrono::high_resolution_clock::now();
+  fn();
+  const auto time = std::chrono::duration<float>( std::chrono::high_resolution_clock::now() - start ).count();
+  const auto allocs = static_cast<float>( num_allocations.load() - allocations ) / size;
+
+  fmt::print( "[i] {:<28} {:>9} {:>8.3f} s {:>8.2f} allocs/item\n", kernel, size, time, allocs );
+  exp( fmt::format( "{}/{}", kernel, size ), size, time, time * 1e9f / size, allocs );
+}
+
+int main( int argc, char** argv )
+{
+  const auto max_size = std::min<uint32_t>( argc > 1 ? std::stoul( argv[1] ) : 1000000u, 10000000u );
+
+  std::vector<uint32_t> sizes;
+  for ( auto size = 1000u; size <= max_size; size *= 10u )
+  {
+    sizes.push_back( size );
+  }
+
+  experiment_t exp( "micro_kernels", "kernel", "size", "time", "ns/item", "allocs/item" );
+
+  for ( auto size : sizes )
+  {
+    /* fanin-cone computation of the XAG strategies */
+    {
+      const auto xag = synthetic_xag( size, gate_mix::mixed );
+      const auto drivers = caterpillar::detail::get_outputs( xag );
+      std::vector<std::vector<uint32_t>> fi;
+      measure( exp, "get_fi", size, [&]() { fi = get_fi( xag, drivers ); } );
+      measure( exp, "get_cones", size, [&]() {
+        xag.foreach_gate( [&]( auto n ) {
+          if ( xag.is_and( n ) )
+          {
+            get_cones( n, xag, fi );
+          }
+        } );
+      } );
+      measure( exp, "sym_diff", size, [&]() {
+        xag.foreach_gate( [&]( auto n ) {
+          std::array<uint32_t, 2> fanin;
+          xag.foreach_fanin( n, [&]( auto f, auto i ) { fanin[i] = xag.node_to_index( xag.get_node( f ) ); } );
+          sym_diff( fi[fanin[0]], fi[fanin[1]] );
+        } );
+      } );
+    }
+
+    /* compute_node per gate type, measured through Bennett synthesis */
+    for ( auto const& [mix, name] : {std::make_pair( gate_mix::and_only, "compute_node_and" ),
+                                     std::make_pair( gate_mix::xor_only, "compute_node_xor" ),
+                                     std::make_pair( gate_mix::mixed, "compute_node_mixed" )} )
+    {
+      const auto xag = synthetic_xag( size, mix );
+      measure( exp, name, size, [&]() {
+        tweedledum::netlist<stg_gate> circ;
+        bennett_mapping_strategy<xag_network> strategy;
+        logic_network_synthesis( circ, xag, strategy );
+      } );
+    }
+
+    /* gate emission of the XAG strategies on ripple-carry adders (64 bits for size 1k) */
+    if ( size <= 100000u )
+    {
+      const auto bitwidth = 64u * ( size / 1000u );
+      xag_network xag;
+      std::vector<xag_network::signal> a( bitwidth ), b( bitwidth );
+      std::generate( a.begin(), a.end(), [&]() { return xag.create_pi(); } );
+      std::generate( b.begin(), b.end(), [&]() { return xag.create_pi(); } );
+      auto carry = xag.get_constant( false );
+      mockturtle::carry_ripple_adder_inplace( xag, a, b, carry );
+      std::for_each( a.begin(), a.end(), [&]( auto f ) { xag.create_po( f ); } );
+      xag.create_po( carry );
+
+      const auto emit = [&]( auto const& name, auto&& strategy, bool low_tdepth ) {
+        replay_mapping_strategy replay( strategy, xag );
+
+        logic_network_synthesis_params ps;
+        ps.low_tdepth_AND = low_tdepth;
+        null_network sink;
+        logic_network_synthesis( sink, xag, replay, {}, ps );
+        measure( exp, fmt::format( "emit_lhrs_{}", name ), static_cast<uint32_t>( sink.num_gates() ), [&]() {
+          null_network sink;
+          logic_network_synthesis( sink, xag, replay, {}, ps );
+        } );
+
+        xag_tracer_params tps;
+        tps.low_tdepth_AND = low_tdepth;
+        xag_tracer_stats tst;
+        xag_tracer( xag, replay, tps, &tst );
+        measure( exp, fmt::format( "emit_tracer_{}", name ), static_cast<uint32_t>( tst.profile.num_gates ), [&]() {
+          xag_tracer( xag, replay, tps );
+        } );
+      };
+      emit( "xag_lowt", xag_mapping_strategy(), false );
+      emit( "xag_lowd", xag_low_depth_mapping_strategy( true ), true );
+    }
+
+    /* qc_stats on random {X, CX, CCX} circuits */
+    {
+      const auto circ = synthetic_circuit( size );
+      measure( exp, "qc_stats", size, [&]() { caterpillar::detail::qc_stats( circ ); } );
+    }
+
+    /* CNF encoding of one pebbling step */
+    if ( size <= 100000u )
+    {
+      const auto xag = synthetic_xag( size, gate_mix::mixed );
+      bsat_pebble_solver<xag_network> solver( xag, 16u );
+      solver.init();
+      measure( exp, "bsat_add_step", size, [&]() { solver.add_step(); } );
+    }
+
+    /* ESOP pairing of the optimization graph (quadratic in the number of cubes) */
+    if ( size <= 10000u )
+    {
+      const auto esop = synthetic_esop( size );
+      measure( exp, "match_pairing", size, [&]() { match_pairing( esop ); } );
+    }
+
+    /* single-target gate synthesis, cache hits and misses */
+    if ( size <= 10000u )
+    {
+      std::mt19937_64 gen( size );
+      std::vector<kitty::dynamic_truth_table> functions( 64u, kitty::dynamic_truth_table( 4u ) );
+      for ( auto& tt : functions )
+      {
+        const uint64_t word = gen() & 0xffff;
+        kitty::create_from_words( tt, &word, &word + 1 );
+      }
+      std::vector<tweedledum::qubit_id> qubit_map = {0u, 1u, 2u, 3u, 4u};
+
+      stg_from_exact_synthesis synth;
+      tweedledum::netlist<stg_gate> circ;
+      for ( auto i = 0u; i < 5u; ++i )
+      {
+        circ.add_qubit();
+      }
+
+      const auto misses = std::min<uint32_t>( size / 100u, functions.size() );
+      measure( exp, "stg_exact_miss", misses, [&]() {
+        for ( auto i = 0u; i < misses; ++i )
+        {
+          synth( circ, qubit_map, functions[i] );
+        }
+      } );
+      measure( exp, "stg_exact_hit", size, [&]() {
+        for ( auto i = 0u; i < size; ++i )
+        {
+          synth( circ, qubit_map, functions[i % misses] );
+        }
+      } );
+    }
+
+    /* Reed-Muller transforms of random functions with log2(size) variables, word-parallel and kitty */
+    {
+      const auto num_vars = 31u - static_cast<uint32_t>( __builtin_clz( size ) );
+      std::vector<kitty::dynamic_truth_table> functions( 16u, kitty::dynamic_truth_table( num_vars ) );
+      for ( auto i = 0u; i < functions.size(); ++i )
+      {
+        kitty::create_random( functions[i], size + i );
+      }
+
+      measure( exp, "pprm_kitty", size, [&]() {
+        for ( auto const& tt : functions )
+        {
+          kitty::esop_from_pprm( tt );
+        }
+      } );
+      measure( exp, "pprm_words", size, [&]() {
+        for ( auto const& tt : functions )
+        {
+          pprm_cubes( tt );
+        }
+      } );
+      if ( num_vars <= 12u )
+      {
+        measure( exp, "pkrm_kitty", size, [&]() {
+          for ( auto const& tt : functions )
+          {
+            kitty::esop_from_optimum_pkrm( tt );
+          }
+        } );
+      }
+      if ( num_vars <= 16u )
+      {
+        measure( exp, "pkrm_words", size, [&]() {
+          for ( auto const& tt : functions )
+          {
+            optimum_pkrm_cubes( tt );
+          }
+        } );
+      }
+      if ( num_vars <= 14u )
+      {
+        measure( exp, "fprm_search", size, [&]() {
+          for ( auto const& tt : functions )
+          {
+            optimum_fprm_cubes( tt );
+          }
+        } );
+      }
+    }
+  }
+
+  exp.save();
+  exp.table();
+  exp.compare( {}, {}, {} );
+
+  return 0;
+}
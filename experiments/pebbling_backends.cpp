@@ -0,0 +1,127 @@
+/* caterpillar: C++ logic network library
+ * Copyright (C) 2018-2019  EPFL
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+  \file pebbling_backends.cpp
+  \brief Compares the SAT backends of the bsat pebbling solver
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <caterpillar/solvers/bsat_solver.hpp>
+#include <caterpillar/solvers/sat_backends.hpp>
+#include <caterpillar/solvers/solver_manager.hpp>
+#include <mockturtle/generators/arithmetic.hpp>
+#include <mockturtle/networks/xag.hpp>
+
+#include "experiments.hpp"
+
+using namespace caterpillar;
+
+static xag_network adder( uint32_t bitwidth )
+{
+  xag_network xag;
+  std::vector<xag_network::signal> a( bitwidth ), b( bitwidth );
+  std::generate( a.begin(), a.end(), [&]() { return xag.create_pi(); } );
+  std::generate( b.begin(), b.end(), [&]() { return xag.create_pi(); } );
+  auto carry = xag.get_constant( false );
+  carry_ripple_adder_inplace( xag, a, b, carry );
+  std::for_each( a.begin(), a.end(), [&]( auto f ) { xag.create_po( f ); } );
+  xag.create_po( carry );
+  return xag;
+}
+
+static xag_network multiplier( uint32_t bitwidth )
+{
+  xag_network xag;
+  std::vector<xag_network::signal> a( bitwidth ), b( bitwidth );
+  std::generate( a.begin(), a.end(), [&]() { return xag.create_pi(); } );
+  std::generate( b.begin(), b.end(), [&]() { return xag.create_pi(); } );
+  for ( auto const& f : carry_ripple_multiplier( xag, a, b ) )
+  {
+    xag.create_po( f );
+  }
+  return xag;
+}
+
+template<class Solver>
+static void run( experiments::experiment<std::string, std::string, uint32_t, uint32_t, uint32_t, float>& exp,
+                 std::string const& benchmark, std::string const& backend, xag_network const& xag )
+{
+  pebbling_mapping_strategy_params ps;
+  ps.pebble_limit = xag.num_gates() / 2u + 1u;
+  ps.increment_pebbles_on_failure = true;
+  ps.search_timeout = 60;
+
+  const auto start = std::chrono::high_resolution_clock::now();
+  const auto steps = pebble<bsat_pebble_solver<xag_network, Solver>>( xag, ps );
+  const auto time = std::chrono::duration<float>( std::chrono::high_resolution_clock::now() - start ).count();
+
+  uint32_t pebbles{0u}, peak{0u};
+  for ( auto const& [_, action] : steps )
+  {
+    if ( std::holds_alternative<compute_action>( action ) )
+    {
+      peak = std::max( peak, ++pebbles );
+    }
+    else if ( std::holds_alternative<uncompute_action>( action ) )
+    {
+      --pebbles;
+    }
+  }
+
+  exp( benchmark, backend, xag.num_gates(), peak, static_cast<uint32_t>( steps.size() ), time );
+}
+
+int main()
+{
+  experiments::experiment<std::string, std::string, uint32_t, uint32_t, uint32_t, float> exp( "pebbling_backends", "benchmark", "backend", "gates", "pebbles", "steps", "time" );
+
+  std::vector<std::pair<std::string, xag_network>> suite;
+  for ( auto bw = 2u; bw <= 4u; ++bw )
+  {
+    suite.emplace_back( fmt::format( "adder{}", bw ), adder( bw ) );
+  }
+  suite.emplace_back( "mult2", multiplier( 2u ) );
+
+  for ( auto const& [benchmark, xag] : suite )
+  {
+    fmt::print( "[i] processing {}\n", benchmark );
+    run<bsat_backend>( exp, benchmark, "bsat", xag );
+    run<bill_backend<bill::solvers::glucose_41>>( exp, benchmark, "glucose", xag );
+    run<glucose_simp_backend>( exp, benchmark, "glucose_simp", xag );
+    run<bill_backend<bill::solvers::ghack>>( exp, benchmark, "ghack", xag );
+    run<bill_backend<bill::solvers::maple>>( exp, benchmark, "maple", xag );
+  }
+
+  exp.save();
+  exp.table();
+
+  return 0;
+}
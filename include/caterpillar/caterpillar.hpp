@@ -32,16 +32,28 @@
 
 #pragma once
 
+#include "caterpillar/details/ancilla_pool.hpp"
+#include "caterpillar/details/compute_order.hpp"
+#include "caterpillar/details/node_classification.hpp"
+#include "caterpillar/details/peephole.hpp"
+#include "caterpillar/details/reed_muller.hpp"
+#include "caterpillar/details/output_groups.hpp"
+#include "caterpillar/details/resource_estimation.hpp"
+#include "caterpillar/details/synthesis_profile.hpp"
+#include "caterpillar/details/trace.hpp"
 #include "caterpillar/details/utils.hpp"
+#include "caterpillar/optimization/mc_optimization.hpp"
 #include "caterpillar/optimization/optimization_graph.hpp"
 #include "caterpillar/optimization/post_opt_esop.hpp"
 #include "caterpillar/solvers/bsat_solver.hpp"
+#include "caterpillar/solvers/sat_backends.hpp"
 #include "caterpillar/solvers/z3_solver.hpp"
 #include "caterpillar/solvers/z3_inplace_solver.hpp"
 #include "caterpillar/structures/stg_gate.hpp"
 #include "caterpillar/structures/abstract_network.hpp"
 #include "caterpillar/structures/pebbling_view.hpp"
 #include "caterpillar/synthesis/lhrs.hpp"
+#include "caterpillar/synthesis/parallel_lhrs.hpp"
 #include "caterpillar/synthesis/satbased_cnotrz.hpp"
 #include "caterpillar/synthesis/stg_to_mcx.hpp"
 #include "caterpillar/synthesis/strategies/action.hpp"
@@ -52,3 +64,5 @@
 #include "caterpillar/synthesis/strategies/pebbling_mapping_strategy.hpp"
 #include "caterpillar/synthesis/strategies/xag_mapping_strategy.hpp"
 #include "caterpillar/verification/circuit_to_logic_network.hpp"
+#include "caterpillar/verification/sat_equivalence_checking.hpp"
+#include "caterpillar/verification/simulate_circuit.hpp"
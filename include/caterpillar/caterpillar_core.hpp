@@ -0,0 +1,29 @@
+/*------------------------------------------------------------------------------
+| This file is distributed under the MIT License.
+| See accompanying file /LICENSE for details.
+*-----------------------------------------------------------------------------*/
+#pragma once
+
+/*!
+  \file caterpillar_core.hpp
+  \brief Explicit instantiations of the precompiled `caterpillar_core` library
+
+  The library instantiates the synthesis into `netlist<stg_gate>` (with the
+  default single-target gate synthesis), the generic mapping strategies, and
+  the XAG tracer for the XAG, AIG, MIG, and k-LUT networks of mockturtle.
+  This header includes the headers that define these templates, such that
+  the translation units in `src/` can instantiate them with the macros of
+  `details/core_templates.hpp`.  Targets that link against
+  `caterpillar_core` define `CATERPILLAR_CORE`, such that each of these
+  headers declares its instantiations `extern`, regardless of how it is
+  included.
+*/
+
+#include "synthesis/lhrs.hpp"
+#include "synthesis/strategies/bennett_mapping_strategy.hpp"
+#include "synthesis/strategies/best_fit_mapping_strategy.hpp"
+#include "synthesis/strategies/eager_mapping_strategy.hpp"
+#include "synthesis/strategies/mapping_strategy.hpp"
+#include "synthesis/xag_tracer.hpp"
+#include "structures/stg_gate.hpp"
+#include "details/core_templates.hpp"
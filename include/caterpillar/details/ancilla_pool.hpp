@@ -0,0 +1,202 @@
+/*------------------------------------------------------------------------------
+| This file is distributed under the MIT License.
+| See accompanying file /LICENSE for details.
+*-----------------------------------------------------------------------------*/
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace caterpillar
+{
+
+/*! \brief Order in which released ancillae are reused.
+ *
+ * - lifo: the most recently released ancilla (default, smallest number of
+ *   distinct qubits touched in a window, but serializes independent work),
+ * - fifo: the ancilla released the longest ago,
+ * - least_recently_busy: the ancilla that became ready the earliest, where
+ *   ready is the layer of its last gate as scheduled by the synthesis,
+ * - lowest_index: the ancilla with the smallest qubit index.
+ */
+enum class ancilla_policy
+{
+  lifo,
+  fifo,
+  least_recently_busy,
+  lowest_index
+};
+
+/*! \brief Pool of released ancillae that are handed out by a policy. */
+class ancilla_pool
+{
+public:
+  explicit ancilla_pool( ancilla_policy policy = ancilla_policy::lifo )
+      : policy( policy )
+  {
+  }
+
+  ancilla_policy get_policy() const
+  {
+    return policy;
+  }
+
+  bool empty() const
+  {
+    return size() == 0u;
+  }
+
+  uint32_t size() const
+  {
+    return static_cast<uint32_t>( is_heap_policy() ? heap.size() : queue.size() );
+  }
+
+  /*! \brief Returns qubit `q` to the pool; `ready` is the layer after which it is idle. */
+  void release( uint32_t q, uint32_t ready = 0u )
+  {
+    if ( is_heap_policy() )
+    {
+      heap.emplace_back( policy == ancilla_policy::least_recently_busy ? ready : 0u, q );
+      std::push_heap( heap.begin(), heap.end(), std::greater<>() );
+    }
+    else
+    {
+      queue.push_back( q );
+    }
+  }
+
+  /*! \brief Takes an ancilla out of the pool, which must not be empty. */
+  uint32_t acquire()
+  {
+    switch ( policy )
+    {
+    default:
+    case ancilla_policy::lifo:
+    {
+      const auto q = queue.back();
+      queue.pop_back();
+      return q;
+    }
+    case ancilla_policy::fifo:
+    {
+      const auto q = queue.front();
+      queue.pop_front();
+      return q;
+    }
+    case ancilla_policy::least_recently_busy:
+    case ancilla_policy::lowest_index:
+    {
+      std::pop_heap( heap.begin(), heap.end(), std::greater<>() );
+      const auto q = heap.back().second;
+      heap.pop_back();
+      return q;
+    }
+    }
+  }
+
+private:
+  bool is_heap_policy() const
+  {
+    return policy == ancilla_policy::least_recently_busy || policy == ancilla_policy::lowest_index;
+  }
+
+private:
+  ancilla_policy policy;
+
+  /* lifo and fifo */
+  std::deque<uint32_t> queue;
+
+  /* min-heap of (ready, qubit) */
+  std::vector<std::pair<uint32_t, uint32_t>> heap;
+};
+
+/*! \brief Stacks of the qubits that hold the value of each node.
+ *
+ * The entries of all stacks are linked lists in one shared vector, in which
+ * popped entries are reused, such that pushing does not allocate once the
+ * vector has reached the largest number of entries held at a time.
+ */
+class qubit_stacks
+{
+  static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+public:
+  /*! \brief Stack of one node. */
+  class reference
+  {
+  public:
+    reference( qubit_stacks& stacks, std::size_t index )
+        : stacks( stacks ), head( stacks.heads[index] )
+    {
+    }
+
+    bool empty() const
+    {
+      return head == none;
+    }
+
+    uint32_t top() const
+    {
+      assert( head != none );
+      return stacks.entries[head].qubit;
+    }
+
+    void push( uint32_t qubit )
+    {
+      auto e = stacks.free;
+      if ( e == none )
+      {
+        e = static_cast<uint32_t>( stacks.entries.size() );
+        stacks.entries.emplace_back();
+      }
+      else
+      {
+        stacks.free = stacks.entries[e].next;
+      }
+      stacks.entries[e] = {qubit, head};
+      head = e;
+    }
+
+    void pop()
+    {
+      assert( head != none );
+      const auto e = head;
+      head = stacks.entries[e].next;
+      stacks.entries[e].next = stacks.free;
+      stacks.free = e;
+    }
+
+  private:
+    qubit_stacks& stacks;
+    uint32_t& head;
+  };
+
+  void resize( std::size_t size )
+  {
+    heads.resize( size, none );
+  }
+
+  reference operator[]( std::size_t index )
+  {
+    return reference( *this, index );
+  }
+
+private:
+  struct entry
+  {
+    uint32_t qubit;
+    uint32_t next;
+  };
+
+  std::vector<uint32_t> heads;
+  std::vector<entry> entries;
+  uint32_t free{none};
+};
+
+} // namespace caterpillar
@@ -0,0 +1,161 @@
+/*------------------------------------------------------------------------------
+| This file is distributed under the MIT License.
+| See accompanying file /LICENSE for details.
+*-----------------------------------------------------------------------------*/
+#pragma once
+
+#include "output_groups.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include <mockturtle/traits.hpp>
+#include <mockturtle/utils/node_map.hpp>
+#include <mockturtle/views/topo_view.hpp>
+
+namespace caterpillar
+{
+
+/*! \brief Order in which mapping strategies compute the gates. */
+enum class compute_order
+{
+  /*! \brief Order of `mockturtle::topo_view`. */
+  topological,
+
+  /*! \brief Order of `ancilla_aware_order`. */
+  ancilla_aware
+};
+
+/*! \brief Topological order of the gates that keeps few values live
+ *
+ * Gates whose values are only freed once all outputs in their transitive
+ * fanout are computed stay live the longest if outputs with shared logic
+ * are computed far apart.  Therefore the outputs are scheduled by groups
+ * with disjoint transitive fanin, such that each group's gates can be freed
+ * before the next group starts.  A group that leaves fewer output values
+ * behind than it needs while being computed goes first.
+ *
+ * Each output is computed depth-first.  The fanins of a gate are visited by
+ * decreasing Sethi-Ullman label, i.e., the number of values that must be
+ * live to compute them on a tree; among equal labels, fanins with fewer
+ * fanouts go first, since shared values are likely kept by other gates.
+ *
+ * The runtime is linear in the size of the network, up to sorting the
+ * fanins of each gate and the groups.
+ */
+template<class LogicNetwork>
+std::vector<mockturtle::node<LogicNetwork>> ancilla_aware_order( LogicNetwork const& ntk )
+{
+  using node = mockturtle::node<LogicNetwork>;
+
+  mockturtle::node_map<uint32_t, LogicNetwork> label( ntk, 0u );
+  std::vector<node> fanins;
+  auto sorted_fanins = [&]( node const& n ) {
+    fanins.clear();
+    ntk.foreach_fanin( n, [&]( auto const& f ) {
+      const auto child = ntk.get_node( f );
+      if ( !ntk.is_constant( child ) && !ntk.is_pi( child ) && std::find( fanins.begin(), fanins.end(), child ) == fanins.end() )
+      {
+        fanins.push_back( child );
+      }
+    } );
+    std::stable_sort( fanins.begin(), fanins.end(), [&]( auto const& a, auto const& b ) {
+      return label[a] != label[b] ? label[a] > label[b] : ntk.fanout_size( a ) < ntk.fanout_size( b );
+    } );
+  };
+
+  mockturtle::topo_view<LogicNetwork> topo{ntk};
+  topo.foreach_node( [&]( auto const& n ) {
+    if ( ntk.is_constant( n ) || ntk.is_pi( n ) )
+    {
+      return;
+    }
+    sorted_fanins( n );
+    uint32_t value{1u};
+    for ( auto i = 0u; i < fanins.size(); ++i )
+    {
+      value = std::max( value, label[fanins[i]] + i );
+    }
+    label[n] = value;
+  } );
+
+  detail::output_groups<LogicNetwork> groups( ntk );
+  std::vector<uint32_t> group_order( groups.size() );
+  std::iota( group_order.begin(), group_order.end(), 0u );
+  auto residual = [&]( uint32_t g ) {
+    return static_cast<int64_t>( groups.gates_of( g ).size() ) - static_cast<int64_t>( groups.outputs_of( g ).size() );
+  };
+  std::stable_sort( group_order.begin(), group_order.end(), [&]( auto a, auto b ) {
+    return residual( a ) > residual( b );
+  } );
+
+  std::vector<node> order;
+  order.reserve( ntk.size() );
+  mockturtle::node_map<uint8_t, LogicNetwork> visited( ntk, 0u );
+  std::vector<std::pair<node, bool>> stack;
+  for ( auto g : group_order )
+  {
+    for ( auto i : groups.outputs_of( g ) )
+    {
+      stack.emplace_back( ntk.get_node( ntk.po_at( i ) ), false );
+      while ( !stack.empty() )
+      {
+        const auto [n, expanded] = stack.back();
+        stack.pop_back();
+        if ( ntk.is_constant( n ) || ntk.is_pi( n ) || visited[n] == 2u )
+        {
+          continue;
+        }
+        if ( expanded )
+        {
+          visited[n] = 2u;
+          order.push_back( n );
+          continue;
+        }
+        if ( visited[n] == 1u )
+        {
+          continue;
+        }
+
+        visited[n] = 1u;
+        stack.emplace_back( n, true );
+        sorted_fanins( n );
+        for ( auto it = fanins.rbegin(); it != fanins.rend(); ++it )
+        {
+          if ( !visited[*it] )
+          {
+            stack.emplace_back( *it, false );
+          }
+        }
+      }
+    }
+  }
+  return order;
+}
+
+/*! \brief Calls `fn` on each gate of `ntk` in `order`. */
+template<class LogicNetwork, class Fn>
+void foreach_gate_in_order( LogicNetwork const& ntk, compute_order order, Fn&& fn )
+{
+  if ( order == compute_order::ancilla_aware )
+  {
+    for ( auto const& n : ancilla_aware_order( ntk ) )
+    {
+      fn( n );
+    }
+    return;
+  }
+
+  mockturtle::topo_view<LogicNetwork> topo{ntk};
+  topo.foreach_node( [&]( auto const& n ) {
+    if ( !ntk.is_constant( n ) && !ntk.is_pi( n ) )
+    {
+      fn( n );
+    }
+  } );
+}
+
+} // namespace caterpillar
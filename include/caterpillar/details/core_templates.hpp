@@ -0,0 +1,78 @@
+/*------------------------------------------------------------------------------
+| This file is distributed under the MIT License.
+| See accompanying file /LICENSE for details.
+*-----------------------------------------------------------------------------*/
+#pragma once
+
+/*!
+  \file core_templates.hpp
+  \brief Template instantiations of the precompiled `caterpillar_core` library
+
+  Each macro lists the instantiations of the templates defined in one header
+  for one network type, where `EXTERN` is `extern` for declarations and empty
+  for definitions.  The headers that define the templates declare their
+  instantiations `extern` at their end if `CATERPILLAR_CORE` is defined, the
+  translation units of the library in `src/` define them.
+
+  This header does not include the headers that define the templates, the
+  macros must be expanded after their definitions.
+*/
+
+#include <mockturtle/networks/aig.hpp>
+#include <mockturtle/networks/klut.hpp>
+#include <mockturtle/networks/mig.hpp>
+#include <mockturtle/networks/xag.hpp>
+#include <tweedledum/algorithms/synthesis/stg.hpp>
+#include <tweedledum/networks/netlist.hpp>
+
+/* network types of the library */
+#define CATERPILLAR_CORE_FOREACH_NETWORK( TEMPLATES, EXTERN ) \
+  TEMPLATES( EXTERN, mockturtle::xag_network )                \
+  TEMPLATES( EXTERN, mockturtle::aig_network )                \
+  TEMPLATES( EXTERN, mockturtle::mig_network )                \
+  TEMPLATES( EXTERN, mockturtle::klut_network )
+
+/* the tracer requires a network with AND and XOR gates */
+#define CATERPILLAR_CORE_FOREACH_XAG_NETWORK( TEMPLATES, EXTERN ) \
+  TEMPLATES( EXTERN, mockturtle::xag_network )                    \
+  TEMPLATES( EXTERN, mockturtle::aig_network )                    \
+  TEMPLATES( EXTERN, mockturtle::mig_network )
+
+/* strategies/mapping_strategy.hpp */
+#define CATERPILLAR_CORE_MAPPING_STRATEGY_TEMPLATES( EXTERN, Ntk ) \
+  EXTERN template class caterpillar::mapping_strategy<Ntk>;
+
+/* strategies/bennett_mapping_strategy.hpp */
+#define CATERPILLAR_CORE_BENNETT_TEMPLATES( EXTERN, Ntk )                  \
+  EXTERN template class caterpillar::bennett_mapping_strategy<Ntk>;        \
+  EXTERN template class caterpillar::bennett_inplace_mapping_strategy<Ntk>;
+
+/* strategies/eager_mapping_strategy.hpp */
+#define CATERPILLAR_CORE_EAGER_TEMPLATES( EXTERN, Ntk ) \
+  EXTERN template class caterpillar::eager_mapping_strategy<Ntk>;
+
+/* strategies/best_fit_mapping_strategy.hpp */
+#define CATERPILLAR_CORE_BEST_FIT_TEMPLATES( EXTERN, Ntk ) \
+  EXTERN template class caterpillar::best_fit_mapping_strategy<Ntk>;
+
+/* lhrs.hpp */
+#define CATERPILLAR_CORE_LHRS_TEMPLATES( EXTERN, Ntk )                                                   \
+  EXTERN template bool caterpillar::logic_network_synthesis<tweedledum::netlist<caterpillar::stg_gate>, \
+                                                            Ntk, tweedledum::stg_from_pprm>(            \
+      tweedledum::netlist<caterpillar::stg_gate>&, Ntk const&, caterpillar::mapping_strategy<Ntk>&,     \
+      tweedledum::stg_from_pprm const&, caterpillar::logic_network_synthesis_params const&,            \
+      caterpillar::logic_network_synthesis_stats* );
+
+/* xag_tracer.hpp */
+#define CATERPILLAR_CORE_TRACER_TEMPLATES( EXTERN, Ntk )                                         \
+  EXTERN template bool caterpillar::xag_tracer<Ntk>( Ntk const&, caterpillar::mapping_strategy<Ntk>&, \
+                                                     caterpillar::xag_tracer_params const&,          \
+                                                     caterpillar::xag_tracer_stats* );
+
+/* all instantiations of the synthesis for one network type */
+#define CATERPILLAR_CORE_SYNTHESIS_TEMPLATES( EXTERN, Ntk )  \
+  CATERPILLAR_CORE_MAPPING_STRATEGY_TEMPLATES( EXTERN, Ntk ) \
+  CATERPILLAR_CORE_BENNETT_TEMPLATES( EXTERN, Ntk )          \
+  CATERPILLAR_CORE_EAGER_TEMPLATES( EXTERN, Ntk )            \
+  CATERPILLAR_CORE_BEST_FIT_TEMPLATES( EXTERN, Ntk )         \
+  CATERPILLAR_CORE_LHRS_TEMPLATES( EXTERN, Ntk )
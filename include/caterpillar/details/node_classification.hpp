@@ -0,0 +1,164 @@
+/*------------------------------------------------------------------------------
+| This file is distributed under the MIT License.
+| See accompanying file /LICENSE for details.
+*-----------------------------------------------------------------------------*/
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include <kitty/bit_operations.hpp>
+#include <kitty/constructors.hpp>
+#include <kitty/dynamic_truth_table.hpp>
+#include <kitty/hash.hpp>
+#include <kitty/operations.hpp>
+
+namespace caterpillar
+{
+
+/*! \brief Kind of gate that a node function is emitted as. */
+enum class gate_kind : uint8_t
+{
+  parity,
+  and_gate,
+  or_gate,
+  maj,
+  lut
+};
+
+/*! \brief Gate kind of a function and the polarities of its inputs.
+ *
+ * Bit i of `polarity` is set if input i is complemented:
+ *
+ * - and_gate: the function is the AND of the literals, which are
+ *   complemented where the only minterm has a 0,
+ * - or_gate: the function is the OR of the literals, which are complemented
+ *   where the only off-set minterm has a 1,
+ * - maj: the function is the majority of the literals.
+ */
+struct function_class
+{
+  gate_kind kind{gate_kind::lut};
+  uint32_t polarity{0u};
+};
+
+/*! \brief Classifies a function as parity, AND, OR, MAJ or generic LUT. */
+inline function_class classify_function( kitty::dynamic_truth_table const& tt )
+{
+  const auto num_vars = tt.num_vars();
+
+  auto parity = tt.construct();
+  kitty::create_parity( parity );
+  if ( tt == parity )
+  {
+    return {gate_kind::parity, 0u};
+  }
+
+  /* polarities of up to 32 inputs fit into `function_class::polarity` */
+  if ( num_vars >= 2u && num_vars <= 32u )
+  {
+    const auto mask = static_cast<uint32_t>( ( uint64_t( 1 ) << num_vars ) - 1u );
+    const auto ones = kitty::count_ones( tt );
+    if ( ones == 1u )
+    {
+      return {gate_kind::and_gate, ~static_cast<uint32_t>( kitty::find_first_one_bit( tt ) ) & mask};
+    }
+    if ( ones + 1u == tt.num_bits() )
+    {
+      return {gate_kind::or_gate, static_cast<uint32_t>( kitty::find_first_one_bit( ~tt ) )};
+    }
+  }
+
+  if ( num_vars == 3u )
+  {
+    auto maj = tt.construct();
+    kitty::create_majority( maj );
+    for ( auto p = 0u; p < 8u; ++p )
+    {
+      auto f = maj;
+      for ( auto i = 0u; i < 3u; ++i )
+      {
+        if ( ( p >> i ) & 1u )
+        {
+          kitty::flip_inplace( f, i );
+        }
+      }
+      if ( f == tt )
+      {
+        return {gate_kind::maj, p};
+      }
+    }
+  }
+
+  return {gate_kind::lut, 0u};
+}
+
+/*! \brief Per-node cache of node functions and their classification
+ *
+ * Each node is classified on first use.  Equal functions share one entry,
+ * found by hashing the truth table, such that `node_function` and the
+ * classification are computed once per node and once per function,
+ * respectively.
+ */
+template<class LogicNetwork>
+class node_classification
+{
+public:
+  struct entry
+  {
+    kitty::dynamic_truth_table function;
+    function_class cls;
+  };
+
+  explicit node_classification( LogicNetwork const& ntk )
+      : ntk( ntk )
+  {
+  }
+
+  entry const& operator[]( typename LogicNetwork::node const& n )
+  {
+    const auto index = ntk.node_to_index( n );
+    if ( index >= function_ids.size() )
+    {
+      function_ids.resize( ntk.size(), unknown );
+    }
+
+    auto& id = function_ids[index];
+    if ( id == unknown )
+    {
+      auto tt = ntk.node_function( n );
+      const auto it = ids.find( tt );
+      if ( it != ids.end() )
+      {
+        id = it->second;
+      }
+      else
+      {
+        id = static_cast<uint32_t>( entries.size() );
+        const auto cls = classify_function( tt );
+        ids.emplace( tt, id );
+        entries.push_back( {std::move( tt ), cls} );
+      }
+    }
+    return entries[id];
+  }
+
+  /*! \brief Number of distinct functions seen so far. */
+  uint32_t num_functions() const
+  {
+    return static_cast<uint32_t>( entries.size() );
+  }
+
+private:
+  static constexpr uint32_t unknown = std::numeric_limits<uint32_t>::max();
+
+  LogicNetwork const& ntk;
+  std::vector<uint32_t> function_ids;
+  std::vector<entry> entries;
+  std::unordered_map<kitty::dynamic_truth_table, uint32_t, kitty::hash<kitty::dynamic_truth_table>> ids;
+};
+
+} // namespace caterpillar
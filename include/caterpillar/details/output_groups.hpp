@@ -0,0 +1,347 @@
+/*------------------------------------------------------------------------------
+| This file is distributed under the MIT License.
+| See accompanying file /LICENSE for details.
+*-----------------------------------------------------------------------------*/
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <mockturtle/traits.hpp>
+#include <mockturtle/utils/node_map.hpp>
+
+namespace caterpillar
+{
+
+namespace detail
+{
+
+/*! \brief Hash of canonical structural signatures. */
+struct signature_hash
+{
+  std::size_t operator()( std::vector<uint64_t> const& signature ) const
+  {
+    uint64_t h = signature.size();
+    for ( auto w : signature )
+    {
+      h ^= w + 0x9e3779b97f4a7c15 + ( h << 6 ) + ( h >> 2 );
+    }
+    return static_cast<std::size_t>( h );
+  }
+};
+
+/*! \brief Partitions the outputs into groups with disjoint transitive fanin.
+ *
+ * Outputs driven by a primary input or a constant are collected in a last
+ * group, such that output inverters on input qubits are applied after all
+ * other groups read them.
+ */
+template<class LogicNetwork>
+class output_groups
+{
+public:
+  using node = mockturtle::node<LogicNetwork>;
+
+  /*! \brief Structure of a group up to renaming its inputs and gates
+   *
+   * Two groups with equal signatures are isomorphic: their gates, visited
+   * depth-first from the outputs, have the same functions and fanins, and
+   * their outputs are driven by corresponding signals.
+   */
+  struct canonical_form
+  {
+    std::vector<uint64_t> signature;
+
+    /* positions of the primary inputs in the order of first use */
+    std::vector<uint32_t> inputs;
+
+    /* gates in the order of the depth-first traversal */
+    std::vector<node> gates;
+  };
+
+  explicit output_groups( LogicNetwork const& ntk )
+      : ntk( ntk ), parent( ntk.num_pos() ), owner( ntk, ntk.num_pos() ), pi_position( ntk )
+  {
+    std::iota( parent.begin(), parent.end(), 0u );
+    ntk.foreach_pi( [&]( auto const& n, auto i ) {
+      pi_position[n] = i;
+    } );
+
+    std::vector<node> stack;
+    std::vector<uint32_t> port_outputs;
+    ntk.foreach_po( [&]( auto const& f, auto i ) {
+      const auto root = ntk.get_node( f );
+      if ( ntk.is_pi( root ) || ntk.is_constant( root ) )
+      {
+        port_outputs.push_back( i );
+        return;
+      }
+
+      stack.push_back( root );
+      while ( !stack.empty() )
+      {
+        const auto n = stack.back();
+        stack.pop_back();
+        if ( ntk.is_pi( n ) || ntk.is_constant( n ) )
+        {
+          continue;
+        }
+        if ( owner[n] != ntk.num_pos() )
+        {
+          unite( owner[n], i );
+          continue;
+        }
+        owner[n] = i;
+        ntk.foreach_fanin( n, [&]( auto const& g ) {
+          stack.push_back( ntk.get_node( g ) );
+        } );
+      }
+    } );
+
+    /* number the groups in the order of their first output */
+    std::vector<uint32_t> group_of_root( ntk.num_pos(), ntk.num_pos() );
+    ntk.foreach_po( [&]( auto const&, auto i ) {
+      if ( std::find( port_outputs.begin(), port_outputs.end(), i ) != port_outputs.end() )
+      {
+        return;
+      }
+      auto& g = group_of_root[find( i )];
+      if ( g == ntk.num_pos() )
+      {
+        g = static_cast<uint32_t>( outputs.size() );
+        outputs.emplace_back();
+        gates.emplace_back();
+      }
+      outputs[g].push_back( i );
+    } );
+
+    ntk.foreach_gate( [&]( auto const& n ) {
+      if ( owner[n] != ntk.num_pos() )
+      {
+        gates[group_of_root[find( owner[n] )]].push_back( n );
+      }
+    } );
+
+    if ( !port_outputs.empty() )
+    {
+      outputs.push_back( port_outputs );
+      gates.emplace_back();
+    }
+  }
+
+  uint32_t size() const
+  {
+    return static_cast<uint32_t>( outputs.size() );
+  }
+
+  /*! \brief Indexes of the primary outputs in group `g`. */
+  std::vector<uint32_t> const& outputs_of( uint32_t g ) const
+  {
+    return outputs[g];
+  }
+
+  /*! \brief Gates of group `g` in topological order. */
+  std::vector<node> const& gates_of( uint32_t g ) const
+  {
+    return gates[g];
+  }
+
+  /*! \brief Canonical form of group `g`. */
+  canonical_form canonicalize( uint32_t g ) const
+  {
+    enum : uint64_t
+    {
+      input_tag = 1,
+      gate_tag = 2,
+      output_tag = 3
+    };
+
+    canonical_form form;
+    std::unordered_map<uint64_t, uint64_t> ids;
+    uint64_t next_id{2u}; /* 0 and 1 are the constants */
+
+    auto ref = [&]( auto const& f ) {
+      return ids.at( ntk.node_to_index( ntk.get_node( f ) ) ) << 1 | ( ntk.is_complemented( f ) ? 1u : 0u );
+    };
+
+    std::vector<std::pair<node, bool>> stack;
+    std::vector<node> fanins;
+    for ( auto i : outputs[g] )
+    {
+      stack.emplace_back( ntk.get_node( ntk.po_at( i ) ), false );
+      while ( !stack.empty() )
+      {
+        const auto [n, expanded] = stack.back();
+        stack.pop_back();
+
+        const auto index = ntk.node_to_index( n );
+        if ( ids.count( index ) )
+        {
+          continue;
+        }
+        if ( ntk.is_constant( n ) )
+        {
+          ids[index] = ntk.constant_value( n ) ? 1u : 0u;
+          continue;
+        }
+        if ( ntk.is_pi( n ) )
+        {
+          ids[index] = next_id++;
+          form.inputs.push_back( pi_position[n] );
+          form.signature.push_back( input_tag );
+          continue;
+        }
+
+        if ( !expanded )
+        {
+          /* visit the fanins first, in their order */
+          stack.emplace_back( n, true );
+          fanins.clear();
+          ntk.foreach_fanin( n, [&]( auto const& f ) {
+            fanins.push_back( ntk.get_node( f ) );
+          } );
+          for ( auto it = fanins.rbegin(); it != fanins.rend(); ++it )
+          {
+            stack.emplace_back( *it, false );
+          }
+          continue;
+        }
+
+        ids[index] = next_id++;
+        form.gates.push_back( n );
+        form.signature.push_back( gate_tag | uint64_t( ntk.fanin_size( n ) ) << 8 );
+        ntk.foreach_fanin( n, [&]( auto const& f ) {
+          form.signature.push_back( ref( f ) );
+        } );
+        const auto function = ntk.node_function( n );
+        form.signature.insert( form.signature.end(), function.cbegin(), function.cend() );
+      }
+    }
+
+    for ( auto i : outputs[g] )
+    {
+      form.signature.push_back( output_tag );
+      form.signature.push_back( ref( ntk.po_at( i ) ) );
+    }
+    return form;
+  }
+
+  /*! \brief Copies group `g` into a network with the inputs of its canonical form.
+   *
+   * The network's primary inputs are `form.inputs`, its gates are created in
+   * the order of `form.gates`, such that isomorphic groups are copied into
+   * equal networks.
+   */
+  LogicNetwork extract( uint32_t g, canonical_form const& form ) const
+  {
+    using signal = mockturtle::signal<LogicNetwork>;
+
+    LogicNetwork sub;
+    mockturtle::node_map<signal, LogicNetwork> old_to_new( ntk );
+    old_to_new[ntk.get_constant( false )] = sub.get_constant( false );
+    if ( ntk.get_node( ntk.get_constant( true ) ) != ntk.get_node( ntk.get_constant( false ) ) )
+    {
+      old_to_new[ntk.get_constant( true )] = sub.get_constant( true );
+    }
+    for ( auto i : form.inputs )
+    {
+      old_to_new[ntk.pi_at( i )] = sub.create_pi();
+    }
+
+    auto to_new = [&]( auto const& f ) {
+      const auto s = old_to_new[ntk.get_node( f )];
+      return ntk.is_complemented( f ) ? sub.create_not( s ) : s;
+    };
+
+    std::vector<signal> children;
+    for ( auto const& n : form.gates )
+    {
+      children.clear();
+      ntk.foreach_fanin( n, [&]( auto const& f ) {
+        children.push_back( to_new( f ) );
+      } );
+      old_to_new[n] = sub.clone_node( ntk, n, children );
+    }
+
+    for ( auto i : outputs[g] )
+    {
+      sub.create_po( to_new( ntk.po_at( i ) ) );
+    }
+    return sub;
+  }
+
+  /*! \brief Copies group `g` into a network with all primary inputs of `ntk`. */
+  LogicNetwork extract( uint32_t g ) const
+  {
+    using signal = mockturtle::signal<LogicNetwork>;
+
+    LogicNetwork sub;
+    mockturtle::node_map<signal, LogicNetwork> old_to_new( ntk );
+    old_to_new[ntk.get_constant( false )] = sub.get_constant( false );
+    if ( ntk.get_node( ntk.get_constant( true ) ) != ntk.get_node( ntk.get_constant( false ) ) )
+    {
+      old_to_new[ntk.get_constant( true )] = sub.get_constant( true );
+    }
+    ntk.foreach_pi( [&]( auto const& n ) {
+      old_to_new[n] = sub.create_pi();
+    } );
+
+    auto to_new = [&]( auto const& f ) {
+      const auto s = old_to_new[ntk.get_node( f )];
+      return ntk.is_complemented( f ) ? sub.create_not( s ) : s;
+    };
+
+    std::vector<signal> children;
+    for ( auto const& n : gates[g] )
+    {
+      children.clear();
+      ntk.foreach_fanin( n, [&]( auto const& f ) {
+        children.push_back( to_new( f ) );
+      } );
+      old_to_new[n] = sub.clone_node( ntk, n, children );
+    }
+
+    for ( auto i : outputs[g] )
+    {
+      sub.create_po( to_new( ntk.po_at( i ) ) );
+    }
+    return sub;
+  }
+
+private:
+  uint32_t find( uint32_t i )
+  {
+    while ( parent[i] != i )
+    {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  }
+
+  void unite( uint32_t i, uint32_t j )
+  {
+    i = find( i );
+    j = find( j );
+    if ( i != j )
+    {
+      parent[std::max( i, j )] = std::min( i, j );
+    }
+  }
+
+private:
+  LogicNetwork const& ntk;
+  std::vector<uint32_t> parent;
+  mockturtle::node_map<uint32_t, LogicNetwork> owner;
+  mockturtle::node_map<uint32_t, LogicNetwork> pi_position;
+  std::vector<std::vector<uint32_t>> outputs;
+  std::vector<std::vector<node>> gates;
+};
+
+} // namespace detail
+
+} // namespace caterpillar
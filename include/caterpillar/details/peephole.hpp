@@ -0,0 +1,346 @@
+/*------------------------------------------------------------------------------
+| This file is distributed under the MIT License.
+| See accompanying file /LICENSE for details.
+*-----------------------------------------------------------------------------*/
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <tweedledum/gates/gate_base.hpp>
+#include <tweedledum/gates/gate_set.hpp>
+#include <tweedledum/networks/qubit.hpp>
+
+namespace caterpillar
+{
+
+/*! \brief Streaming peephole optimizer for X, CNOT and Toffoli gates
+ *
+ * Gates are held back in a window of pending gates before they are added to
+ * `qnet`.  A new gate
+ *
+ * - cancels against an identical pending gate, if all gates in between
+ *   commute with it (they act on other qubits, or only share its target, or
+ *   only share its controls), and
+ * - if it is an X gate on qubit q, merges with a pending X gate on q into the
+ *   polarity of the controls on q of all gates in between, if none of them
+ *   targets q.
+ *
+ * Each gate is compared against at most `max_candidates` pending gates with
+ * the same target, such that the optimizer runs in linear time.  The oldest
+ * half of the window is added to `qnet` when the window is full; `flush`
+ * adds all pending gates.  Gates other than single-target X gates with at
+ * most `max_controls` controls flush the window and are added directly.
+ */
+template<class QuantumNetwork>
+class peephole_buffer
+{
+public:
+  static constexpr uint32_t max_controls = 4u;
+  static constexpr uint32_t max_candidates = 8u;
+
+  explicit peephole_buffer( QuantumNetwork& qnet, uint32_t window = 512u )
+      : qnet( qnet ), window( std::max( window, 1u ) )
+  {
+  }
+
+  void add_gate( tweedledum::gate_base op, tweedledum::qubit_id t )
+  {
+    if ( !op.is( tweedledum::gate_set::pauli_x ) )
+    {
+      flush();
+      qnet.add_gate( op, t );
+      return;
+    }
+    entry e{op, t, 0u};
+    insert( e );
+  }
+
+  void add_gate( tweedledum::gate_base op, tweedledum::qubit_id c, tweedledum::qubit_id t )
+  {
+    if ( !op.is( tweedledum::gate_set::cx ) )
+    {
+      flush();
+      qnet.add_gate( op, c, t );
+      return;
+    }
+    entry e{op, t, 1u};
+    e.controls[0] = c.literal();
+    insert( e );
+  }
+
+  void add_gate( tweedledum::gate_base op, std::vector<tweedledum::qubit_id> const& controls,
+                 std::vector<tweedledum::qubit_id> const& targets )
+  {
+    const auto is_x_type = op.is( tweedledum::gate_set::pauli_x ) || op.is( tweedledum::gate_set::cx ) || op.is( tweedledum::gate_set::mcx );
+    if ( !is_x_type || targets.size() != 1u || controls.size() > max_controls )
+    {
+      flush();
+      qnet.add_gate( op, controls, targets );
+      return;
+    }
+    entry e{op, targets[0], static_cast<uint32_t>( controls.size() )};
+    for ( auto i = 0u; i < controls.size(); ++i )
+    {
+      e.controls[i] = controls[i].literal();
+    }
+    insert( e );
+  }
+
+  /*! \brief Adds all pending gates to the network. */
+  void flush()
+  {
+    emit_prefix( pending.size() );
+  }
+
+  /*! \brief Number of gates removed as inverse pairs. */
+  uint64_t num_cancelled() const
+  {
+    return cancelled;
+  }
+
+  /*! \brief Number of X gates merged into control polarities. */
+  uint64_t num_merged() const
+  {
+    return merged;
+  }
+
+  /*! \brief Number of gates that were not added to the network. */
+  uint64_t num_removed() const
+  {
+    return cancelled + merged;
+  }
+
+private:
+  static constexpr uint64_t none = std::numeric_limits<uint64_t>::max();
+
+  struct entry
+  {
+    tweedledum::gate_base op;
+    tweedledum::qubit_id target;
+    uint32_t num_controls{0u};
+    std::array<uint32_t, max_controls> controls{};
+    bool alive{true};
+  };
+
+  struct qubit_state
+  {
+    /* last pending gate that targets the qubit */
+    uint64_t last_target{none};
+
+    /* pending gates that target the qubit since it was last used as control */
+    std::vector<uint64_t> targets;
+
+    /* pending X gate on the qubit and the gates controlled by the qubit since */
+    uint64_t open_x{none};
+    std::vector<uint64_t> x_users;
+  };
+
+  void insert( entry& e )
+  {
+    /* controls are kept as sorted literals, such that equal gates compare equal */
+    std::sort( e.controls.begin(), e.controls.begin() + e.num_controls );
+
+    /* resize once, such that references to qubit states stay valid */
+    auto max_qubit = e.target.index();
+    for ( auto i = 0u; i < e.num_controls; ++i )
+    {
+      max_qubit = std::max( max_qubit, e.controls[i] >> 1 );
+    }
+    state( max_qubit );
+
+    auto& ts = state( e.target );
+    if ( cancel( ts, e ) || merge( ts, e ) )
+    {
+      return;
+    }
+
+    const auto idx = first + pending.size();
+    pending.push_back( e );
+
+    for ( auto i = 0u; i < e.num_controls; ++i )
+    {
+      auto& cs = state( ( e.controls[i] >> 1 ) );
+      cs.targets.clear();
+      if ( cs.open_x != none )
+      {
+        if ( cs.open_x < first )
+        {
+          cs.open_x = none;
+          cs.x_users.clear();
+        }
+        else
+        {
+          cs.x_users.push_back( idx );
+        }
+      }
+    }
+
+    ts.last_target = idx;
+    if ( ts.targets.size() >= 4u * max_candidates )
+    {
+      ts.targets.erase( ts.targets.begin(), ts.targets.end() - max_candidates );
+    }
+    ts.targets.push_back( idx );
+    ts.open_x = e.num_controls == 0u ? idx : none;
+    ts.x_users.clear();
+
+    if ( pending.size() >= 2u * window )
+    {
+      emit_prefix( window );
+    }
+  }
+
+  /* removes a pending gate equal to e that e commutes to */
+  bool cancel( qubit_state& ts, entry const& e )
+  {
+    auto k = 0u;
+    for ( auto it = ts.targets.rbegin(); it != ts.targets.rend() && k < max_candidates; ++it, ++k )
+    {
+      if ( !is_live( *it ) )
+      {
+        continue;
+      }
+      auto& h = at( *it );
+      if ( !equal( h, e ) || is_blocked( *it, e ) )
+      {
+        continue;
+      }
+
+      h.alive = false;
+      ts.targets.erase( std::next( it ).base() );
+      cancelled += 2u;
+      return true;
+    }
+    return false;
+  }
+
+  /* turns X q ... X q into negated controls on q in between */
+  bool merge( qubit_state& ts, entry const& e )
+  {
+    if ( e.num_controls != 0u || ts.open_x == none || !is_live( ts.open_x ) || ts.last_target != ts.open_x )
+    {
+      return false;
+    }
+    for ( auto u : ts.x_users )
+    {
+      if ( u < first )
+      {
+        return false;
+      }
+    }
+
+    const auto q = e.target.index();
+    for ( auto u : ts.x_users )
+    {
+      auto& g = at( u );
+      for ( auto i = 0u; i < g.num_controls; ++i )
+      {
+        if ( ( g.controls[i] >> 1 ) == q )
+        {
+          g.controls[i] ^= 1u;
+        }
+      }
+    }
+    at( ts.open_x ).alive = false;
+    ts.open_x = none;
+    ts.x_users.clear();
+    merged += 2u;
+    return true;
+  }
+
+  /* whether a gate between h and e targets one of e's controls */
+  bool is_blocked( uint64_t h, entry const& e )
+  {
+    for ( auto i = 0u; i < e.num_controls; ++i )
+    {
+      const auto last = state( ( e.controls[i] >> 1 ) ).last_target;
+      if ( last != none && last > h )
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static bool equal( entry const& a, entry const& b )
+  {
+    return a.target == b.target && a.num_controls == b.num_controls &&
+           std::equal( a.controls.begin(), a.controls.begin() + a.num_controls, b.controls.begin() );
+  }
+
+  static tweedledum::qubit_id to_qubit( uint32_t literal )
+  {
+    return tweedledum::qubit_id( literal >> 1, ( literal & 1u ) == 1u );
+  }
+
+  bool is_live( uint64_t idx ) const
+  {
+    return idx >= first && pending[idx - first].alive;
+  }
+
+  entry& at( uint64_t idx )
+  {
+    return pending[idx - first];
+  }
+
+  qubit_state& state( uint32_t q )
+  {
+    if ( q >= qubits.size() )
+    {
+      qubits.resize( q + 1u );
+    }
+    return qubits[q];
+  }
+
+  void emit_prefix( std::size_t n )
+  {
+    for ( auto i = 0u; i < n; ++i )
+    {
+      auto const& e = pending[i];
+      if ( !e.alive )
+      {
+        continue;
+      }
+      if ( e.op.is( tweedledum::gate_set::pauli_x ) )
+      {
+        qnet.add_gate( e.op, e.target );
+      }
+      else if ( e.op.is( tweedledum::gate_set::cx ) )
+      {
+        qnet.add_gate( e.op, to_qubit( e.controls[0] ), e.target );
+      }
+      else
+      {
+        controls_buffer.clear();
+        for ( auto j = 0u; j < e.num_controls; ++j )
+        {
+          controls_buffer.push_back( to_qubit( e.controls[j] ) );
+        }
+        target_buffer.assign( 1u, e.target );
+        qnet.add_gate( e.op, controls_buffer, target_buffer );
+      }
+    }
+    pending.erase( pending.begin(), pending.begin() + n );
+    first += n;
+  }
+
+private:
+  QuantumNetwork& qnet;
+  uint32_t window;
+
+  std::vector<entry> pending;
+  uint64_t first{0u};
+  std::vector<qubit_state> qubits;
+
+  std::vector<tweedledum::qubit_id> controls_buffer;
+  std::vector<tweedledum::qubit_id> target_buffer;
+
+  uint64_t cancelled{0u};
+  uint64_t merged{0u};
+};
+
+} // namespace caterpillar
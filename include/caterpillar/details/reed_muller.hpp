@@ -0,0 +1,532 @@
+/*------------------------------------------------------------------------------
+| This file is distributed under the MIT License.
+| See accompanying file /LICENSE for details.
+*-----------------------------------------------------------------------------*/
+#pragma once
+
+/*!
+  \file reed_muller.hpp
+  \brief Word-parallel Reed-Muller transforms of truth tables
+
+  The transforms work on the 64-bit words of a truth table: variables 0 to 5
+  are handled by shift-and-mask butterflies inside each word, the other
+  variables by XORing whole blocks.  The block loops have no dependencies
+  between iterations, such that the compiler vectorizes them.
+
+  The coefficients of the fixed-polarity Reed-Muller (FPRM) form with
+  polarity p are the positive-polarity (PPRM) coefficients of f(x ^ p).
+  Bit i of p is set, if variable i appears as negative literal.
+
+  The optimum pseudo-Kronecker (PKRM) search works on sub-tables that are
+  contiguous halves of the truth table, instead of cofactors of full size.
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <kitty/cube.hpp>
+#include <kitty/esop.hpp>
+#include <kitty/hash.hpp>
+#include <kitty/operations.hpp>
+
+namespace caterpillar
+{
+
+namespace detail
+{
+
+/* positions of the minterms in a word where variable i is 1 */
+constexpr uint64_t rm_var_masks[] = {
+    0xaaaaaaaaaaaaaaaa, 0xcccccccccccccccc, 0xf0f0f0f0f0f0f0f0,
+    0xff00ff00ff00ff00, 0xffff0000ffff0000, 0xffffffff00000000};
+
+template<class TT>
+uint64_t count_ones_bounded( TT const& tt, uint64_t bound )
+{
+  uint64_t count{0u};
+  for ( auto it = tt.cbegin(); it != tt.cend() && count < bound; ++it )
+  {
+    count += __builtin_popcountll( *it );
+  }
+  return count;
+}
+
+/* optimum PKRM expansions following [R. Drechsler, IEEE Trans. C 48(9), 1999]
+ *
+ * The variables of the truth table are reversed, such that expanding the
+ * highest variable of a sub-table splits it into its lower and upper half.
+ * Sub-tables with up to 6 variables are single words.  Expansions are
+ * cached per number of variables. */
+class pkrm_search
+{
+public:
+  template<class TT>
+  explicit pkrm_search( TT const& tt )
+      : num_vars( tt.num_vars() ),
+        small( std::min( num_vars, 6u ) + 1u ),
+        large( num_vars + 1u )
+  {
+    auto reversed = tt;
+    for ( auto i = 0u; i < num_vars / 2u; ++i )
+    {
+      kitty::swap_inplace( reversed, i, num_vars - 1u - i );
+    }
+    words.assign( reversed.cbegin(), reversed.cend() );
+  }
+
+  std::vector<kitty::cube> run()
+  {
+    std::unordered_set<kitty::cube, kitty::hash<kitty::cube>> cubes;
+    if ( num_vars <= 6u )
+    {
+      find_small( words[0], num_vars );
+      emit_small( cubes, words[0], num_vars, kitty::cube() );
+    }
+    else
+    {
+      find_large( words, num_vars );
+      emit_large( cubes, words, num_vars, kitty::cube() );
+    }
+    return std::vector<kitty::cube>( cubes.begin(), cubes.end() );
+  }
+
+private:
+  enum class decomposition : uint8_t
+  {
+    positive_davio,
+    negative_davio,
+    shannon
+  };
+
+  struct expansion
+  {
+    uint32_t cost;
+    decomposition decomp;
+  };
+
+  struct words_hash
+  {
+    std::size_t operator()( std::vector<uint64_t> const& ws ) const
+    {
+      std::size_t seed = ws.size();
+      for ( auto w : ws )
+      {
+        seed ^= std::hash<uint64_t>{}( w ) + 0x9e3779b97f4a7c15 + ( seed << 6 ) + ( seed >> 2 );
+      }
+      return seed;
+    }
+  };
+
+  static uint64_t mask( uint32_t k )
+  {
+    return k == 6u ? ~UINT64_C( 0 ) : ( ( UINT64_C( 1 ) << ( 1u << k ) ) - 1u );
+  }
+
+  /* drops the most expensive of the three sub-functions f0, f1, and f0 ^ f1;
+   * `kitty::detail::find_pkrm_expansions` pairs the cost of dropping f0 with
+   * the positive Davio expansion, which keeps f0 */
+  static expansion choose( uint32_t ex0, uint32_t ex1, uint32_t ex2 )
+  {
+    const auto ex_max = std::max( {ex0, ex1, ex2} );
+    if ( ex_max == ex1 )
+    {
+      return {ex0 + ex2, decomposition::positive_davio};
+    }
+    if ( ex_max == ex0 )
+    {
+      return {ex1 + ex2, decomposition::negative_davio};
+    }
+    return {ex0 + ex1, decomposition::shannon};
+  }
+
+  /* variable of the cube literal when expanding a sub-table with k variables */
+  uint32_t var_of( uint32_t k ) const
+  {
+    return num_vars - k;
+  }
+
+  uint32_t find_small( uint64_t w, uint32_t k )
+  {
+    if ( w == 0u )
+    {
+      return 0u;
+    }
+    if ( w == mask( k ) )
+    {
+      return 1u;
+    }
+    if ( const auto it = small[k].find( w ); it != small[k].end() )
+    {
+      return it->second.cost;
+    }
+
+    const auto half = 1u << ( k - 1u );
+    const auto w0 = w & mask( k - 1u );
+    const auto w1 = w >> half;
+    const auto ex = choose( find_small( w0, k - 1u ), find_small( w1, k - 1u ), find_small( w0 ^ w1, k - 1u ) );
+    small[k].emplace( w, ex );
+    return ex.cost;
+  }
+
+  uint32_t find_large( std::vector<uint64_t> const& ws, uint32_t k )
+  {
+    if ( std::all_of( ws.begin(), ws.end(), []( auto w ) { return w == 0u; } ) )
+    {
+      return 0u;
+    }
+    if ( std::all_of( ws.begin(), ws.end(), []( auto w ) { return w == ~UINT64_C( 0 ); } ) )
+    {
+      return 1u;
+    }
+    if ( const auto it = large[k].find( ws ); it != large[k].end() )
+    {
+      return it->second.cost;
+    }
+
+    expansion ex;
+    if ( k == 7u )
+    {
+      ex = choose( find_small( ws[0], 6u ), find_small( ws[1], 6u ), find_small( ws[0] ^ ws[1], 6u ) );
+    }
+    else
+    {
+      std::vector<uint64_t> w0, w1, w2;
+      split( ws, w0, w1, w2 );
+      ex = choose( find_large( w0, k - 1u ), find_large( w1, k - 1u ), find_large( w2, k - 1u ) );
+    }
+    large[k].emplace( ws, ex );
+    return ex.cost;
+  }
+
+  static void split( std::vector<uint64_t> const& ws, std::vector<uint64_t>& w0, std::vector<uint64_t>& w1, std::vector<uint64_t>& w2 )
+  {
+    const auto half = ws.size() / 2u;
+    w0.assign( ws.begin(), ws.begin() + half );
+    w1.assign( ws.begin() + half, ws.end() );
+    w2.resize( half );
+    for ( auto i = 0u; i < half; ++i )
+    {
+      w2[i] = w0[i] ^ w1[i];
+    }
+  }
+
+  /* same as `kitty::detail::add_to_cubes`, but looks up the 2n cubes at
+   * distance 1 instead of scanning all cubes */
+  template<class Cubes>
+  void add_to_cubes( Cubes& cubes, kitty::cube c ) const
+  {
+    while ( true )
+    {
+      if ( cubes.erase( c ) )
+      {
+        return;
+      }
+
+      auto merged = false;
+      for ( auto v = num_vars; v-- > 0u && !merged; )
+      {
+        auto without = c;
+        without.remove_literal( v );
+        for ( auto const& neighbor : {without, with_literal( without, v, false ), with_literal( without, v, true )} )
+        {
+          if ( neighbor == c )
+          {
+            continue;
+          }
+          if ( const auto it = cubes.find( neighbor ); it != cubes.end() )
+          {
+            cubes.erase( it );
+            c = c.merge( neighbor );
+            merged = true;
+            break;
+          }
+        }
+      }
+
+      if ( !merged )
+      {
+        cubes.insert( c );
+        return;
+      }
+    }
+  }
+
+  static kitty::cube with_literal( kitty::cube c, uint32_t var, bool polarity )
+  {
+    c.add_literal( var, polarity );
+    return c;
+  }
+
+  template<class Cubes, class Table, class Emit>
+  void emit( Cubes& cubes, decomposition decomp, uint32_t var, kitty::cube const& c, Table const& t0, Table const& t1, Table const& t2, Emit&& emit_child )
+  {
+    switch ( decomp )
+    {
+    case decomposition::positive_davio:
+      emit_child( cubes, t0, c );
+      emit_child( cubes, t2, with_literal( c, var, true ) );
+      break;
+    case decomposition::negative_davio:
+      emit_child( cubes, t1, c );
+      emit_child( cubes, t2, with_literal( c, var, false ) );
+      break;
+    case decomposition::shannon:
+      emit_child( cubes, t0, with_literal( c, var, false ) );
+      emit_child( cubes, t1, with_literal( c, var, true ) );
+      break;
+    }
+  }
+
+  template<class Cubes>
+  void emit_small( Cubes& cubes, uint64_t w, uint32_t k, kitty::cube const& c )
+  {
+    if ( w == 0u )
+    {
+      return;
+    }
+    if ( w == mask( k ) )
+    {
+      add_to_cubes( cubes, c );
+      return;
+    }
+
+    const auto w0 = w & mask( k - 1u );
+    const auto w1 = w >> ( 1u << ( k - 1u ) );
+    emit( cubes, small[k].at( w ).decomp, var_of( k ), c, w0, w1, w0 ^ w1, [&]( auto& cs, uint64_t child, kitty::cube const& cc ) {
+      emit_small( cs, child, k - 1u, cc );
+    } );
+  }
+
+  template<class Cubes>
+  void emit_large( Cubes& cubes, std::vector<uint64_t> const& ws, uint32_t k, kitty::cube const& c )
+  {
+    if ( std::all_of( ws.begin(), ws.end(), []( auto w ) { return w == 0u; } ) )
+    {
+      return;
+    }
+    if ( std::all_of( ws.begin(), ws.end(), []( auto w ) { return w == ~UINT64_C( 0 ); } ) )
+    {
+      add_to_cubes( cubes, c );
+      return;
+    }
+
+    const auto decomp = large[k].at( ws ).decomp;
+    if ( k == 7u )
+    {
+      emit( cubes, decomp, var_of( k ), c, ws[0], ws[1], ws[0] ^ ws[1], [&]( auto& cs, uint64_t child, kitty::cube const& cc ) {
+        emit_small( cs, child, 6u, cc );
+      } );
+      return;
+    }
+
+    std::vector<uint64_t> w0, w1, w2;
+    split( ws, w0, w1, w2 );
+    emit( cubes, decomp, var_of( k ), c, w0, w1, w2, [&]( auto& cs, std::vector<uint64_t> const& child, kitty::cube const& cc ) {
+      emit_large( cs, child, k - 1u, cc );
+    } );
+  }
+
+private:
+  uint32_t num_vars;
+  std::vector<uint64_t> words;
+  std::vector<std::unordered_map<uint64_t, expansion>> small;
+  std::vector<std::unordered_map<std::vector<uint64_t>, expansion, words_hash>> large;
+};
+
+} // namespace detail
+
+/*! \brief Replaces a truth table by its PPRM coefficients (Moebius transform). */
+template<class TT>
+void pprm_transform_inplace( TT& tt )
+{
+  const auto num_vars = tt.num_vars();
+  const auto num_words = static_cast<uint64_t>( tt.num_blocks() );
+  auto* words = &*tt.begin();
+
+  for ( auto i = 0u; i < 6u && i < num_vars; ++i )
+  {
+    const auto shift = 1u << i;
+    const auto mask = detail::rm_var_masks[i];
+    for ( auto w = 0u; w < num_words; ++w )
+    {
+      words[w] ^= ( words[w] << shift ) & mask;
+    }
+  }
+
+  for ( uint64_t step = 1u; step < num_words; step <<= 1 )
+  {
+    for ( uint64_t j = 0u; j < num_words; j += step << 1 )
+    {
+      auto* lo = words + j;
+      auto* hi = words + j + step;
+      for ( uint64_t k = 0u; k < step; ++k )
+      {
+        hi[k] ^= lo[k];
+      }
+    }
+  }
+
+  tt.mask_bits();
+}
+
+/*! \brief Changes the polarity of variable `var` in Reed-Muller coefficients.
+ *
+ * Substituting x_var by !x_var turns each term m containing x_var into
+ * m ^ (m without x_var), such that the transform is applied in the opposite
+ * direction of `pprm_transform_inplace`.
+ */
+template<class TT>
+void flip_rm_polarity_inplace( TT& coefficients, uint32_t var )
+{
+  const auto num_words = static_cast<uint64_t>( coefficients.num_blocks() );
+  auto* words = &*coefficients.begin();
+
+  if ( var < 6u )
+  {
+    const auto shift = 1u << var;
+    const auto mask = ~detail::rm_var_masks[var];
+    for ( auto w = 0u; w < num_words; ++w )
+    {
+      words[w] ^= ( words[w] >> shift ) & mask;
+    }
+    return;
+  }
+
+  const auto step = uint64_t( 1u ) << ( var - 6u );
+  for ( uint64_t j = 0u; j < num_words; j += step << 1 )
+  {
+    auto* lo = words + j;
+    auto* hi = words + j + step;
+    for ( uint64_t k = 0u; k < step; ++k )
+    {
+      lo[k] ^= hi[k];
+    }
+  }
+}
+
+/*! \brief FPRM coefficients of a function for `polarity`. */
+template<class TT>
+TT fprm_coefficients( TT const& tt, uint32_t polarity )
+{
+  auto coefficients = tt;
+  pprm_transform_inplace( coefficients );
+  for ( auto i = 0u; i < tt.num_vars(); ++i )
+  {
+    if ( ( polarity >> i ) & 1 )
+    {
+      flip_rm_polarity_inplace( coefficients, i );
+    }
+  }
+  return coefficients;
+}
+
+/*! \brief Polarity with the fewest FPRM terms
+ *
+ * For up to `max_exhaustive_vars` variables all polarities are visited in
+ * Gray-code order, such that each step flips one variable; counting the
+ * terms stops as soon as they exceed the best polarity.  For more variables,
+ * single variables are flipped as long as this reduces the number of terms.
+ */
+template<class TT>
+uint32_t optimum_fprm_polarity( TT const& tt, uint32_t max_exhaustive_vars = 16u )
+{
+  const auto num_vars = tt.num_vars();
+  auto coefficients = tt;
+  pprm_transform_inplace( coefficients );
+
+  uint64_t best = detail::count_ones_bounded( coefficients, UINT64_MAX );
+  uint32_t best_polarity{0u};
+
+  if ( num_vars <= max_exhaustive_vars )
+  {
+    uint32_t polarity{0u};
+    for ( uint64_t g = 1u; g < ( uint64_t( 1u ) << num_vars ); ++g )
+    {
+      const auto var = static_cast<uint32_t>( __builtin_ctzll( g ) );
+      flip_rm_polarity_inplace( coefficients, var );
+      polarity ^= 1u << var;
+
+      const auto count = detail::count_ones_bounded( coefficients, best );
+      if ( count < best )
+      {
+        best = count;
+        best_polarity = polarity;
+      }
+    }
+    return best_polarity;
+  }
+
+  auto improved = true;
+  while ( improved )
+  {
+    improved = false;
+    for ( auto var = 0u; var < num_vars; ++var )
+    {
+      flip_rm_polarity_inplace( coefficients, var );
+      const auto count = detail::count_ones_bounded( coefficients, best );
+      if ( count < best )
+      {
+        best = count;
+        best_polarity ^= 1u << var;
+        improved = true;
+      }
+      else
+      {
+        /* polarity flips of different variables commute, flipping twice restores */
+        flip_rm_polarity_inplace( coefficients, var );
+      }
+    }
+  }
+  return best_polarity;
+}
+
+/*! \brief ESOP of the FPRM form of a function for `polarity`. */
+template<class TT>
+std::vector<kitty::cube> fprm_cubes( TT const& tt, uint32_t polarity )
+{
+  const auto coefficients = fprm_coefficients( tt, polarity );
+
+  std::vector<kitty::cube> cubes;
+  uint64_t offset{0u};
+  for ( auto it = coefficients.cbegin(); it != coefficients.cend(); ++it, offset += 64u )
+  {
+    for ( auto word = *it; word; word &= word - 1u )
+    {
+      const auto term = static_cast<uint32_t>( offset + __builtin_ctzll( word ) );
+      cubes.emplace_back( term & ~polarity, term );
+    }
+  }
+  return cubes;
+}
+
+/*! \brief ESOP of the PPRM form of a function. */
+template<class TT>
+std::vector<kitty::cube> pprm_cubes( TT const& tt )
+{
+  return fprm_cubes( tt, 0u );
+}
+
+/*! \brief ESOP of the optimum PKRM form of a function.
+ *
+ * Follows `kitty::esop_from_optimum_pkrm`, including the merging of
+ * distance-1 cubes, but cofactors are halves of sub-tables and expansions
+ * are cached per number of variables.  Since every FPRM form is a PKRM form,
+ * the result never has more cubes than `optimum_fprm_cubes`.
+ */
+template<class TT>
+std::vector<kitty::cube> optimum_pkrm_cubes( TT const& tt )
+{
+  return detail::pkrm_search( tt ).run();
+}
+
+/*! \brief ESOP of the FPRM form with the fewest terms. */
+template<class TT>
+std::vector<kitty::cube> optimum_fprm_cubes( TT const& tt, uint32_t max_exhaustive_vars = 16u )
+{
+  return fprm_cubes( tt, optimum_fprm_polarity( tt, max_exhaustive_vars ) );
+}
+
+} // namespace caterpillar
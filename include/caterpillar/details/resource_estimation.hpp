@@ -0,0 +1,539 @@
+/*------------------------------------------------------------------------------
+| This file is distributed under the MIT License.
+| See accompanying file /LICENSE for details.
+*-----------------------------------------------------------------------------*/
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+#include <json.hpp>
+#include <tweedledum/gates/gate_base.hpp>
+#include <tweedledum/gates/gate_set.hpp>
+#include <tweedledum/networks/qubit.hpp>
+
+namespace caterpillar
+{
+
+#pragma region has_is_measurement
+template<class Gate, class = void>
+struct has_is_measurement : std::false_type
+{
+};
+
+template<class Gate>
+struct has_is_measurement<Gate, std::void_t<decltype( std::declval<Gate>().is_measurement() )>> : std::true_type
+{
+};
+
+template<class Gate>
+inline constexpr bool has_is_measurement_v = has_is_measurement<Gate>::value;
+#pragma endregion
+
+/*! \brief Cost models for multiple-controlled Toffoli gates with k controls. */
+enum class mcx_cost_model
+{
+  /*! Logical-AND: 4(k - 1) T gates to compute onto a clean target, no T
+   *  gates to uncompute (measurement-based).  An MCX is counted as
+   *  uncomputation if its controls hold the same values as the controls of
+   *  the last AND computed onto the same target. */
+  logical_and,
+  /*! Toffoli ladder with k - 2 clean ancillae: 2(k - 2) + 1 Toffoli gates. */
+  clean_ancilla,
+  /*! Barenco et al. with k - 2 dirty ancillae: 4(k - 2) Toffoli gates. */
+  dirty_ancilla,
+  /*! Ladder of 2(k - 2) relative-phase Toffoli gates (4 T gates each) and
+   *  one Toffoli gate, i.e., 8k - 9 T gates. */
+  relative_phase
+};
+
+struct resource_estimation_params
+{
+  /*! \brief Cost model for gates with two or more controls. */
+  mcx_cost_model cost_model{mcx_cost_model::logical_and};
+
+  /*! \brief Logical-AND with T-depth 1 (requires one helper qubit). */
+  bool use_tdepth1{false};
+};
+
+/*! \brief Resources of a quantum circuit.
+ *
+ * Time is measured in layers of an as-soon-as-possible schedule, where each
+ * gate occupies one layer.  A qubit is live from the first to the last layer
+ * in which it is used.
+ */
+struct resource_estimation_stats
+{
+  uint32_t num_qubits{0u};
+  uint64_t num_gates{0u};
+  uint64_t cnot_count{0u};
+  uint64_t t_count{0u};
+  uint32_t t_depth{0u};
+  uint32_t cnot_depth{0u};
+  uint32_t depth{0u};
+
+  /*! \brief Number of logical ANDs uncomputed by measurement. */
+  uint64_t num_measurements{0u};
+
+  /*! \brief Number of LUT gates, which are not included in the T and CNOT counts.
+   *
+   * Their cost depends on how the control function is synthesized, decompose
+   * them first (e.g., with `decompose_with_ands`) to cost them.
+   */
+  uint64_t num_uncosted_gates{0u};
+
+  /*! \brief Sum of the lifetimes of all qubits in layers. */
+  uint64_t qubit_time_volume{0u};
+
+  /*! \brief Maximum number of qubits that are live at the same time. */
+  uint32_t peak_live_qubits{0u};
+
+  /*! \brief Number of X, CX, MCX, and LUT gates indexed by number of controls. */
+  std::vector<uint64_t> gates_by_controls;
+
+  /*! \brief Number of T gates in each T layer.
+   *
+   * Exact for explicit T gates; T gates of decomposed MCX gates are
+   * distributed evenly over the T layers of the decomposition.
+   */
+  std::vector<uint64_t> t_layers;
+
+  /*! \brief Flat JSON object, e.g., for entries of `experiments::experiment`. */
+  nlohmann::json to_json() const
+  {
+    return {{"qubits", num_qubits},
+            {"gates", num_gates},
+            {"cnots", cnot_count},
+            {"t_count", t_count},
+            {"t_depth", t_depth},
+            {"cnot_depth", cnot_depth},
+            {"depth", depth},
+            {"measurements", num_measurements},
+            {"uncosted_gates", num_uncosted_gates},
+            {"qubit_time_volume", qubit_time_volume},
+            {"peak_live_qubits", peak_live_qubits},
+            {"gates_by_controls", gates_by_controls},
+            {"t_layers", t_layers}};
+  }
+
+  void report() const
+  {
+    std::cout << fmt::format( "[i] qubits            = {}\n", num_qubits );
+    std::cout << fmt::format( "[i] gates             = {}\n", num_gates );
+    std::cout << fmt::format( "[i] CNOTs             = {} (depth {})\n", cnot_count, cnot_depth );
+    std::cout << fmt::format( "[i] T-count           = {} (depth {})\n", t_count, t_depth );
+    std::cout << fmt::format( "[i] depth             = {}\n", depth );
+    if ( num_measurements )
+    {
+      std::cout << fmt::format( "[i] measurements      = {}\n", num_measurements );
+    }
+    if ( num_uncosted_gates )
+    {
+      std::cout << fmt::format( "[i] uncosted gates    = {}\n", num_uncosted_gates );
+    }
+    std::cout << fmt::format( "[i] qubit-time volume = {}\n", qubit_time_volume );
+    std::cout << fmt::format( "[i] peak live qubits  = {}\n", peak_live_qubits );
+    for ( auto k = 0u; k < gates_by_controls.size(); ++k )
+    {
+      if ( gates_by_controls[k] )
+      {
+        std::cout << fmt::format( "[i] {:>2}-control gates  = {}\n", k, gates_by_controls[k] );
+      }
+    }
+  }
+};
+
+/*! \brief Single-pass resource estimation.
+ *
+ * The estimator implements the gate interface of quantum networks
+ * (`add_qubit` and `add_gate`), such that it can be used as the target of a
+ * synthesis algorithm to estimate resources without storing the circuit
+ * (dry run), or be fed with the gates of an existing netlist, see
+ * `estimate_resources`.  Each gate is processed in constant time with
+ * respect to the circuit size.
+ *
+ * To pair the computation and uncomputation of logical ANDs, the value of
+ * each qubit under X, CNOT, and MCX gates is tracked as a hash, which is
+ * linear in the initial values of the qubits and in the computed ANDs.  A
+ * qubit that is first used as a control is an input with an unknown value,
+ * a qubit that is first used as a target is a clean ancilla.
+ */
+class resource_estimator
+{
+public:
+  explicit resource_estimator( resource_estimation_params const& ps = {} )
+      : ps( ps )
+  {
+  }
+
+  tweedledum::qubit_id add_qubit()
+  {
+    qubits.emplace_back();
+    return tweedledum::qubit_id( static_cast<uint32_t>( qubits.size() - 1u ) );
+  }
+
+  uint32_t num_qubits() const
+  {
+    return static_cast<uint32_t>( qubits.size() );
+  }
+
+  void add_gate( tweedledum::gate_base op, tweedledum::qubit_id target )
+  {
+    controls.clear();
+    targets.assign( 1u, target );
+    process( op );
+  }
+
+  void add_gate( tweedledum::gate_base op, tweedledum::qubit_id control, tweedledum::qubit_id target )
+  {
+    controls.assign( 1u, control );
+    targets.assign( 1u, target );
+    process( op );
+  }
+
+  void add_gate( tweedledum::gate_base op, std::vector<tweedledum::qubit_id> const& cs, std::vector<tweedledum::qubit_id> const& ts )
+  {
+    controls = cs;
+    targets = ts;
+    process( op );
+  }
+
+  template<class Gate>
+  void add_gate( Gate const& gate )
+  {
+    controls.clear();
+    targets.clear();
+    gate.foreach_control( [&]( auto const& c ) { controls.push_back( c ); } );
+    gate.foreach_target( [&]( auto const& t ) { targets.push_back( t ); } );
+    if constexpr ( has_is_measurement_v<Gate> )
+    {
+      if ( gate.is_measurement() )
+      {
+        process_measurement();
+        return;
+      }
+    }
+    process( gate );
+  }
+
+  /*! \brief Uncomputes a logical AND by measurement, see `decompose_with_ands`.
+   *
+   * Counted as a single gate without T gates.
+   */
+  void add_measurement_based_uncompute( tweedledum::qubit_id target, tweedledum::qubit_id a, tweedledum::qubit_id b )
+  {
+    controls = {a, b};
+    targets.assign( 1u, target );
+    process_measurement();
+  }
+
+  /*! \brief Computes the statistics of all gates added so far. */
+  resource_estimation_stats stats() const
+  {
+    auto st = st_;
+    st.num_qubits = num_qubits();
+
+    /* sweep over lifetime intervals */
+    std::vector<std::pair<uint32_t, int32_t>> events;
+    events.reserve( 2u * qubits.size() );
+    for ( auto const& q : qubits )
+    {
+      if ( q.last == 0u )
+      {
+        continue;
+      }
+      st.qubit_time_volume += q.last - q.first + 1u;
+      events.emplace_back( q.first, 1 );
+      events.emplace_back( q.last + 1u, -1 );
+    }
+    std::sort( events.begin(), events.end() );
+
+    int32_t live{0};
+    for ( auto const& [_, delta] : events )
+    {
+      live += delta;
+      st.peak_live_qubits = std::max( st.peak_live_qubits, static_cast<uint32_t>( live ) );
+    }
+
+    return st;
+  }
+
+private:
+  struct qubit_info
+  {
+    uint32_t level{0u};
+    uint32_t t_level{0u};
+    uint32_t cnot_level{0u};
+    uint32_t first{0u}; /* first layer in which qubit is used (1-based) */
+    uint32_t last{0u};  /* last layer in which qubit is used, 0 if unused */
+    uint64_t value{0u};   /* hash of the value of the qubit */
+    uint64_t and_key{0u}; /* hash of the last AND computed onto the qubit, 0 if none */
+  };
+
+  static uint64_t mix( uint64_t x )
+  {
+    x = ( x ^ ( x >> 30 ) ) * UINT64_C( 0xbf58476d1ce4e5b9 );
+    x = ( x ^ ( x >> 27 ) ) * UINT64_C( 0x94d049bb133111eb );
+    return x ^ ( x >> 31 );
+  }
+
+  uint64_t value_of( tweedledum::qubit_id q ) const
+  {
+    return qubits[q.index()].value ^ ( q.is_complemented() ? constant_one : 0u );
+  }
+
+  /* T-count and T-depth of an MCX with k controls */
+  std::pair<uint64_t, uint32_t> mcx_cost( uint32_t k ) const
+  {
+    if ( k < 2u )
+    {
+      return {0u, 0u};
+    }
+    switch ( ps.cost_model )
+    {
+    default:
+    case mcx_cost_model::logical_and:
+      return {4u * ( k - 1u ), ( ps.use_tdepth1 ? 1u : 2u ) * ( k - 1u )};
+    case mcx_cost_model::clean_ancilla:
+      return {7u * ( 2u * ( k - 2u ) + 1u ), 3u * ( 2u * ( k - 2u ) + 1u )};
+    case mcx_cost_model::dirty_ancilla:
+      return k == 2u ? std::pair<uint64_t, uint32_t>{7u, 3u} : std::pair<uint64_t, uint32_t>{28u * ( k - 2u ), 12u * ( k - 2u )};
+    case mcx_cost_model::relative_phase:
+      return {8u * k - 9u, 4u * ( k - 2u ) + 3u};
+    }
+  }
+
+  void add_t_gates( uint32_t from, uint32_t to, uint64_t count )
+  {
+    if ( to <= from || count == 0u )
+    {
+      return;
+    }
+    if ( st_.t_layers.size() < to )
+    {
+      st_.t_layers.resize( to, 0u );
+    }
+    const auto layers = to - from;
+    for ( auto l = from; l < to; ++l )
+    {
+      st_.t_layers[l] += count / layers + ( l - from < count % layers ? 1u : 0u );
+    }
+    st_.t_count += count;
+    st_.t_depth = std::max( st_.t_depth, to );
+  }
+
+  void process( tweedledum::gate_base const& op )
+  {
+    ++st_.num_gates;
+
+    /* ASAP layer */
+    uint32_t level{0u};
+    for ( auto const& q : controls )
+    {
+      level = std::max( level, qubits[q.index()].level );
+    }
+    for ( auto const& q : targets )
+    {
+      level = std::max( level, qubits[q.index()].level );
+    }
+    ++level;
+    st_.depth = std::max( st_.depth, level );
+
+    for ( auto const& q : controls )
+    {
+      auto& info = qubits[q.index()];
+      if ( info.last == 0u )
+      {
+        info.value = mix( q.index() + 1u );
+      }
+    }
+
+    const auto touch = [&]( tweedledum::qubit_id q ) {
+      auto& info = qubits[q.index()];
+      info.level = level;
+      if ( info.last == 0u )
+      {
+        info.first = level;
+      }
+      info.last = level;
+    };
+    std::for_each( controls.begin(), controls.end(), touch );
+    std::for_each( targets.begin(), targets.end(), touch );
+
+    switch ( op.operation() )
+    {
+    case tweedledum::gate_set::t:
+    case tweedledum::gate_set::t_dagger:
+      for ( auto const& q : targets )
+      {
+        auto& t_level = qubits[q.index()].t_level;
+        add_t_gates( t_level, t_level + 1u, 1u );
+        ++t_level;
+      }
+      break;
+
+    case tweedledum::gate_set::cx:
+    {
+      ++st_.cnot_count;
+      count_controls( 1u );
+      auto& ct = qubits[targets[0].index()];
+      auto& cc = qubits[controls[0].index()];
+      ct.value ^= value_of( controls[0] );
+      ct.t_level = std::max( ct.t_level, cc.t_level );
+      ct.cnot_level = cc.cnot_level = std::max( ct.cnot_level, cc.cnot_level ) + 1u;
+      st_.cnot_depth = std::max( st_.cnot_depth, ct.cnot_level );
+    }
+    break;
+
+    case tweedledum::gate_set::num_defined_ops:
+      count_controls( static_cast<uint32_t>( controls.size() ) );
+      ++st_.num_uncosted_gates;
+      /* the function of the gate is not tracked, the target gets a new value */
+      qubits[targets[0].index()].value = mix( ++num_lut_values ^ constant_one );
+      break;
+
+    case tweedledum::gate_set::pauli_x:
+    case tweedledum::gate_set::mcx:
+    case tweedledum::gate_set::mcz:
+      if ( op.operation() != tweedledum::gate_set::mcz )
+      {
+        count_controls( static_cast<uint32_t>( controls.size() ) );
+      }
+      if ( op.operation() != tweedledum::gate_set::mcz && controls.empty() )
+      {
+        qubits[targets[0].index()].value ^= constant_one;
+      }
+      else if ( controls.size() == 1u )
+      {
+        /* single-controlled MCX is a CNOT */
+        ++st_.cnot_count;
+        auto& ct = qubits[targets[0].index()];
+        auto& cc = qubits[controls[0].index()];
+        if ( op.operation() != tweedledum::gate_set::mcz )
+        {
+          ct.value ^= value_of( controls[0] );
+        }
+        ct.t_level = std::max( ct.t_level, cc.t_level );
+        ct.cnot_level = cc.cnot_level = std::max( ct.cnot_level, cc.cnot_level ) + 1u;
+        st_.cnot_depth = std::max( st_.cnot_depth, ct.cnot_level );
+      }
+      else if ( controls.size() >= 2u )
+      {
+        add_mcx( op.operation() != tweedledum::gate_set::mcz );
+      }
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  /* the target is clean afterwards, such that the next MCX onto it computes */
+  void process_measurement()
+  {
+    ++st_.num_measurements;
+    process( tweedledum::gate::cz );
+    auto& t = qubits[targets[0].index()];
+    t.value ^= t.and_key;
+    t.and_key = 0u;
+  }
+
+  void count_controls( uint32_t k )
+  {
+    if ( st_.gates_by_controls.size() <= k )
+    {
+      st_.gates_by_controls.resize( k + 1u, 0u );
+    }
+    ++st_.gates_by_controls[k];
+  }
+
+  /* `flips_target` is false for MCZ gates, which do not change the values */
+  void add_mcx( bool flips_target )
+  {
+    const auto k = static_cast<uint32_t>( controls.size() );
+    auto& t = qubits[targets[0].index()];
+
+    /* the hash of an AND does not depend on the order of its controls */
+    uint64_t and_key{0u};
+    for ( auto const& c : controls )
+    {
+      and_key += mix( value_of( c ) );
+    }
+    and_key = mix( and_key );
+    if ( flips_target )
+    {
+      t.value ^= and_key;
+    }
+
+    if ( ps.cost_model == mcx_cost_model::logical_and )
+    {
+      if ( t.and_key == and_key )
+      {
+        /* measurement-based uncomputation */
+        t.and_key = 0u;
+        return;
+      }
+      t.and_key = and_key;
+
+      uint32_t from = t.t_level;
+      uint32_t t_level = ps.use_tdepth1 ? t.t_level + 1u : t.t_level + 2u;
+      for ( auto const& c : controls )
+      {
+        from = std::min( from, qubits[c.index()].t_level );
+        t_level = std::max( t_level, qubits[c.index()].t_level + 1u );
+      }
+      t_level += ( ps.use_tdepth1 ? 1u : 2u ) * ( k - 2u );
+      add_t_gates( from, t_level, 4u * ( k - 1u ) );
+
+      t.t_level = t_level;
+      for ( auto const& c : controls )
+      {
+        qubits[c.index()].t_level += 1u;
+      }
+      return;
+    }
+
+    const auto [count, depth] = mcx_cost( k );
+    uint32_t from = t.t_level;
+    for ( auto const& c : controls )
+    {
+      from = std::max( from, qubits[c.index()].t_level );
+    }
+    add_t_gates( from, from + depth, count );
+    for ( auto const& c : controls )
+    {
+      qubits[c.index()].t_level = from + depth;
+    }
+    t.t_level = from + depth;
+  }
+
+private:
+  resource_estimation_params ps;
+  resource_estimation_stats st_;
+  std::vector<qubit_info> qubits;
+  uint64_t num_lut_values{0u};
+
+  static constexpr uint64_t constant_one{UINT64_C( 0x9e3779b97f4a7c15 )};
+
+  /* scratch buffers */
+  std::vector<tweedledum::qubit_id> controls;
+  std::vector<tweedledum::qubit_id> targets;
+};
+
+/*! \brief Estimates the resources of a quantum circuit in one pass. */
+template<class QuantumCircuit>
+resource_estimation_stats estimate_resources( QuantumCircuit const& circ, resource_estimation_params const& ps = {} )
+{
+  resource_estimator estimator( ps );
+  circ.foreach_cqubit( [&]( auto ) { estimator.add_qubit(); } );
+  circ.foreach_cgate( [&]( auto const& node ) { estimator.add_gate( node.gate ); } );
+  return estimator.stats();
+}
+
+} // namespace caterpillar
@@ -0,0 +1,193 @@
+/*------------------------------------------------------------------------------
+| This file is distributed under the MIT License.
+| See accompanying file /LICENSE for details.
+*-----------------------------------------------------------------------------*/
+#pragma once
+
+#include <caterpillar/synthesis/strategies/action.hpp>
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <fmt/format.h>
+#include <json.hpp>
+#include <mockturtle/utils/stopwatch.hpp>
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#include <sys/resource.h>
+#endif
+
+namespace caterpillar
+{
+
+/*! \brief Per-phase instrumentation shared by the synthesis algorithms.
+ *
+ * Each algorithm splits its runtime into four phases:
+ *
+ * - strategy: computing the order of steps (mapping strategy, pebbling or
+ *   CNOT-RZ SAT solving),
+ * - inputs: preparing input and constant qubits (or encoding the problem),
+ * - emission: emitting gates for the steps (or extracting the solution),
+ * - outputs: preparing output qubits.
+ *
+ * Steps are counted per alternative of `mapping_strategy_action`.
+ */
+struct synthesis_profile
+{
+  using duration = mockturtle::stopwatch<>::duration;
+
+  static constexpr auto num_action_kinds = std::variant_size_v<mapping_strategy_action>;
+
+  /*! \brief Runtime of the strategy phase. */
+  duration time_strategy{0};
+
+  /*! \brief Runtime of the input phase. */
+  duration time_inputs{0};
+
+  /*! \brief Runtime of the emission phase. */
+  duration time_emission{0};
+
+  /*! \brief Runtime of the output phase. */
+  duration time_outputs{0};
+
+  /*! \brief Number of steps, indexed by `mapping_strategy_action::index()`. */
+  std::array<uint64_t, num_action_kinds> num_actions{};
+
+  /*! \brief Number of emitted gates. */
+  uint64_t num_gates{0u};
+
+  /*! \brief Number of gates removed by the peephole optimizer before emission. */
+  uint64_t num_peephole_removed{0u};
+
+  /*! \brief Number of logical ANDs uncomputed by measurement instead of a Toffoli gate. */
+  uint64_t num_measured_uncomputes{0u};
+
+  /*! \brief Maximum number of ancillae in use at the same time. */
+  uint32_t peak_ancillae{0u};
+
+  /*! \brief Pairs (step, ancillae in use) each time the peak grows. */
+  std::vector<std::pair<uint64_t, uint32_t>> ancillae_watermarks;
+
+  /*! \brief Increase of the peak resident memory of the process during the run (0, if unknown).
+   *
+   * The operating system only reports the peak of the whole process, so a run
+   * that stays below the peak of earlier work reports 0.
+   */
+  uint64_t peak_memory_increase_bytes{0u};
+
+  void count_action( mapping_strategy_action const& action )
+  {
+    ++num_actions[action.index()];
+  }
+
+  uint64_t num_steps() const
+  {
+    uint64_t sum{0u};
+    for ( auto n : num_actions )
+    {
+      sum += n;
+    }
+    return sum;
+  }
+
+  void update_ancillae( uint32_t in_use )
+  {
+    if ( in_use > peak_ancillae )
+    {
+      peak_ancillae = in_use;
+      ancillae_watermarks.emplace_back( num_steps(), in_use );
+    }
+  }
+
+  /*! \brief Emitted gates per second of emission. */
+  double gates_per_second() const
+  {
+    const auto secs = mockturtle::to_seconds( time_emission );
+    return secs > 0.0 ? num_gates / secs : 0.0;
+  }
+
+  nlohmann::json to_json() const
+  {
+    return {{"time_strategy", mockturtle::to_seconds( time_strategy )},
+            {"time_inputs", mockturtle::to_seconds( time_inputs )},
+            {"time_emission", mockturtle::to_seconds( time_emission )},
+            {"time_outputs", mockturtle::to_seconds( time_outputs )},
+            {"compute", num_actions[0]},
+            {"uncompute", num_actions[1]},
+            {"compute_inplace", num_actions[2]},
+            {"uncompute_inplace", num_actions[3]},
+            {"buffer", num_actions[4]},
+            {"compute_level", num_actions[5]},
+            {"uncompute_level", num_actions[6]},
+            {"gates", num_gates},
+            {"gates_per_second", gates_per_second()},
+            {"peephole_removed", num_peephole_removed},
+            {"measured_uncomputes", num_measured_uncomputes},
+            {"peak_ancillae", peak_ancillae},
+            {"ancillae_watermarks", ancillae_watermarks},
+            {"peak_memory_increase_bytes", peak_memory_increase_bytes}};
+  }
+
+  void report() const
+  {
+    std::cout << fmt::format( "[i] strategy time  = {:>5.2f} secs\n", mockturtle::to_seconds( time_strategy ) );
+    std::cout << fmt::format( "[i] inputs time    = {:>5.2f} secs\n", mockturtle::to_seconds( time_inputs ) );
+    std::cout << fmt::format( "[i] emission time  = {:>5.2f} secs\n", mockturtle::to_seconds( time_emission ) );
+    std::cout << fmt::format( "[i] outputs time   = {:>5.2f} secs\n", mockturtle::to_seconds( time_outputs ) );
+    std::cout << fmt::format( "[i] steps          = {} (compute {}, uncompute {}, inplace {}/{}, buffer {}, level {}/{})\n",
+                              num_steps(), num_actions[0], num_actions[1], num_actions[2], num_actions[3], num_actions[4], num_actions[5], num_actions[6] );
+    std::cout << fmt::format( "[i] gates          = {} ({:.0f} gates/sec)\n", num_gates, gates_per_second() );
+    if ( num_peephole_removed )
+    {
+      std::cout << fmt::format( "[i] peephole       = {} gates removed\n", num_peephole_removed );
+    }
+    if ( num_measured_uncomputes )
+    {
+      std::cout << fmt::format( "[i] measured ANDs  = {} uncomputed without T gates\n", num_measured_uncomputes );
+    }
+    std::cout << fmt::format( "[i] peak ancillae  = {}\n", peak_ancillae );
+    std::cout << fmt::format( "[i] peak memory    = +{:.2f} MB\n", peak_memory_increase_bytes / ( 1024.0 * 1024.0 ) );
+  }
+};
+
+namespace detail
+{
+
+/*! \brief Peak resident memory of the process in bytes (0, if unknown). */
+inline uint64_t peak_memory_bytes()
+{
+#if defined( __unix__ ) || defined( __APPLE__ )
+  struct rusage usage;
+  if ( getrusage( RUSAGE_SELF, &usage ) == 0 )
+  {
+#if defined( __APPLE__ )
+    return static_cast<uint64_t>( usage.ru_maxrss );
+#else
+    return static_cast<uint64_t>( usage.ru_maxrss ) * 1024u;
+#endif
+  }
+#endif
+  return 0u;
+}
+
+/*! \brief Measures the increase of the peak resident memory since construction. */
+class peak_memory_tracker
+{
+public:
+  uint64_t increase() const
+  {
+    const auto peak = peak_memory_bytes();
+    return peak > start ? peak - start : 0u;
+  }
+
+private:
+  uint64_t start{peak_memory_bytes()};
+};
+
+} // namespace detail
+
+} // namespace caterpillar
@@ -0,0 +1,192 @@
+/*------------------------------------------------------------------------------
+| This file is distributed under the MIT License.
+| See accompanying file /LICENSE for details.
+*-----------------------------------------------------------------------------*/
+#pragma once
+
+/*!
+  \file trace.hpp
+  \brief Timeline spans in the Chrome trace-event format
+
+  Spans are recorded with `CATERPILLAR_TRACE_SPAN( name )`, where `name` is
+  a string literal, and written with `write_trace( filename )`.  The file can
+  be opened in Perfetto or chrome://tracing.
+
+  Tracing is enabled by defining `CATERPILLAR_TRACE` (CMake option
+  `CATERPILLAR_TRACE`).  Otherwise spans compile to nothing and
+  `write_trace` returns false.
+*/
+
+#include <string>
+
+#ifdef CATERPILLAR_TRACE
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+#endif
+
+namespace caterpillar
+{
+
+#ifdef CATERPILLAR_TRACE
+
+namespace detail
+{
+
+struct trace_event
+{
+  char const* name;
+  int64_t begin;
+  int64_t end;
+};
+
+/* events of one thread; the mutex is only contended while the trace is written or cleared */
+struct trace_buffer
+{
+  uint32_t tid;
+  std::mutex mutex;
+  std::vector<trace_event> events;
+
+  void push( trace_event const& e )
+  {
+    std::lock_guard<std::mutex> lock( mutex );
+    events.push_back( e );
+  }
+};
+
+/* one buffer per thread, such that threads that record spans do not wait for each other */
+class trace_recorder
+{
+public:
+  static trace_recorder& instance()
+  {
+    static trace_recorder recorder;
+    return recorder;
+  }
+
+  int64_t now() const
+  {
+    return std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - start ).count();
+  }
+
+  trace_buffer& local_buffer()
+  {
+    thread_local std::shared_ptr<trace_buffer> buffer = [this]() {
+      std::lock_guard<std::mutex> lock( mutex );
+      buffers.push_back( std::make_shared<trace_buffer>() );
+      buffers.back()->tid = static_cast<uint32_t>( buffers.size() );
+      return buffers.back();
+    }();
+    return *buffer;
+  }
+
+  bool write( std::string const& filename )
+  {
+    std::ofstream os( filename );
+    if ( !os )
+    {
+      return false;
+    }
+
+    std::lock_guard<std::mutex> lock( mutex );
+    os << "{\"traceEvents\":[";
+    auto first = true;
+    for ( auto const& buffer : buffers )
+    {
+      std::lock_guard<std::mutex> buffer_lock( buffer->mutex );
+      for ( auto const& e : buffer->events )
+      {
+        os << fmt::format( "{}\n{{\"name\":\"{}\",\"cat\":\"caterpillar\",\"ph\":\"X\",\"ts\":{},\"dur\":{},\"pid\":1,\"tid\":{}}}",
+                           first ? "" : ",", e.name, e.begin, e.end - e.begin, buffer->tid );
+        first = false;
+      }
+    }
+    os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return static_cast<bool>( os );
+  }
+
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock( mutex );
+    for ( auto& buffer : buffers )
+    {
+      std::lock_guard<std::mutex> buffer_lock( buffer->mutex );
+      buffer->events.clear();
+    }
+  }
+
+private:
+  trace_recorder() : start( std::chrono::steady_clock::now() ) {}
+
+  std::chrono::steady_clock::time_point start;
+  std::mutex mutex;
+  std::vector<std::shared_ptr<trace_buffer>> buffers;
+};
+
+class trace_span
+{
+public:
+  explicit trace_span( char const* name )
+      : name( name ), begin( trace_recorder::instance().now() )
+  {
+  }
+
+  ~trace_span()
+  {
+    auto& recorder = trace_recorder::instance();
+    recorder.local_buffer().push( {name, begin, recorder.now()} );
+  }
+
+  trace_span( trace_span const& ) = delete;
+  trace_span& operator=( trace_span const& ) = delete;
+
+private:
+  char const* name;
+  int64_t begin;
+};
+
+} // namespace detail
+
+/*! \brief Writes all recorded spans as Chrome trace-event JSON.
+ *
+ * Other threads may record spans meanwhile; spans that end during the call
+ * may or may not be written.
+ */
+inline bool write_trace( std::string const& filename )
+{
+  return detail::trace_recorder::instance().write( filename );
+}
+
+/*! \brief Discards all recorded spans. */
+inline void clear_trace()
+{
+  detail::trace_recorder::instance().clear();
+}
+
+#define CATERPILLAR_TRACE_CONCAT_( a, b ) a##b
+#define CATERPILLAR_TRACE_CONCAT( a, b ) CATERPILLAR_TRACE_CONCAT_( a, b )
+#define CATERPILLAR_TRACE_SPAN( name ) ::caterpillar::detail::trace_span CATERPILLAR_TRACE_CONCAT( _caterpillar_trace_span_, __LINE__ )( name )
+
+#else
+
+inline bool write_trace( std::string const& filename )
+{
+  (void)filename;
+  return false;
+}
+
+inline void clear_trace()
+{
+}
+
+#define CATERPILLAR_TRACE_SPAN( name )
+
+#endif
+
+} // namespace caterpillar
@@ -7,6 +7,7 @@
 #include <tweedledum/networks/netlist.hpp>
 #include <mockturtle/networks/klut.hpp>
 #include <mockturtle/traits.hpp>
+#include <caterpillar/details/resource_estimation.hpp>
 #include <caterpillar/structures/abstract_network.hpp>
 #include <caterpillar/structures/stg_gate.hpp>
 
@@ -79,57 +80,33 @@ namespace caterpillar::detail
   {
       auto T_number = 0u;
       netlist.foreach_cgate( [&]( const auto& gate ) {
+        if constexpr ( has_is_measurement_v<std::decay_t<decltype( gate.gate )>> )
+        {
+          /* measured AND uncomputations require no T gates */
+          if ( gate.gate.is_measurement() )
+            return;
+        }
         T_number += t_cost( gate.gate.num_controls(), netlist.size() );
       } );
       return T_number;
   }
 
-  /* finds T-count, T-depth and #CNOT for {X, CNOT, CCNOT} circuits where all CCNOT are computed on a clean helper line */
+  /* finds #CNOT, T-count and T-depth for circuits of X and MCX gates, where every MCX computes a logical AND onto a clean target
+     or uncomputes it; MCX gates with k controls are costed as ANDs of k literals by the resource estimator; LUT gates other
+     than measured AND uncomputations cannot be costed and must be decomposed first */
   static inline std::tuple<uint32_t, uint32_t, uint32_t> qc_stats(tweedledum::netlist<caterpillar::stg_gate> const& ntk, bool use_tdepth1 = false)
   {
-    auto Tcount = 0u;
-    auto CNOT = 0u;
-
-    std::vector<uint32_t> depths (ntk.num_qubits());
-    std::vector<bool> mask (ntk.num_qubits());
-
-
-    ntk.foreach_cgate([&] (auto& gate)
-    {
-      assert(gate.gate.num_controls() <= 2);
-      auto t = gate.gate.targets()[0];
-
-      if (gate.gate.num_controls() == 1)
-      { 
-        CNOT++;
-
-        auto c = gate.gate.controls()[0];
-        depths[t] = std::max(depths[c], depths[t]);
-      }
-      else if(gate.gate.num_controls() == 2)
-      {
-        auto c1 = gate.gate.controls()[0];
-        auto c2 = gate.gate.controls()[1];
-        if (!mask[t])
-        {
-
-          depths[t] = use_tdepth1 ? std::max(std::max(depths[t] + 1, depths[c1]+1), depths[c2]+1)  : std::max(std::max(depths[t] + 2, depths[c1]+1), depths[c2]+1);
-
-          gate.gate.foreach_control([&] (auto& c)
-          {
-            depths[c] = depths[c] + 1;
-          });
-          
-          Tcount = Tcount + 4;
-        }
-        mask[t] = !(mask[t]);
-      }
-      
-    });
+    resource_estimation_params ps;
+    ps.cost_model = mcx_cost_model::logical_and;
+    ps.use_tdepth1 = use_tdepth1;
 
+    resource_estimator estimator( ps );
+    ntk.foreach_cqubit( [&]( auto ) { estimator.add_qubit(); } );
+    ntk.foreach_cgate( [&]( auto const& gate ) { estimator.add_gate( gate.gate ); } );
 
-    auto Tdepth = depths[std::max_element(depths.begin(), depths.end()) - depths.begin()];
-    return { CNOT, Tcount, Tdepth}; 
+    const auto st = estimator.stats();
+    assert( st.num_uncosted_gates == 0u );
+    return {static_cast<uint32_t>( st.cnot_count ), static_cast<uint32_t>( st.t_count ), st.t_depth};
   }
   
 } // namespace caterpillar::detail
\ No newline at end of file
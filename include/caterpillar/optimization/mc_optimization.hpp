@@ -0,0 +1,361 @@
+/*------------------------------------------------------------------------------
+| This file is distributed under the MIT License.
+| See accompanying file /LICENSE for details.
+*-----------------------------------------------------------------------------*/
+#pragma once
+
+#include "../details/depth_costs.hpp"
+#include "../details/output_groups.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+#include <mockturtle/algorithms/cleanup.hpp>
+#include <mockturtle/algorithms/cut_rewriting.hpp>
+#include <mockturtle/algorithms/extract_linear.hpp>
+#include <mockturtle/algorithms/linear_resynthesis.hpp>
+#include <mockturtle/algorithms/node_resynthesis/xag_minmc2.hpp>
+#include <mockturtle/algorithms/xag_optimization.hpp>
+#include <mockturtle/algorithms/xag_resub_withDC.hpp>
+#include <mockturtle/networks/xag.hpp>
+#include <mockturtle/utils/cost_functions.hpp>
+#include <mockturtle/utils/node_map.hpp>
+#include <mockturtle/utils/stopwatch.hpp>
+#include <mockturtle/views/depth_view.hpp>
+
+namespace caterpillar
+{
+
+using xag_network = mockturtle::xag_network;
+
+struct mc_optimization_params
+{
+  /*! \brief Maximum number of iterations of the pipeline per window. */
+  uint32_t max_iterations{10u};
+
+  /*! \brief Time budget in seconds (0 means no budget).
+   *
+   * The budget is checked between passes, a running pass is not interrupted.
+   */
+  uint32_t timeout{0u};
+
+  /*! \brief Number of windows optimized concurrently. */
+  uint32_t num_threads{1u};
+
+  /*! \brief Cut size for cut rewriting (the MC database covers up to 5 inputs). */
+  uint32_t cut_size{5u};
+
+  /*! \brief Run cut rewriting with MC-optimal XAGs. */
+  bool cut_rewriting{true};
+
+  /*! \brief Run resubstitution with don't cares. */
+  bool resubstitution{true};
+
+  /*! \brief Replace AND gates that are don't cares for assignment 00 (SAT-based). */
+  bool dont_cares{false};
+
+  /*! \brief Resynthesize the linear part with Paar's algorithm. */
+  bool linear_resynthesis{true};
+
+  /*! \brief Be verbose. */
+  bool verbose{false};
+};
+
+struct mc_optimization_stats
+{
+  /*! \brief Total runtime. */
+  mockturtle::stopwatch<>::duration time_total{0};
+
+  /*! \brief Number of windows (output groups with disjoint transitive fanin). */
+  uint32_t num_windows{0u};
+
+  /*! \brief Number of iterations, summed over all windows. */
+  uint32_t num_iterations{0u};
+
+  /*! \brief Whether the time budget stopped the optimization. */
+  bool timed_out{false};
+
+  uint32_t ands_before{0u};
+  uint32_t ands_after{0u};
+  uint32_t xors_before{0u};
+  uint32_t xors_after{0u};
+  uint32_t and_depth_before{0u};
+  uint32_t and_depth_after{0u};
+
+  void report() const
+  {
+    std::cout << fmt::format( "[i] total time = {:>5.2f} secs{}\n", mockturtle::to_seconds( time_total ), timed_out ? " (timed out)" : "" );
+    std::cout << fmt::format( "[i] windows    = {} ({} iterations)\n", num_windows, num_iterations );
+    std::cout << fmt::format( "[i] ANDs       = {} -> {}\n", ands_before, ands_after );
+    std::cout << fmt::format( "[i] XORs       = {} -> {}\n", xors_before, xors_after );
+    std::cout << fmt::format( "[i] AND-depth  = {} -> {}\n", and_depth_before, and_depth_after );
+  }
+};
+
+namespace detail
+{
+
+inline std::pair<uint32_t, uint32_t> count_and_xor( xag_network const& xag )
+{
+  uint32_t ands{0u}, xors{0u};
+  xag.foreach_gate( [&]( auto const& n ) {
+    if ( xag.is_and( n ) )
+      ++ands;
+    else
+      ++xors;
+  } );
+  return {ands, xors};
+}
+
+inline uint32_t and_depth( xag_network const& xag )
+{
+  return mockturtle::depth_view<xag_network, and_depth_cost<xag_network>>{xag}.depth();
+}
+
+/* Paar's algorithm does not accept complemented edges, so the polarities are
+ * moved to the outputs before resynthesis and restored afterwards */
+inline xag_network linear_resynthesis_paar_with_polarities( xag_network const& linear )
+{
+  using signal = xag_network::signal;
+
+  xag_network normalized;
+  mockturtle::node_map<std::pair<signal, bool>, xag_network> old_to_new( linear );
+  old_to_new[linear.get_constant( false )] = {normalized.get_constant( false ), false};
+  linear.foreach_pi( [&]( auto const& n ) {
+    old_to_new[n] = {normalized.create_pi(), false};
+  } );
+
+  linear.foreach_gate( [&]( auto const& n ) {
+    std::array<signal, 2> children;
+    bool polarity{false};
+    linear.foreach_fanin( n, [&]( auto const& f, auto i ) {
+      const auto [s, p] = old_to_new[f];
+      children[i] = s;
+      polarity ^= p ^ linear.is_complemented( f );
+    } );
+    const auto f = normalized.create_xor( children[0], children[1] );
+    old_to_new[n] = {normalized.make_signal( normalized.get_node( f ) ), polarity ^ normalized.is_complemented( f )};
+  } );
+
+  std::vector<bool> polarities;
+  linear.foreach_po( [&]( auto const& f ) {
+    const auto [s, p] = old_to_new[f];
+    normalized.create_po( s );
+    polarities.push_back( p ^ linear.is_complemented( f ) );
+  } );
+
+  /* the algorithm requires at least one output with two or more variables */
+  const auto forms = mockturtle::simulate<std::vector<uint32_t>>( mockturtle::detail::linear_xag{normalized}, mockturtle::detail::linear_sum_simulator{} );
+  if ( std::none_of( forms.begin(), forms.end(), []( auto const& form ) { return form.size() > 1u; } ) )
+  {
+    return linear;
+  }
+
+  const auto optimized = mockturtle::linear_resynthesis_paar( normalized );
+
+  xag_network dest;
+  std::vector<signal> pis( optimized.num_pis() );
+  std::generate( pis.begin(), pis.end(), [&]() { return dest.create_pi(); } );
+  const auto outputs = mockturtle::cleanup_dangling( optimized, dest, pis.begin(), pis.end() );
+  for ( auto i = 0u; i < outputs.size(); ++i )
+  {
+    dest.create_po( outputs[i] ^ polarities[i] );
+  }
+  return dest;
+}
+
+/* like mockturtle's linear_resynthesis_optimization, but for multiple outputs */
+inline xag_network linear_resynthesis( xag_network const& xag )
+{
+  const auto [linear, ands] = mockturtle::extract_linear_circuit( xag );
+  if ( ands.empty() )
+  {
+    return linear_resynthesis_paar_with_polarities( xag );
+  }
+  return mockturtle::merge_linear_circuit( linear_resynthesis_paar_with_polarities( linear ), static_cast<uint32_t>( ands.size() ) );
+}
+
+class mc_optimization_impl
+{
+public:
+  mc_optimization_impl( xag_network const& xag, mc_optimization_params const& ps, mc_optimization_stats& st )
+      : xag( xag ), ps( ps ), st( st ), start( std::chrono::steady_clock::now() )
+  {
+  }
+
+  xag_network run()
+  {
+    mockturtle::stopwatch t( st.time_total );
+
+    std::tie( st.ands_before, st.xors_before ) = count_and_xor( xag );
+    st.and_depth_before = and_depth( xag );
+
+    const output_groups<xag_network> windows( xag );
+    st.num_windows = windows.size();
+
+    std::vector<xag_network> optimized( windows.size() );
+    std::vector<uint32_t> iterations( windows.size() );
+    std::atomic<uint32_t> next{0u};
+    auto worker = [&]() {
+      /* the database caches canonizations and is not shared between threads */
+      mockturtle::future::xag_minmc_resynthesis<xag_network> resyn;
+      for ( auto w = next++; w < windows.size(); w = next++ )
+      {
+        optimized[w] = optimize( windows.extract( w ), resyn, iterations[w] );
+      }
+    };
+
+    const auto num_threads = std::max( 1u, std::min( ps.num_threads, windows.size() ) );
+    std::vector<std::thread> threads;
+    for ( auto i = 1u; i < num_threads; ++i )
+    {
+      threads.emplace_back( worker );
+    }
+    worker();
+    for ( auto& thread : threads )
+    {
+      thread.join();
+    }
+    st.num_iterations = std::accumulate( iterations.begin(), iterations.end(), 0u );
+    st.timed_out = timed_out;
+
+    /* merge the windows, sharing primary inputs */
+    xag_network dest;
+    std::vector<xag_network::signal> pis( xag.num_pis() );
+    std::generate( pis.begin(), pis.end(), [&]() { return dest.create_pi(); } );
+
+    std::vector<xag_network::signal> pos( xag.num_pos() );
+    for ( auto w = 0u; w < windows.size(); ++w )
+    {
+      const auto outputs = mockturtle::cleanup_dangling( optimized[w], dest, pis.begin(), pis.end() );
+      for ( auto i = 0u; i < outputs.size(); ++i )
+      {
+        pos[windows.outputs_of( w )[i]] = outputs[i];
+      }
+    }
+    for ( auto const& f : pos )
+    {
+      dest.create_po( f );
+    }
+
+    std::tie( st.ands_after, st.xors_after ) = count_and_xor( dest );
+    st.and_depth_after = and_depth( dest );
+    return dest;
+  }
+
+private:
+  bool out_of_time() const
+  {
+    return ps.timeout != 0u && std::chrono::steady_clock::now() - start >= std::chrono::seconds( ps.timeout );
+  }
+
+  template<class Resyn>
+  xag_network optimize( xag_network ntk, Resyn const& resyn, uint32_t& iterations )
+  {
+    auto [ands, xors] = count_and_xor( ntk );
+    for ( auto i = 0u; i < ps.max_iterations; ++i )
+    {
+      if ( out_of_time() )
+      {
+        timed_out = true;
+        break;
+      }
+      ++iterations;
+
+      const auto before = ntk;
+      ntk = mockturtle::xag_constant_fanin_optimization( ntk );
+
+      if ( ps.cut_rewriting && !out_of_time() )
+      {
+        mockturtle::cut_rewriting_params crps;
+        crps.cut_enumeration_ps.cut_size = ps.cut_size;
+        ntk = mockturtle::cut_rewriting<xag_network, Resyn, mockturtle::mc_cost<xag_network>>( ntk, resyn, crps );
+      }
+
+      if ( ps.resubstitution && !out_of_time() )
+      {
+        mockturtle::resubstitution_minmc_withDC( ntk );
+        ntk = mockturtle::cleanup_dangling( ntk );
+      }
+
+      if ( ps.dont_cares && !out_of_time() )
+      {
+        ntk = mockturtle::xag_dont_cares_optimization( ntk );
+      }
+
+      if ( ps.linear_resynthesis && !out_of_time() )
+      {
+        ntk = linear_resynthesis( ntk );
+      }
+      ntk = mockturtle::cleanup_dangling( ntk );
+
+      /* keep the previous network if the pipeline made it worse */
+      const auto [new_ands, new_xors] = count_and_xor( ntk );
+      if ( new_ands > ands || ( new_ands == ands && new_xors > xors ) )
+      {
+        ntk = before;
+        break;
+      }
+      if ( new_ands == ands && new_xors == xors )
+      {
+        break;
+      }
+      ands = new_ands;
+      xors = new_xors;
+    }
+    return ntk;
+  }
+
+private:
+  xag_network const& xag;
+  mc_optimization_params const& ps;
+  mc_optimization_stats& st;
+  std::chrono::steady_clock::time_point start;
+  std::atomic<bool> timed_out{false};
+};
+
+} // namespace detail
+
+/*! \brief Reduces the multiplicative complexity of an XAG before synthesis.
+ *
+ * Each AND gate costs 4 T gates after synthesis, so this pipeline is meant
+ * to run in front of `logic_network_synthesis` or `xag_tracer`.  The
+ * outputs are partitioned into windows with disjoint transitive fanin,
+ * which are optimized on `ps.num_threads` threads.  On each window the
+ * following passes are repeated until the number of AND and XOR gates no
+ * longer decreases, `ps.max_iterations` is reached, or the time budget
+ * expires:
+ *
+ * - constant-fanin optimization,
+ * - cut rewriting with MC-optimal XAGs,
+ * - resubstitution with don't cares,
+ * - (optional) SAT-based don't-care optimization,
+ * - linear resynthesis of the XOR part.
+ */
+inline xag_network mc_optimization( xag_network const& xag, mc_optimization_params const& ps = {}, mc_optimization_stats* pst = nullptr )
+{
+  mc_optimization_stats st;
+  const auto result = detail::mc_optimization_impl( xag, ps, st ).run();
+
+  if ( ps.verbose )
+  {
+    st.report();
+  }
+
+  if ( pst )
+  {
+    *pst = st;
+  }
+
+  return result;
+}
+
+} // namespace caterpillar
@@ -6,8 +6,14 @@
 #pragma once
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
 #include <kitty/cube.hpp>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "../details/utils.hpp"
@@ -15,14 +21,14 @@
 
 namespace caterpillar
 {
-inline int count_set( const uint16_t bits )
+inline int count_set( const uint32_t bits )
 {
   return __builtin_popcount( bits );
 }
 
 inline int num_variables( const std::vector<kitty::cube>& esop )
 {
-  int16_t var_mask;
+  uint32_t var_mask{0u};
 
   for ( auto& cube : esop )
     var_mask = var_mask | cube._mask;
@@ -30,6 +36,27 @@ inline int num_variables( const std::vector<kitty::cube>& esop )
   return count_set( var_mask );
 }
 
+struct esop_matching_params
+{
+  /*! \brief Find a maximum-weight matching by branch and bound (default: greedy). */
+  bool exact{false};
+
+  /*! \brief Time budget in seconds for building the graph (0: none); only the candidates found so far are matched when it runs out.
+   *
+   * A budget makes the result depend on the speed of the machine.
+   */
+  double time_budget{0.0};
+
+  /*! \brief Time budget in seconds for the branch and bound of exact matching (0: none); the best matching found so far is used when it runs out. */
+  double exact_time_budget{1.0};
+
+  /*! \brief Literals that the larger cube of a first-property pair may have outside the other cube's literals, besides the one unique literal. */
+  uint32_t max_extra_literals{2u};
+
+  /*! \brief Maximum number of candidates per cube and bucket. */
+  uint32_t max_candidates{16u};
+};
+
 struct optimized_esop
 {
   std::vector<kitty::cube> cubes;
@@ -84,6 +111,8 @@ class optimization_graph
   std::vector<kitty::cube> esop;
   std::vector<edge> edges;
   int num_var;
+  esop_matching_params ps;
+  std::chrono::steady_clock::time_point start;
 
   int get_gain_first_property( kitty::cube f, kitty::cube s )
   {
@@ -123,6 +152,256 @@ class optimization_graph
     return 0;
   }
 
+  bool out_of_time( double budget, std::chrono::steady_clock::time_point since ) const
+  {
+    return budget > 0.0 &&
+           std::chrono::duration<double>( std::chrono::steady_clock::now() - since ).count() > budget;
+  }
+
+  bool out_of_time() const
+  {
+    return out_of_time( ps.time_budget, start );
+  }
+
+  static uint64_t signature( uint32_t mask, uint32_t bits )
+  {
+    return ( static_cast<uint64_t>( mask ) << 32 ) | ( bits & mask );
+  }
+
+  /* cubes with equal mask are candidates for the second property */
+  void add_second_property_edges()
+  {
+    std::unordered_map<uint32_t, std::vector<int>> buckets;
+    for ( auto i = 0u; i < esop.size(); ++i )
+    {
+      buckets[esop[i]._mask].push_back( i );
+    }
+
+    for ( auto& [mask, bucket] : buckets )
+    {
+      (void)mask;
+      /* all pairs in a bucket have the same gain; pairing neighbors by polarity suffices */
+      std::sort( bucket.begin(), bucket.end(), [&]( auto a, auto b ) { return esop[a]._bits < esop[b]._bits; } );
+      for ( auto i = 0u; i < bucket.size(); ++i )
+      {
+        for ( auto j = i + 1u; j < bucket.size() && j <= i + ps.max_candidates; ++j )
+        {
+          add_edge( bucket[i], bucket[j], get_gain_second_property( esop[bucket[i]], esop[bucket[j]] ), 2 );
+        }
+      }
+    }
+  }
+
+  /* a cube with one unique literal is a candidate for every cube that contains its other literals */
+  void add_first_property_edges()
+  {
+    /* index each cube under its literals, with up to max_extra_literals of them removed */
+    std::unordered_map<uint64_t, std::vector<int>> buckets;
+    std::vector<uint32_t> vars;
+    for ( auto i = 0u; i < esop.size() && !out_of_time(); ++i )
+    {
+      auto const& cube = esop[i];
+      vars.clear();
+      for ( auto v = 0u; v < 32u; ++v )
+      {
+        if ( ( cube._mask >> v ) & 1 )
+          vars.push_back( v );
+      }
+      foreach_subset( vars, ps.max_extra_literals, [&]( uint32_t removed ) {
+        if ( removed != cube._mask )
+        {
+          buckets[signature( cube._mask & ~removed, cube._bits )].push_back( i );
+        }
+      } );
+    }
+
+    for ( auto i = 0u; i < esop.size() && !out_of_time(); ++i )
+    {
+      auto const& cube = esop[i];
+      for ( auto v = 0u; v < 32u; ++v )
+      {
+        if ( ( ( cube._mask >> v ) & 1 ) == 0 || cube._mask == ( 1u << v ) )
+          continue;
+
+        const auto it = buckets.find( signature( cube._mask & ~( 1u << v ), cube._bits ) );
+        if ( it == buckets.end() )
+          continue;
+
+        auto num_candidates = 0u;
+        for ( auto j : it->second )
+        {
+          if ( static_cast<uint32_t>( j ) == i || esop[j] == cube )
+            continue;
+          if ( ++num_candidates > ps.max_candidates )
+            break;
+          add_edge( i, j, get_gain_first_property( cube, esop[j] ), 1 );
+        }
+      }
+    }
+  }
+
+  template<class Fn>
+  static void foreach_subset( std::vector<uint32_t> const& vars, uint32_t max_size, Fn&& fn, uint32_t first = 0u, uint32_t subset = 0u )
+  {
+    fn( subset );
+    if ( max_size == 0u )
+      return;
+    for ( auto k = first; k < vars.size(); ++k )
+    {
+      foreach_subset( vars, max_size - 1u, fn, k + 1u, subset | ( 1u << vars[k] ) );
+    }
+  }
+
+  void add_edge( int i, int j, int gain, int type )
+  {
+    if ( gain <= 0 )
+      return;
+    if ( i > j )
+      std::swap( i, j );
+    if ( seen.insert( ( static_cast<uint64_t>( i ) * esop.size() + j ) * 2u + ( type - 1 ) ).second )
+    {
+      edges.push_back( edge( i, j, gain, type ) );
+    }
+  }
+
+  /* greedy matching by decreasing weight */
+  void match_greedy( std::vector<bool>& matched )
+  {
+    for ( auto& edge : edges )
+    {
+      if ( !matched[edge.from] && !matched[edge.to] )
+      {
+        edge.match();
+        matched[edge.from] = matched[edge.to] = true;
+      }
+    }
+  }
+
+  /* maximum-weight matching by branch and bound, starting from the greedy matching */
+  void match_exact( std::vector<bool>& matched )
+  {
+    const auto search_start = std::chrono::steady_clock::now();
+    match_greedy( matched );
+
+    std::vector<std::vector<uint32_t>> incident( esop.size() );
+    std::vector<uint32_t> best( esop.size(), 0u );
+    uint64_t greedy_weight{0u};
+    for ( auto e = 0u; e < edges.size(); ++e )
+    {
+      incident[edges[e].from].push_back( e );
+      best[edges[e].from] = std::max( best[edges[e].from], edges[e].weight );
+      best[edges[e].to] = std::max( best[edges[e].to], edges[e].weight );
+      if ( edges[e].matched )
+        greedy_weight += edges[e].weight;
+    }
+
+    /* twice the weight, such that the bound sum_u best[u] needs no halving */
+    uint64_t incumbent = 2u * greedy_weight;
+    uint64_t remaining{0u};
+    for ( auto b : best )
+      remaining += b;
+
+    /* depth-first search with an explicit stack, one frame per cube u whose
+       incident edges are tried in order; the last choice leaves u unmatched */
+    struct frame
+    {
+      uint32_t u;
+      uint64_t value;
+      uint32_t next{0u};
+      int matched_edge{-1};
+      bool entered{false};
+    };
+
+    std::vector<bool> used( esop.size(), false );
+    std::vector<uint32_t> chosen, best_chosen;
+    bool improved = false;
+    uint64_t steps{0u};
+
+    std::vector<frame> stack{frame{0u, 0u}};
+    while ( !stack.empty() )
+    {
+      if ( ++steps % 1024u == 0u && out_of_time( ps.exact_time_budget, search_start ) )
+        break;
+
+      auto& f = stack.back();
+      if ( !f.entered )
+      {
+        while ( f.u < esop.size() && used[f.u] )
+          ++f.u;
+        if ( f.u == esop.size() )
+        {
+          if ( f.value > incumbent )
+          {
+            incumbent = f.value;
+            best_chosen = chosen;
+            improved = true;
+          }
+          stack.pop_back();
+          continue;
+        }
+        if ( f.value + remaining <= incumbent )
+        {
+          stack.pop_back();
+          continue;
+        }
+        remaining -= best[f.u];
+        f.entered = true;
+      }
+
+      /* undo the edge of the previous child */
+      if ( f.matched_edge != -1 )
+      {
+        auto const& edge = edges[f.matched_edge];
+        chosen.pop_back();
+        remaining += best[edge.to];
+        used[edge.to] = false;
+        f.matched_edge = -1;
+      }
+
+      auto const& inc = incident[f.u];
+      while ( f.next < inc.size() && used[edges[inc[f.next]].to] )
+        ++f.next;
+
+      if ( f.next < inc.size() )
+      {
+        auto const e = inc[f.next++];
+        auto const& edge = edges[e];
+        used[edge.to] = true;
+        remaining -= best[edge.to];
+        chosen.push_back( e );
+        f.matched_edge = static_cast<int>( e );
+        const frame child{f.u + 1u, f.value + 2u * edge.weight};
+        stack.push_back( child );
+      }
+      else if ( f.next == inc.size() )
+      {
+        /* leave u unmatched */
+        ++f.next;
+        const frame child{f.u + 1u, f.value};
+        stack.push_back( child );
+      }
+      else
+      {
+        remaining += best[f.u];
+        stack.pop_back();
+      }
+    }
+
+    if ( improved )
+    {
+      std::fill( matched.begin(), matched.end(), false );
+      for ( auto& edge : edges )
+        edge.matched = false;
+      for ( auto e : best_chosen )
+      {
+        edges[e].match();
+        matched[edges[e].from] = matched[edges[e].to] = true;
+      }
+    }
+  }
+
+  std::unordered_set<uint64_t> seen;
+
 public:
   void print()
   {
@@ -133,22 +412,17 @@ public:
 
   optimized_esop match_properties()
   {
-    std::vector<int> m_nodes;
     std::vector<kitty::cube> cubes;
     std::vector<int> pairing;
+    std::vector<bool> matched( esop.size(), false );
 
-    std::sort( edges.begin(), edges.end(),
-               []( edge a, edge b ) { return a.weight > b.weight; } );
+    std::stable_sort( edges.begin(), edges.end(),
+                      []( edge const& a, edge const& b ) { return a.weight > b.weight; } );
 
-    for ( auto& edge : edges )
-    {
-      if ( ( std::find( m_nodes.begin(), m_nodes.end(), edge.from ) == m_nodes.end() ) && ( std::find( m_nodes.begin(), m_nodes.end(), edge.to ) == m_nodes.end() ) )
-      {
-        edge.match();
-        m_nodes.push_back( edge.from );
-        m_nodes.push_back( edge.to );
-      }
-    }
+    if ( ps.exact )
+      match_exact( matched );
+    else
+      match_greedy( matched );
 
     for ( auto& edge : edges )
     {
@@ -163,37 +437,24 @@ public:
 
     for ( uint32_t i = 0; i < esop.size(); i++ )
     {
-      if ( std::find( m_nodes.begin(), m_nodes.end(), i ) == m_nodes.end() )
+      if ( !matched[i] )
         cubes.push_back( esop[i] );
     }
     return optimized_esop( cubes, pairing );
   }
 
-  optimization_graph( std::vector<kitty::cube> esop )
-      : esop( esop )
+  optimization_graph( std::vector<kitty::cube> esop, esop_matching_params const& ps = {} )
+      : esop( esop ), ps( ps ), start( std::chrono::steady_clock::now() )
   {
     /* Each graph corresponds to an esop, each node to a cube,
-		each edge to pairing cubes with weight=costgain*/
+		each edge to pairing cubes with weight=costgain.  Candidate pairs
+		are found by bucketing the cubes on their literals, instead of
+		comparing all pairs */
 
     num_var = num_variables( esop );
 
-    for ( unsigned i = 0; i < esop.size() - 1; ++i )
-    {
-      auto cube = esop[i];
-      for ( unsigned j = i + 1; j < esop.size(); ++j )
-      {
-        auto paired = esop[j];
-        if ( paired != cube )
-        {
-          auto gfp = get_gain_first_property( cube, paired );
-          auto gsp = get_gain_second_property( cube, paired );
-          if ( gfp != 0 )
-            edges.push_back( edge( i, j, gfp, 1 ) );
-          if ( gsp != 0 )
-            edges.push_back( edge( i, j, gsp, 2 ) );
-        }
-      }
-    }
+    add_first_property_edges();
+    add_second_property_edges();
   }
 };
 } // namespace caterpillar
\ No newline at end of file
@@ -17,6 +17,7 @@
 #include <kitty/spectral.hpp>
 #include <tweedledum/algorithms/synthesis/gray_synth.hpp>
 #include <tweedledum/gates/gate_base.hpp>
+#include <tweedledum/networks/qubit.hpp>
 
 #include <vector>
 
@@ -39,7 +40,7 @@ template<class Network>
 void add_gate_with_neg_contr( Network& net, td::gate_base gate_type, std::vector<Control> controls,
                               std::vector<uint32_t> target )
 {
-  std::vector<uint32_t> control_lines;
+  std::vector<td::qubit_id> control_lines;
   std::vector<uint32_t> negation_targets;
 
   for ( auto c : controls )
@@ -52,7 +53,7 @@ void add_gate_with_neg_contr( Network& net, td::gate_base gate_type, std::vector
   for ( auto n : negation_targets )
     net.add_gate( td::gate::pauli_x, n );
 
-  net.add_gate( gate_type, control_lines, target );
+  net.add_gate( gate_type, control_lines, std::vector<td::qubit_id>( target.begin(), target.end() ) );
 
   for ( auto n : negation_targets )
     net.add_gate( td::gate::pauli_x, n );
@@ -123,7 +124,7 @@ void add_equivalent_to_net_property2( Network& net, const kitty::cube& a, const
   {
     bool done = false;
     std::vector<uint32_t> cnot_targets;
-    std::vector<uint32_t> cnot_control;
+    std::vector<td::qubit_id> cnot_control;
     std::vector<Control> common_controls;
     std::vector<uint32_t> common_target = {qubit_map.back()};
 
@@ -141,7 +142,7 @@ void add_equivalent_to_net_property2( Network& net, const kitty::cube& a, const
             {
               if ( ( ( ( b._mask >> j ) & 1 ) == 1 ) && ( j != i ) )
                 common_controls.push_back(
-                    b._bits >> j == 1 ? Control( qubit_map[j], true ) : Control( qubit_map[j], false ) );
+                    ( ( b._bits >> j ) & 1 ) == 1 ? Control( qubit_map[j], true ) : Control( qubit_map[j], false ) );
             }
           }
           else if ( ( ( b._bits >> i ) & 1 ) == 1 )
@@ -150,7 +151,7 @@ void add_equivalent_to_net_property2( Network& net, const kitty::cube& a, const
             {
               if ( ( ( ( a._mask >> j ) & 1 ) == 1 ) && ( j != i ) )
                 common_controls.push_back(
-                    a._bits >> j == 1 ? Control( qubit_map[j], true ) : Control( qubit_map[j], false ) );
+                    ( ( a._bits >> j ) & 1 ) == 1 ? Control( qubit_map[j], true ) : Control( qubit_map[j], false ) );
             }
           }
         }
@@ -160,18 +161,18 @@ void add_equivalent_to_net_property2( Network& net, const kitty::cube& a, const
     }
 
     for ( auto target : cnot_targets )
-      net.add_gate( td::gate::mcx, cnot_control, {target} );
+      net.add_gate( td::gate::mcx, cnot_control, {td::qubit_id( target )} );
 
     add_gate_with_neg_contr( net, td::gate::mcx, common_controls, common_target );
 
     for ( auto target : cnot_targets )
-      net.add_gate( td::gate::mcx, cnot_control, {target} );
+      net.add_gate( td::gate::mcx, cnot_control, {td::qubit_id( target )} );
   }
 }
 
-inline optimized_esop match_pairing( std::vector<kitty::cube> esop )
+inline optimized_esop match_pairing( std::vector<kitty::cube> esop, esop_matching_params const& ps = {} )
 {
-  auto g = optimization_graph( esop );
+  auto g = optimization_graph( esop, ps );
   return g.match_properties();
 }
 
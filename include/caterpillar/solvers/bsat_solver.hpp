@@ -5,23 +5,37 @@
 *-----------------------------------------------------------------------------*/
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <unordered_map>
+#include <unordered_set>
 #include <variant>
 #include <vector>
 
 #include <mockturtle/traits.hpp>
 #include <mockturtle/utils/node_map.hpp>
 #include <mockturtle/views/fanout_view.hpp>
-#include <percy/solvers/bsat2.hpp>
-#include <algorithm>
 
 #include "../synthesis/strategies/action.hpp"
+#include "sat_backends.hpp"
 
 namespace caterpillar
 {
 
-template<typename Network>
+/*! \brief CNF based pebbling solver.
+ *
+ * The SAT solver is set with `Solver`, see `sat_backends.hpp`.  If the
+ * backend supports variable elimination, only the pebble variables of the
+ * last step are frozen, since they are the interface to the next step.
+ *
+ * The number of pebbles in each step is bounded by a sequential counter
+ * for the number of pebbles given to the constructor.  The bound can be
+ * tightened afterwards with `set_pebble_limit`, which is passed to the SAT
+ * solver as assumptions, such that the solver and its learnt clauses are
+ * reused for the smaller bound.
+ */
+template<typename Network, class Solver = bsat_backend>
 class bsat_pebble_solver
 {
   
@@ -35,6 +49,7 @@ public:
         gate_to_index( net ),
         _net( net ),
         _pebbles( pebbles ),
+        _max_pebbles( pebbles ),
         _nr_gates( net.num_gates()),
         conflict_limit(conflict_limit)
   {
@@ -48,7 +63,33 @@ public:
       o_set.insert( net.get_node( po ) );
     } );
 
-    extra = ( _pebbles < _nr_gates ) ? _pebbles * ( _nr_gates - _pebbles ) : 0;
+    extra = has_counter() ? _max_pebbles * _nr_gates : 0;
+
+    /* in-place moves: a XOR/XOR3 gate can be computed onto one of its gate children */
+    moves_of.resize( _nr_gates );
+    moves_onto.resize( _nr_gates );
+    net.foreach_gate( [&]( auto n, auto i ) {
+      if ( !is_parity( n ) )
+        return;
+
+      std::vector<uint32_t> children;
+      net.foreach_fanin( n, [&]( auto const& f ) {
+        auto ch_node = net.get_node( f );
+        if ( !net.is_constant( ch_node ) && !net.is_pi( ch_node ) )
+          children.push_back( gate_to_index[ch_node] );
+      } );
+
+      for ( auto c : children )
+      {
+        /* a child appearing twice cannot hold the result */
+        if ( std::count( children.begin(), children.end(), c ) != 1 )
+          continue;
+        moves_of[i].push_back( static_cast<uint32_t>( inplace_moves.size() ) );
+        moves_onto[c].push_back( static_cast<uint32_t>( inplace_moves.size() ) );
+        inplace_moves.emplace_back( i, c );
+      }
+    } );
+    _nr_moves = static_cast<uint32_t>( inplace_moves.size() );
   }
 
   inline uint32_t current_step() const { return _nr_steps; }
@@ -59,9 +100,20 @@ public:
 
   result unknown(){ return result::timeout; }
 
+  /*! \brief Tightens the number of pebbles to `pebbles` for all following calls to `solve`.
+   *
+   * The new limit must not exceed the number of pebbles given to the
+   * constructor, which must be smaller than the number of gates.
+   */
+  void set_pebble_limit( uint32_t pebbles )
+  {
+    assert( has_counter() && pebbles > 0 && pebbles <= _max_pebbles );
+    _pebbles = pebbles;
+  }
+
   void save_model() 
   {
-    solution_model.resize( _nr_steps + 1);
+    solution_model.assign( _nr_steps + 1, {} );
 
     for ( auto i = 0u; i <= _nr_steps; ++i )
     {
@@ -71,35 +123,94 @@ public:
         solution_model[i].push_back( value );
       }
     }
+
+    inplace_model.clear();
+    inplace_model.resize( _nr_steps + 1 );
+    for ( auto i = 1u; i <= _nr_steps; ++i )
+    {
+      for ( auto m = 0u; m < _nr_moves; ++m )
+      {
+        if ( solver.var_value( move_var( i, m ) ) )
+          inplace_model[i].push_back( m );
+      }
+    }
   }
 
-  inline void add_edge_clause( int p, int p_n, int ch, int ch_n )
+  /* if p changes, ch must be pebbled before and after, unless one of the
+   * literals in relax holds */
+  inline void add_edge_clause( int p, int p_n, int ch, int ch_n, std::vector<int> const& relax = {} )
   {
-    int h[3];
+    std::vector<int> h( 3u + relax.size() );
+    std::copy( relax.begin(), relax.end(), h.begin() + 3 );
+
     h[0] = pabc::Abc_Var2Lit( p, 1 );
     h[1] = pabc::Abc_Var2Lit( p_n, 0 );
     h[2] = pabc::Abc_Var2Lit( ch, 0 );
-    solver.add_clause( h, h + 3 );
+    solver.add_clause( h.data(), h.data() + h.size() );
 
     h[0] = pabc::Abc_Var2Lit( p, 1 );
     h[1] = pabc::Abc_Var2Lit( p_n, 0 );
     h[2] = pabc::Abc_Var2Lit( ch_n, 0 );
-    solver.add_clause( h, h + 3 );
+    solver.add_clause( h.data(), h.data() + h.size() );
 
     h[0] = pabc::Abc_Var2Lit( p, 0 );
     h[1] = pabc::Abc_Var2Lit( p_n, 1 );
     h[2] = pabc::Abc_Var2Lit( ch, 0 );
-    solver.add_clause( h, h + 3 );
+    solver.add_clause( h.data(), h.data() + h.size() );
 
     h[0] = pabc::Abc_Var2Lit( p, 0 );
     h[1] = pabc::Abc_Var2Lit( p_n, 1 );
     h[2] = pabc::Abc_Var2Lit( ch_n, 0 );
+    solver.add_clause( h.data(), h.data() + h.size() );
+  }
+
+  /* move m of gate g onto child c: g changes and swaps its pebble with c */
+  inline void add_inplace_clauses( int m, int g, int g_n, int c, int c_n )
+  {
+    int h[3];
+    h[0] = pabc::Abc_Var2Lit( m, 1 );
+    h[1] = pabc::Abc_Var2Lit( g, 0 );
+    h[2] = pabc::Abc_Var2Lit( g_n, 0 );
+    solver.add_clause( h, h + 3 );
+
+    h[1] = pabc::Abc_Var2Lit( g, 1 );
+    h[2] = pabc::Abc_Var2Lit( g_n, 1 );
+    solver.add_clause( h, h + 3 );
+
+    h[1] = pabc::Abc_Var2Lit( c, 1 );
+    h[2] = pabc::Abc_Var2Lit( g_n, 0 );
+    solver.add_clause( h, h + 3 );
+
+    h[1] = pabc::Abc_Var2Lit( c, 0 );
+    h[2] = pabc::Abc_Var2Lit( g_n, 1 );
+    solver.add_clause( h, h + 3 );
+
+    h[1] = pabc::Abc_Var2Lit( c_n, 1 );
+    h[2] = pabc::Abc_Var2Lit( g, 0 );
+    solver.add_clause( h, h + 3 );
+
+    h[1] = pabc::Abc_Var2Lit( c_n, 0 );
+    h[2] = pabc::Abc_Var2Lit( g, 1 );
     solver.add_clause( h, h + 3 );
   }
 
+  inline void add_at_most_one( std::vector<int> const& vars )
+  {
+    for ( auto a = 0u; a < vars.size(); ++a )
+    {
+      for ( auto b = a + 1; b < vars.size(); ++b )
+      {
+        int h[2];
+        h[0] = pabc::Abc_Var2Lit( vars[a], 1 );
+        h[1] = pabc::Abc_Var2Lit( vars[b], 1 );
+        solver.add_clause( h, h + 2 );
+      }
+    }
+  }
+
   void init()
   {
-    solver.set_nr_vars( _nr_gates + extra );
+    solver.set_nr_vars( block_size() );
 
     /* set constraint that everything is unpebbled */
     for ( auto v = 0u; v < _nr_gates; v++ )
@@ -112,101 +223,194 @@ public:
   void add_step()
   {
     _nr_steps++;
-    solver.set_nr_vars( ( _nr_gates + extra ) * ( 1 + _nr_steps ) );
+    solver.set_nr_vars( block_size() * ( 1 + _nr_steps ) );
 
     /* encode move */
     _net.foreach_gate( [&]( auto n, auto i ) {
       auto p = pebble_var( _nr_steps - 1, i );
       auto p_next = pebble_var( _nr_steps, i );
 
+      /* a target taken over in-place does not need its own children */
+      std::vector<int> relax_onto;
+      for ( auto m : moves_onto[i] )
+        relax_onto.push_back( pabc::Abc_Var2Lit( move_var( _nr_steps, m ), 0 ) );
+
       _net.foreach_fanin( n, [&]( auto ch ) {
         auto ch_node = _net.get_node( ch );
         if ( !_net.is_constant( ch_node ) && !_net.is_pi( ch_node ) )
         {
-          const auto ch = pebble_var( _nr_steps - 1, gate_to_index[ch_node] );
-          const auto ch_next = pebble_var( _nr_steps, gate_to_index[ch_node] );
-          add_edge_clause( p, p_next, ch, ch_next );
+          const uint32_t ch_index = gate_to_index[ch_node];
+          const auto ch = pebble_var( _nr_steps - 1, ch_index );
+          const auto ch_next = pebble_var( _nr_steps, ch_index );
+
+          /* the child may change if it is the target of an in-place move of n */
+          std::vector<int> relax = relax_onto;
+          for ( auto m : moves_of[i] )
+          {
+            if ( inplace_moves[m].second == ch_index )
+              relax.push_back( pabc::Abc_Var2Lit( move_var( _nr_steps, m ), 0 ) );
+          }
+          add_edge_clause( p, p_next, ch, ch_next, relax );
         }
       } );
     } );
 
-    /* cardinality constraint */
-    if ( ( _pebbles > 0 ) && ( _nr_gates > _pebbles ) )
+    /* encode in-place moves */
+    if ( _nr_moves > 0 )
     {
-      /* var declaration */
-      std::vector<std::vector<int>> card_vars( _nr_gates - _pebbles );
-      auto id_start = _nr_steps * ( _nr_gates + extra ) + _nr_gates;
-      for ( auto j = 0u; j < _nr_gates - _pebbles; ++j )
+      for ( auto m = 0u; m < _nr_moves; ++m )
       {
-        for ( auto k = 0u; k < _pebbles; ++k )
-        {
-          card_vars[j].push_back( id_start );
-          id_start++;
-        }
+        const auto [g, c] = inplace_moves[m];
+        add_inplace_clauses( move_var( _nr_steps, m ),
+                             pebble_var( _nr_steps - 1, g ), pebble_var( _nr_steps, g ),
+                             pebble_var( _nr_steps - 1, c ), pebble_var( _nr_steps, c ) );
       }
 
-      /* constraint */
-      for ( auto j = 0u; j < _nr_gates - _pebbles - 1u; j++ )
+      /* a gate is involved in at most one in-place move per step */
+      for ( auto i = 0u; i < _nr_gates; ++i )
       {
-        for ( auto k = 0u; k < _pebbles; k++ )
-        {
-          int to_or[2];
-          to_or[0] = pabc::Abc_Var2Lit( card_vars[j][k], 1 );
-          to_or[1] = pabc::Abc_Var2Lit( card_vars[j + 1][k], 0 );
-          solver.add_clause( to_or, to_or + 2 );
-        }
+        std::vector<int> vars;
+        for ( auto m : moves_of[i] )
+          vars.push_back( move_var( _nr_steps, m ) );
+        for ( auto m : moves_onto[i] )
+          vars.push_back( move_var( _nr_steps, m ) );
+        add_at_most_one( vars );
       }
+    }
 
-      for ( auto j = 0u; j < _nr_gates - _pebbles; j++ )
+    /* cardinality constraint: sequential counter, where card_var( s, j, k )
+     * holds if at least k + 1 of the gates 0, ..., j are pebbled in step s */
+    if ( has_counter() )
+    {
+      const auto k_max = _max_pebbles;
+      int h[3];
+      for ( auto j = 0u; j < _nr_gates; ++j )
       {
+        const auto x = pebble_var( _nr_steps, j );
 
-        for ( auto kp = 0u; kp <= _pebbles; kp++ )
-        {
-          int k = kp - 1;
-          int to_var_or[3];
+        h[0] = pabc::Abc_Var2Lit( x, 1 );
+        h[1] = pabc::Abc_Var2Lit( card_var( _nr_steps, j, 0 ), 0 );
+        solver.add_clause( h, h + 2 );
 
-          if ( k == -1 )
-          {
-            to_var_or[0] = pabc::Abc_Var2Lit( _nr_steps * ( _nr_gates + extra ) + j + k + 1, 1 );
-            to_var_or[1] = pabc::Abc_Var2Lit( card_vars[j][k + 1], 0 );
-            solver.add_clause( to_var_or, to_var_or + 2 );
-          }
-          else if ( k == static_cast<int>( _pebbles - 1 ) )
-          {
-            to_var_or[0] = pabc::Abc_Var2Lit( _nr_steps * ( _nr_gates + extra ) + j + k + 1, 1 );
-            to_var_or[1] = pabc::Abc_Var2Lit( card_vars[j][k], 1 );
-            solver.add_clause( to_var_or, to_var_or + 2 );
-          }
-          else
-          {
-            to_var_or[0] = pabc::Abc_Var2Lit( _nr_steps * ( _nr_gates + extra ) + j + k + 1, 1 );
-            to_var_or[1] = pabc::Abc_Var2Lit( card_vars[j][k], 1 );
-            to_var_or[2] = pabc::Abc_Var2Lit( card_vars[j][k + 1], 0 );
-            solver.add_clause( to_var_or, to_var_or + 3 );
-          }
+        if ( j == 0u )
+          continue;
+
+        for ( auto k = 0u; k < k_max; ++k )
+        {
+          h[0] = pabc::Abc_Var2Lit( card_var( _nr_steps, j - 1, k ), 1 );
+          h[1] = pabc::Abc_Var2Lit( card_var( _nr_steps, j, k ), 0 );
+          solver.add_clause( h, h + 2 );
         }
+        for ( auto k = 1u; k < k_max; ++k )
+        {
+          h[0] = pabc::Abc_Var2Lit( x, 1 );
+          h[1] = pabc::Abc_Var2Lit( card_var( _nr_steps, j - 1, k - 1 ), 1 );
+          h[2] = pabc::Abc_Var2Lit( card_var( _nr_steps, j, k ), 0 );
+          solver.add_clause( h, h + 3 );
+        }
+
+        h[0] = pabc::Abc_Var2Lit( x, 1 );
+        h[1] = pabc::Abc_Var2Lit( card_var( _nr_steps, j - 1, k_max - 1 ), 1 );
+        solver.add_clause( h, h + 2 );
+      }
+
+      /* outputs of the counter are assumed by tighter pebble limits */
+      if constexpr ( has_freeze_v<Solver> )
+      {
+        for ( auto k = 0u; k < k_max; ++k )
+          solver.freeze( card_var( _nr_steps, _nr_gates - 1, k ), true );
       }
     }
   }
 
-  result solve( )
+  result solve()
   {
-    std::vector<int> p( _nr_gates );
-    _net.foreach_gate( [&]( auto n, auto i ) {
-      p[i] = pabc::Abc_Var2Lit( pebble_var( _nr_steps, i ), o_set.count( n ) ? 0 : 1 );
-    } );
-    return solver.solve( &p[0], &p[0] + _nr_gates, conflict_limit );
+    prepare_assumptions();
+    return solver.solve( assumptions.data(), assumptions.data() + assumptions.size(), conflict_limit );
+  }
+
+  /*! \brief Solves, but gives up with `unknown()` once `deadline` has passed.
+   *
+   * The SAT solver is called with a budget of `conflicts_per_slice`
+   * conflicts at a time, and the deadline is checked after each slice.
+   * The conflict limit of the constructor bounds the sum over all slices.
+   */
+  result solve( std::chrono::steady_clock::time_point const& deadline )
+  {
+    prepare_assumptions();
+
+    uint64_t conflicts{0u};
+    while ( true )
+    {
+      auto budget = conflicts_per_slice;
+      if ( conflict_limit )
+      {
+        budget = static_cast<uint32_t>( std::min<uint64_t>( budget, conflict_limit - conflicts ) );
+      }
+
+      const auto res = solver.solve( assumptions.data(), assumptions.data() + assumptions.size(), budget );
+      conflicts += budget;
+      if ( res != unknown() || std::chrono::steady_clock::now() >= deadline || ( conflict_limit && conflicts >= conflict_limit ) )
+      {
+        return res;
+      }
+    }
   }
 
   inline int pebble_var( int step, int gate )
   {
-    return step * ( extra + _nr_gates ) + gate;
+    return step * block_size() + gate;
+  }
+
+  inline int move_var( int step, int move )
+  {
+    return step * block_size() + _nr_gates + extra + move;
+  }
+
+  inline int card_var( int step, int gate, int k )
+  {
+    return step * block_size() + _nr_gates + gate * _max_pebbles + k;
+  }
+
+  inline int block_size() const
+  {
+    return _nr_gates + extra + _nr_moves;
+  }
+
+  bool has_counter() const
+  {
+    return _max_pebbles > 0 && _max_pebbles < _nr_gates;
+  }
+
+  bool is_parity( mockturtle::node<Network> const& n ) const
+  {
+    if constexpr ( mockturtle::has_is_xor_v<Network> )
+    {
+      if ( _net.is_xor( n ) )
+        return true;
+    }
+    if constexpr ( mockturtle::has_is_xor3_v<Network> )
+    {
+      if ( _net.is_xor3( n ) )
+        return true;
+    }
+    return false;
   }
 
   Steps extract_result()
   {
     Steps steps;
 
+    /* gates taking part in in-place moves keep their schedule */
+    std::vector<bool> fixed( _nr_gates, false );
+    for ( auto const& moves : inplace_model )
+    {
+      for ( auto m : moves )
+      {
+        fixed[inplace_moves[m].first] = true;
+        fixed[inplace_moves[m].second] = true;
+      }
+    }
 
     /* remove redundant steps */
     mockturtle::fanout_view<Network> fanout_view{_net};
@@ -214,6 +418,9 @@ public:
     {
       for ( auto j = 0u; j < _nr_gates; ++j )
       {
+        if ( fixed[j] )
+          continue;
+
         /* Is j pebbled at step i? */
         if ( solution_model[i][j] && !solution_model[i - 1][j] )
         {
@@ -287,33 +494,25 @@ public:
     {
       auto it = steps.end();
 
+      /* in-place moves of this step: the target does not get an action of its own */
+      std::vector<int> inplace_target( _nr_gates, -1 );
+      std::vector<bool> consumed( _nr_gates, false );
+      for ( auto m : inplace_model[s] )
+      {
+        const auto [g, c] = inplace_moves[m];
+        inplace_target[g] = c;
+        consumed[c] = true;
+      }
+
       for ( auto n = 0u; n < _nr_gates; n++ )
       {
         if ( solution_model[s][n] != solution_model[s - 1][n] )
         {
-          bool inplace = false;
-          uint32_t target{};
+          if ( consumed[n] )
+            continue;
 
-#if 0
-          kitty::dynamic_truth_table tt = _net.node_function( gate_to_index[n] );
-          auto clone = tt.construct();
-          kitty::create_parity( clone );
-
-          if ( !o_set.count( index_to_gate[n] ) && clone == tt )
-          {
-            _net.foreach_fanin(index_to_gate[n], [&] (auto ch_signal)
-            {
-              auto ch_node = _net.get_node(ch_signal);
-              if (_net.fanout_size(ch_node) == 1)
-              {
-                inplace = true;
-                target = _net.node_to_index( ch_node );
-                return false;
-              }
-              return true;
-            });
-          }
-#endif
+          const bool inplace = inplace_target[n] != -1;
+          const uint32_t target = inplace ? _net.node_to_index( index_to_gate[inplace_target[n]] ) : 0u;
 
           if ( !solution_model[s][n] )
           {
@@ -351,14 +550,48 @@ private:
   mockturtle::node_map<int, Network> gate_to_index;
   std::unordered_set<mockturtle::node<Network>> o_set;
 
-  percy::bsat_wrapper solver;
+  Solver solver;
   Network const& _net;
   model solution_model;
+  model inplace_model;
+  std::vector<std::pair<uint32_t, uint32_t>> inplace_moves;
+  std::vector<std::vector<uint32_t>> moves_of;
+  std::vector<std::vector<uint32_t>> moves_onto;
   uint32_t _pebbles;
+  uint32_t _max_pebbles;
   uint32_t _nr_gates;
   uint32_t _nr_steps = 0;
   uint32_t extra;
+  uint32_t _nr_moves = 0;
   uint32_t conflict_limit;
+  std::vector<int> assumptions;
+
+  static constexpr uint32_t conflicts_per_slice = 1000u;
+
+  /* final pebbling configuration and the current pebble limit in all steps */
+  void prepare_assumptions()
+  {
+    if constexpr ( has_freeze_v<Solver> )
+    {
+      for ( auto i = 0u; i < _nr_gates; ++i )
+      {
+        if ( _nr_steps > 0 )
+          solver.freeze( pebble_var( _nr_steps - 1, i ), false );
+        solver.freeze( pebble_var( _nr_steps, i ), true );
+      }
+    }
+
+    assumptions.resize( _nr_gates );
+    _net.foreach_gate( [&]( auto n, auto i ) {
+      assumptions[i] = pabc::Abc_Var2Lit( pebble_var( _nr_steps, i ), o_set.count( n ) ? 0 : 1 );
+    } );
+
+    if ( has_counter() && _pebbles < _max_pebbles )
+    {
+      for ( auto s = 1u; s <= _nr_steps; ++s )
+        assumptions.push_back( pabc::Abc_Var2Lit( card_var( s, _nr_gates - 1, _pebbles ), 1 ) );
+    }
+  }
 };
 
 } // namespace caterpillar
@@ -0,0 +1,200 @@
+/*------------------------------------------------------------------------------
+| This file is distributed under the MIT License.
+| See accompanying file /LICENSE for details.
+*-----------------------------------------------------------------------------*/
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <bill/sat/solver.hpp>
+#include <percy/solvers/bsat2.hpp>
+
+namespace caterpillar
+{
+
+/*! \brief SAT backends for the CNF encodings.
+ *
+ * The CNF based solvers (`bsat_pebble_solver`, `satbased_cnotrz`) talk to
+ * their SAT solver through the interface of `percy::bsat_wrapper`:
+ *
+ * - `set_nr_vars( int )`
+ * - `add_clause( pabc::lit*, pabc::lit* )`
+ * - `solve( pabc::lit*, pabc::lit*, int conflict_limit )` returning a `percy::synth_result`
+ * - `var_value( int )`
+ *
+ * Literals are encoded as in ABC, i.e., `2 * var + complemented`.  A backend
+ * may additionally implement `freeze( int, bool )`, in which case the
+ * encodings freeze the variables that are still referenced by clauses added
+ * later on, and all other variables are subject to variable elimination.
+ */
+
+/*! \brief ABC's bsat solver (default backend). */
+using bsat_backend = percy::bsat_wrapper;
+
+/*! \brief Backend for the solvers that are exposed by bill.
+ *
+ * Available solvers are `bill::solvers::glucose_41`, `bill::solvers::ghack`,
+ * `bill::solvers::maple`, `bill::solvers::bsat2`, and `bill::solvers::bmcg`.
+ */
+template<bill::solvers Solver>
+class bill_backend
+{
+public:
+  void set_nr_vars( int nr_vars )
+  {
+    while ( static_cast<int>( solver.num_variables() ) < nr_vars )
+    {
+      solver.add_variable();
+    }
+  }
+
+  int add_clause( pabc::lit* begin, pabc::lit* end )
+  {
+    clause.clear();
+    for ( auto it = begin; it != end; ++it )
+    {
+      set_nr_vars( ( *it >> 1 ) + 1 );
+      clause.emplace_back( *it >> 1, ( *it & 1 ) ? bill::negative_polarity : bill::positive_polarity );
+    }
+    return solver.add_clause( clause );
+  }
+
+  percy::synth_result solve( pabc::lit* begin, pabc::lit* end, int conflict_limit )
+  {
+    clause.clear();
+    for ( auto it = begin; it != end; ++it )
+    {
+      set_nr_vars( ( *it >> 1 ) + 1 );
+      clause.emplace_back( *it >> 1, ( *it & 1 ) ? bill::negative_polarity : bill::positive_polarity );
+    }
+
+    /* bill returns the cached result of the previous call, regardless of the
+     * assumptions, unless a clause was added since; the tautology marks the
+     * solver dirty such that every call solves again */
+    set_nr_vars( 1 );
+    solver.add_clause( std::vector<bill::lit_type>{{0, bill::positive_polarity}, {0, bill::negative_polarity}} );
+
+    switch ( solver.solve( clause, conflict_limit ) )
+    {
+    case bill::result::states::satisfiable:
+      model = solver.get_model().model();
+      return percy::success;
+    case bill::result::states::unsatisfiable:
+      return percy::failure;
+    default:
+      return percy::timeout;
+    }
+  }
+
+  int var_value( int var ) const
+  {
+    return var < static_cast<int>( model.size() ) && model[var] == bill::lbool_type::true_;
+  }
+
+private:
+  bill::solver<Solver> solver;
+  std::vector<bill::lit_type> clause;
+  bill::result::model_type model;
+};
+
+/*! \brief Glucose with variable elimination (SatELite style preprocessing).
+ *
+ * Variables are eliminated before each call to `solve`, except for the ones
+ * that are frozen.  Values of eliminated variables are restored in the
+ * model.
+ */
+class glucose_simp_backend
+{
+public:
+  glucose_simp_backend()
+      : solver( std::make_unique<Glucose::SimpSolver>() )
+  {
+    /* silence elimination statistics */
+    solver->verbosity = -1;
+  }
+
+  void set_nr_vars( int nr_vars )
+  {
+    while ( solver->nVars() < nr_vars )
+    {
+      solver->newVar();
+    }
+  }
+
+  int add_clause( pabc::lit* begin, pabc::lit* end )
+  {
+    clause.clear();
+    for ( auto it = begin; it != end; ++it )
+    {
+      set_nr_vars( ( *it >> 1 ) + 1 );
+      clause.push( Glucose::mkLit( *it >> 1, *it & 1 ) );
+    }
+    return solver->addClause_( clause );
+  }
+
+  /*! \brief Protects variable from elimination, must be set for all variables in future clauses. */
+  void freeze( int var, bool value = true )
+  {
+    set_nr_vars( var + 1 );
+    solver->setFrozen( var, value );
+  }
+
+  percy::synth_result solve( pabc::lit* begin, pabc::lit* end, int conflict_limit )
+  {
+    clause.clear();
+    for ( auto it = begin; it != end; ++it )
+    {
+      set_nr_vars( ( *it >> 1 ) + 1 );
+      clause.push( Glucose::mkLit( *it >> 1, *it & 1 ) );
+    }
+
+    if ( conflict_limit )
+    {
+      solver->setConfBudget( conflict_limit );
+    }
+    else
+    {
+      solver->budgetOff();
+    }
+
+    const auto result = solver->solveLimited( clause );
+    if ( result == Glucose::l_True )
+    {
+      return percy::success;
+    }
+    else if ( result == Glucose::l_False )
+    {
+      return percy::failure;
+    }
+    return percy::timeout;
+  }
+
+  int var_value( int var ) const
+  {
+    return var < solver->model.size() && solver->model[var] == Glucose::l_True;
+  }
+
+private:
+  std::unique_ptr<Glucose::SimpSolver> solver;
+  Glucose::vec<Glucose::Lit> clause;
+};
+
+#pragma region has_freeze
+template<class Solver, class = void>
+struct has_freeze : std::false_type
+{
+};
+
+template<class Solver>
+struct has_freeze<Solver, std::void_t<decltype( std::declval<Solver>().freeze( int(), bool() ) )>> : std::true_type
+{
+};
+
+template<class Solver>
+inline constexpr bool has_freeze_v = has_freeze<Solver>::value;
+#pragma endregion
+
+} // namespace caterpillar
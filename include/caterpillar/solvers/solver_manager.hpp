@@ -1,8 +1,16 @@
 #pragma once
 
+#include <algorithm>
 #include <chrono>
+#include <functional>
+#include <optional>
 #include <mockturtle/utils/progress_bar.hpp>
+#include <mockturtle/utils/stopwatch.hpp>
+#include <caterpillar/details/synthesis_profile.hpp>
+#include <caterpillar/details/trace.hpp>
 #include <caterpillar/synthesis/strategies/action.hpp>
+#include <caterpillar/synthesis/strategies/bennett_mapping_strategy.hpp>
+#include <caterpillar/synthesis/strategies/eager_mapping_strategy.hpp>
 #include <caterpillar/solvers/z3_solver.hpp>
 #include <type_traits>
 #include <limits>
@@ -33,7 +41,12 @@ struct pebbling_mapping_strategy_params
   /*! \brief Timeout for the solver in milliseconds. */
   uint32_t solver_timeout{0};
 
-  /*! \brief Timeout for the iterative quests in seconds. */
+  /*! \brief Timeout for the iterative quests in seconds.
+   *
+   * Solvers that implement `solve( deadline )` give up within a slice of
+   * conflicts after the timeout; other solvers get the remaining time as
+   * solver timeout.
+   */
   uint32_t search_timeout{30};
 
   /*! \brief Increment pebble numbers, if a failure occurs. */
@@ -45,72 +58,308 @@ struct pebbling_mapping_strategy_params
   /*! \brief Decrement max weight, if satisfiable. */
   bool optimize_weight{false};
 
+  /*! \brief Anytime search.
+   *
+   * Starts from the cheaper of the Bennett and the eager strategy and asks
+   * the solver for strategies with fewer pebbles, until `search_timeout`
+   * expires.  The best strategy found so far is returned.  A non-zero
+   * `pebble_limit` stops the search as soon as it is met.
+   */
+  bool anytime{false};
+
+  /*! \brief Called in anytime search with the number of pebbles of each new best strategy. */
+  std::function<void( uint32_t )> progress_callback{};
+};
+
+struct pebbling_mapping_strategy_stats
+{
+  /*! \brief Total runtime. */
+  mockturtle::stopwatch<>::duration time_total{0};
+
+  /*! \brief Number of solver calls. */
+  uint32_t num_solver_calls{0u};
+
+  /*! \brief Whether a search was stopped at the search timeout. */
+  bool timeout{false};
+
+  /*! \brief Per-phase timers and counters.
+   *
+   * The strategy phase is SAT solving, the input phase is the encoding of
+   * the steps, and the emission phase extracts the steps from the model.
+   * The peak number of ancillae is the peak number of pebbles.
+   */
+  synthesis_profile profile;
+
+  void report() const
+  {
+    std::cout << fmt::format( "[i] total time   = {:>5.2f} secs\n", mockturtle::to_seconds( time_total ) );
+    std::cout << fmt::format( "[i] solver calls = {}\n", num_solver_calls );
+    profile.report();
+  }
 };
 
 template<typename Ntk>
 using Steps = std::vector<std::pair<typename Ntk::node, mapping_strategy_action>>;
 
-template <typename Solver, typename Ntk>
-inline Steps<Ntk> pebble (Ntk ntk, pebbling_mapping_strategy_params const& ps = {})
+/*! \brief Maximum number of pebbled nodes over a sequence of steps. */
+template<typename Ntk>
+inline uint32_t peak_pebbles( Steps<Ntk> const& steps )
 {
-  assert( !ps.decrement_pebbles_on_success || !ps.increment_pebbles_on_failure );
-  assert( !ps.decrement_pebbles_on_success || !ps.optimize_weight );
-  assert( !ps.increment_pebbles_on_failure || !ps.optimize_weight );
+  uint32_t pebbles{0u}, peak{0u};
+  for ( auto const& [_, action] : steps )
+  {
+    if ( std::holds_alternative<compute_action>( action ) )
+    {
+      peak = std::max( peak, ++pebbles );
+    }
+    else if ( std::holds_alternative<uncompute_action>( action ) )
+    {
+      --pebbles;
+    }
+  }
+  return peak;
+}
 
-  auto limit = ps.pebble_limit;
-  
-  auto start = high_resolution_clock::now(); 
+namespace detail
+{
 
-  Steps<Ntk> steps;
-  while ( true )
-  {
-    Solver solver( ntk, limit, ps.conflict_limit, ps.solver_timeout);
-    typename Solver::result result;
+#pragma region solver traits
+template<class Solver, class = void>
+struct has_set_pebble_limit : std::false_type
+{
+};
 
-    solver.init();
+template<class Solver>
+struct has_set_pebble_limit<Solver, std::void_t<decltype( std::declval<Solver>().set_pebble_limit( uint32_t() ) )>> : std::true_type
+{
+};
 
-    mockturtle::progress_bar bar( 100, "|{0}| current step = {1}", ps.progress );
+template<class Solver>
+inline constexpr bool has_set_pebble_limit_v = has_set_pebble_limit<Solver>::value;
 
-    do
-    {
-      if ( solver.current_step() >= ps.max_steps )
+template<class Solver, class = void>
+struct has_solve_with_deadline : std::false_type
+{
+};
+
+template<class Solver>
+struct has_solve_with_deadline<Solver, std::void_t<decltype( std::declval<Solver>().solve( std::declval<steady_clock::time_point>() ) )>> : std::true_type
+{
+};
+
+template<class Solver>
+inline constexpr bool has_solve_with_deadline_v = has_solve_with_deadline<Solver>::value;
+#pragma endregion
+
+/* solver timeout in milliseconds, bounded by the time left until `deadline` */
+inline uint32_t remaining_timeout( pebbling_mapping_strategy_params const& ps, steady_clock::time_point const& deadline )
+{
+  const auto left = duration_cast<milliseconds>( deadline - steady_clock::now() ).count();
+  const auto remaining = static_cast<uint32_t>( std::max<int64_t>( left, 1 ) );
+  return ps.solver_timeout ? std::min( ps.solver_timeout, remaining ) : remaining;
+}
+
+/* adds steps to `solver` until it finds a strategy, the step limit is
+ * reached, or `deadline` passes; with `resume`, the current number of steps
+ * is solved first (e.g., after a tighter pebble limit has been set) */
+template<typename Solver, typename Ntk>
+inline std::optional<Steps<Ntk>> search_steps( Solver& solver, bool resume, pebbling_mapping_strategy_params const& ps,
+                                               steady_clock::time_point const& deadline, pebbling_mapping_strategy_stats& st )
+{
+  typename Solver::result result = solver.unsat();
+  const auto solve = [&]() {
+    result = mockturtle::call_with_stopwatch( st.profile.time_strategy, [&]() {
+      CATERPILLAR_TRACE_SPAN( "solve" );
+      if constexpr ( has_solve_with_deadline_v<Solver> )
       {
-        result = solver.unknown();
-        break;
+        return solver.solve( deadline );
+      }
+      else
+      {
+        return solver.solve();
       }
+    } );
+    ++st.num_solver_calls;
+  };
+
+  mockturtle::progress_bar bar( 100, "|{0}| current step = {1}", ps.progress );
 
-      bar( std::min<uint32_t>( solver.current_step(), 100 ), solver.current_step() );
+  if ( resume && solver.current_step() > 0 )
+  {
+    solve();
+  }
 
+  while ( result == solver.unsat() && steady_clock::now() < deadline )
+  {
+    if ( solver.current_step() >= ps.max_steps )
+    {
+      result = solver.unknown();
+      break;
+    }
+
+    bar( std::min<uint32_t>( solver.current_step(), 100 ), solver.current_step() );
+
+    mockturtle::call_with_stopwatch( st.profile.time_inputs, [&]() {
+      CATERPILLAR_TRACE_SPAN( "add_step" );
       solver.add_step();
-      result = solver.solve(); 
+    } );
+    solve();
+  }
+
+  if ( result != solver.sat() )
+  {
+    st.timeout |= steady_clock::now() >= deadline;
+    return std::nullopt;
+  }
+
+  mockturtle::stopwatch<> t_extract( st.profile.time_emission );
+  solver.save_model();
+  #ifdef USE_Z3
+         
+  if(ps.optimize_weight)
+  {
+    if constexpr (std::is_same_v<Solver, z3_pebble_solver<Ntk>>)
+    { 
+      solver.optimize_solution();
+    }
+  }
+
+  #endif
+
+  return solver.extract_result();
+}
+
+template<typename Solver, typename Ntk>
+inline std::optional<Steps<Ntk>> pebble_with_limit( Ntk const& ntk, uint32_t limit, pebbling_mapping_strategy_params const& ps,
+                                                    steady_clock::time_point const& deadline, pebbling_mapping_strategy_stats& st )
+{
+  const auto init_start = steady_clock::now();
+  Solver solver( ntk, limit, ps.conflict_limit, remaining_timeout( ps, deadline ) );
+  solver.init();
+  st.profile.time_inputs += steady_clock::now() - init_start;
 
-    } while ( result == solver.unsat() && 
-        duration_cast<seconds>(high_resolution_clock::now() - start).count() <= ps.search_timeout);
+  return search_steps<Solver, Ntk>( solver, false, ps, deadline, st );
+}
+
+template<typename Solver, typename Ntk>
+inline Steps<Ntk> pebble_anytime( Ntk const& ntk, pebbling_mapping_strategy_params const& ps,
+                                  steady_clock::time_point const& deadline, pebbling_mapping_strategy_stats& st )
+{
+  /* incumbent */
+  Steps<Ntk> best;
+  bennett_mapping_strategy<Ntk> bennett;
+  bennett.compute_steps( ntk );
+  bennett.foreach_step( [&]( auto const& n, auto const& a ) { best.emplace_back( n, a ); } );
+
+  if constexpr ( mockturtle::has_fanout_size_v<Ntk> )
+  {
+    Steps<Ntk> eager_steps;
+    eager_mapping_strategy<Ntk> eager;
+    eager.compute_steps( ntk );
+    eager.foreach_step( [&]( auto const& n, auto const& a ) { eager_steps.emplace_back( n, a ); } );
 
-    if ( result == solver.unknown() || result == solver.unsat() )
+    if ( peak_pebbles<Ntk>( eager_steps ) < peak_pebbles<Ntk>( best ) )
     {
-      if ( ps.increment_pebbles_on_failure )
+      best = eager_steps;
+    }
+  }
+
+  auto best_peak = peak_pebbles<Ntk>( best );
+  if ( ps.progress_callback )
+  {
+    ps.progress_callback( best_peak );
+  }
+
+  const auto target = std::max( ps.pebble_limit, 1u );
+  const auto improve = [&]( Steps<Ntk> const& steps ) {
+    if ( const auto peak = peak_pebbles<Ntk>( steps ); peak < best_peak )
+    {
+      best = steps;
+      best_peak = peak;
+      if ( ps.progress_callback )
       {
-        limit++;
-        continue;
+        ps.progress_callback( best_peak );
       }
     }
-    else if ( result == solver.sat() )
+  };
+
+  if constexpr ( has_set_pebble_limit_v<Solver> )
+  {
+    /* one solver for all limits, each limit is assumed on top of the previous unrolling */
+    if ( best_peak > target && best_peak - 1 < ntk.num_gates() && steady_clock::now() < deadline )
     {
-      solver.save_model();
-      #ifdef USE_Z3
-             
-      if(ps.optimize_weight)
+      const auto init_start = steady_clock::now();
+      Solver solver( ntk, best_peak - 1, ps.conflict_limit, remaining_timeout( ps, deadline ) );
+      solver.init();
+      st.profile.time_inputs += steady_clock::now() - init_start;
+
+      auto resume = false;
+      while ( steady_clock::now() < deadline )
       {
-        if constexpr (std::is_same_v<Solver, z3_pebble_solver<Ntk>>)
-        { 
-          solver.optimize_solution();
+        const auto steps = search_steps<Solver, Ntk>( solver, resume, ps, deadline, st );
+        if ( !steps )
+        {
+          break;
         }
+
+        improve( *steps );
+        if ( best_peak <= target )
+        {
+          break;
+        }
+        solver.set_pebble_limit( best_peak - 1 );
+        resume = true;
+      }
+    }
+  }
+  else
+  {
+    auto limit = best_peak;
+    while ( limit > target && steady_clock::now() < deadline )
+    {
+      const auto steps = pebble_with_limit<Solver>( ntk, limit - 1, ps, deadline, st );
+      if ( !steps )
+      {
+        break;
       }
 
-      #endif
+      improve( *steps );
+      limit = std::min( limit - 1, best_peak );
+    }
+  }
+
+  st.timeout |= best_peak > target && steady_clock::now() >= deadline;
+  return best;
+}
 
-      steps = solver.extract_result();
+template<typename Solver, typename Ntk>
+inline Steps<Ntk> pebble_impl( Ntk const& ntk, pebbling_mapping_strategy_params const& ps, pebbling_mapping_strategy_stats& st )
+{
+  auto limit = ps.pebble_limit;
+  
+  const auto deadline = steady_clock::now() + seconds( ps.search_timeout );
+
+  if ( ps.anytime )
+  {
+    return detail::pebble_anytime<Solver>( ntk, ps, deadline, st );
+  }
+
+  Steps<Ntk> steps;
+  while ( true )
+  {
+    const auto result = detail::pebble_with_limit<Solver>( ntk, limit, ps, deadline, st );
+
+    if ( !result )
+    {
+      if ( ps.increment_pebbles_on_failure && steady_clock::now() < deadline )
+      {
+        limit++;
+        continue;
+      }
+    }
+    else
+    {
+      steps = *result;
 
       if ( ps.decrement_pebbles_on_success && limit > 1)
       {
@@ -122,7 +371,42 @@ inline Steps<Ntk> pebble (Ntk ntk, pebbling_mapping_strategy_params const& ps =
 
     return steps;
   }
+}
+
+} // namespace detail
+
+template <typename Solver, typename Ntk>
+inline Steps<Ntk> pebble (Ntk ntk, pebbling_mapping_strategy_params const& ps = {}, pebbling_mapping_strategy_stats* pst = nullptr)
+{
+  assert( !ps.decrement_pebbles_on_success || !ps.increment_pebbles_on_failure );
+  assert( !ps.decrement_pebbles_on_success || !ps.optimize_weight );
+  assert( !ps.increment_pebbles_on_failure || !ps.optimize_weight );
+
+  pebbling_mapping_strategy_stats st;
+  const detail::peak_memory_tracker memory;
+  const auto steps = mockturtle::call_with_stopwatch( st.time_total, [&]() { return detail::pebble_impl<Solver>( ntk, ps, st ); } );
+
+  uint32_t pebbles{0u};
+  for ( auto const& [_, action] : steps )
+  {
+    st.profile.count_action( action );
+    if ( std::holds_alternative<compute_action>( action ) )
+    {
+      st.profile.update_ancillae( ++pebbles );
+    }
+    else if ( std::holds_alternative<uncompute_action>( action ) )
+    {
+      --pebbles;
+    }
+  }
+  st.profile.peak_memory_increase_bytes = memory.increase();
+
+  if ( pst )
+  {
+    *pst = st;
+  }
 
+  return steps;
 }
 
 }//caterpillar
\ No newline at end of file
@@ -25,6 +25,13 @@ namespace td = tweedledum;
   `_targets` a list of target qubits.
   
   X gates are applied to the targets whenever the control function evaluates to true.
+
+  A measured AND uncomputation (see `measured_and_uncompute`) has two
+  controls and one target that holds the AND of the controls, and resets the
+  target to 0.  It is stored as a LUT gate whose control function is the AND
+  of the controls, such that consumers that do not check `is_measurement`
+  treat it as the Toffoli gate it replaces, and consumers that do not
+  support LUT gates reject it.
 */
 class stg_gate : public td::gate_base
 {
@@ -60,11 +67,40 @@ public:
     _targets.push_back( target );
   }
 
+  /*! \brief Uncomputes the logical AND of `a` and `b` held by `target` by measurement.
+   *
+   * The target is measured in the X basis, a CZ on the controls (as literals)
+   * is applied if the outcome is 1, and the target is reset to 0.  Unlike a
+   * Toffoli gate this requires no T gates.  If `target` holds the AND of the
+   * controls, this is equivalent to `target ^= a & b`, which is how the
+   * verification algorithms simulate it.
+   */
+  static stg_gate measured_and_uncompute( td::qubit_id a, td::qubit_id b, td::qubit_id target )
+  {
+    kitty::dynamic_truth_table and_function( 2u );
+    kitty::create_from_hex_string( and_function, "8" );
+    stg_gate gate( and_function, {a, b}, target );
+    gate._measured = true;
+    return gate;
+  }
+
   bool is_unitary_gate() const
   {
     return td::gate_base::is_unitary_gate() || operation() == td::gate_set::num_defined_ops;
   }
 
+  /*! \brief Returns true if this is a measured AND uncomputation. */
+  bool is_measurement() const
+  {
+    return _measured;
+  }
+
+  /*! \brief Control function of a LUT gate (only valid if `operation()` is `num_defined_ops`). */
+  kitty::dynamic_truth_table const& function() const
+  {
+    return _function;
+  }
+
   uint32_t num_controls() const
   {
     return _controls.size();
@@ -112,6 +148,9 @@ private:
 
   /*! \brief set of target qubits in the network. */
   std::vector<td::qubit_id> _targets{};
+
+  /*! \brief target is uncomputed by measurement (see `measured_and_uncompute`). */
+  bool _measured{false};
 };
 
 } // namespace caterpillar
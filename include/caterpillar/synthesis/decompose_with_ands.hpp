@@ -1,88 +1,495 @@
-#include <tweedledum/networks/netlist.hpp>
-#include <tweedledum/gates/mcmt_gate.hpp>
+/*-------------------------------------------------------------------------------------------------
+| This file is distributed under the MIT License.
+| See accompanying file /LICENSE for details.
+| Author(s): Giulia Meuli
+*------------------------------------------------------------------------------------------------*/
+#pragma once
+
 #include <caterpillar/structures/stg_gate.hpp>
 
+#include <fmt/format.h>
+#include <tweedledum/gates/gate_base.hpp>
+#include <tweedledum/gates/gate_set.hpp>
+#include <tweedledum/networks/netlist.hpp>
+#include <tweedledum/networks/qubit.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
 namespace caterpillar
 {
-  using namespace tweedledum;
-
-  /*
-    /brief! 
-    transforms a reversible network result of the xag strategy in a quantum circuit
-    >>>>>>> would need support for classically controlled gates 
-  */
-  void decompose_with_ands( netlist<mcmt_gate>& qnet, netlist<stg_gate> const& rnet)
+
+namespace td = tweedledum;
+
+/*! \brief Streams a Clifford+T circuit with measurements in OpenQASM 2.0.
+ *
+ * Gates are written as soon as they are added, such that the circuit is
+ * never stored in memory.  Besides the usual `add_qubit` and `add_gate`
+ * interface, the writer implements `add_measurement_based_uncompute`, which
+ * `decompose_with_ands` uses to uncompute logical ANDs with a measurement
+ * followed by a classically controlled CZ.
+ */
+class qasm_stream
+{
+public:
+  explicit qasm_stream( std::ostream& os )
+      : os( os )
+  {
+  }
+
+  td::qubit_id add_qubit()
   {
-    //for each qubit create one in qnet and map the indices
-    std::map<uint32_t, uint32_t> q_to_rev_id;
+    assert( !header_written );
+    return td::qubit_id( num_qubits++ );
+  }
 
-    //check repeting ANDs for uncomputation
-    std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> ash;
+  void add_gate( td::gate_base op, td::qubit_id target )
+  {
+    write_header();
+    switch ( op.operation() )
+    {
+    case td::gate_set::hadamard:
+      os << fmt::format( "h q[{}];\n", target.index() );
+      break;
+    case td::gate_set::pauli_x:
+      os << fmt::format( "x q[{}];\n", target.index() );
+      break;
+    case td::gate_set::pauli_z:
+      os << fmt::format( "z q[{}];\n", target.index() );
+      break;
+    case td::gate_set::phase:
+      os << fmt::format( "s q[{}];\n", target.index() );
+      break;
+    case td::gate_set::phase_dagger:
+      os << fmt::format( "sdg q[{}];\n", target.index() );
+      break;
+    case td::gate_set::t:
+      os << fmt::format( "t q[{}];\n", target.index() );
+      break;
+    case td::gate_set::t_dagger:
+      os << fmt::format( "tdg q[{}];\n", target.index() );
+      break;
+    default:
+      assert( false && "unsupported single-qubit gate" );
+      break;
+    }
+    ++num_gates;
+  }
 
-    rnet.foreach_cqubit([&] ( const uint32_t cq)
+  void add_gate( td::gate_base op, td::qubit_id control, td::qubit_id target )
+  {
+    write_header();
+    switch ( op.operation() )
     {
-      uint32_t q = qnet.add_qubit();
-      q_to_rev_id[cq] = q;
-    });
+    case td::gate_set::cx:
+      os << fmt::format( "cx q[{}],q[{}];\n", control.index(), target.index() );
+      break;
+    case td::gate_set::cz:
+      os << fmt::format( "cz q[{}],q[{}];\n", control.index(), target.index() );
+      break;
+    default:
+      assert( false && "unsupported two-qubit gate" );
+      break;
+    }
+    ++num_gates;
+  }
+
+  /*! \brief Measures `target` in the X basis, applies CZ on `a` and `b` if the outcome is 1, and resets `target`. */
+  void add_measurement_based_uncompute( td::qubit_id target, td::qubit_id a, td::qubit_id b )
+  {
+    write_header();
+    os << fmt::format( "h q[{}];\n", target.index() );
+    os << fmt::format( "measure q[{}] -> m[0];\n", target.index() );
+    os << fmt::format( "if(m==1) cz q[{}],q[{}];\n", a.index(), b.index() );
+    os << fmt::format( "if(m==1) x q[{}];\n", target.index() );
+    num_gates += 4;
+  }
 
+  uint32_t size() const
+  {
+    return num_gates;
+  }
 
-    rnet.foreach_cgate([&] (const auto rgate)
+private:
+  void write_header()
+  {
+    if ( header_written )
     {
-      auto cs = rgate.gate.controls();
-      auto ts = rgate.gate.targets();
+      return;
+    }
+    os << "OPENQASM 2.0;\n";
+    os << "include \"qelib1.inc\";\n";
+    os << fmt::format( "qreg q[{}];\n", num_qubits );
+    os << "creg m[1];\n";
+    header_written = true;
+  }
 
-      assert ( rgate.gate.num_controls() <= 2 && rgate.gate.num_targets() == 1 );
+private:
+  std::ostream& os;
+  uint32_t num_qubits{0u};
+  uint32_t num_gates{0u};
+  bool header_written{false};
+};
 
-      if (rgate.gate.num_controls() == 1)
-      {
-        //CNOT
-        qnet.add_gate(gate::cx, 
-          q_to_rev_id[cs[0]], 
-          q_to_rev_id[ts[0]]);
+#pragma region has_add_measurement_based_uncompute
+template<class Ntk, class = void>
+struct has_add_measurement_based_uncompute : std::false_type
+{
+};
+
+template<class Ntk>
+struct has_add_measurement_based_uncompute<Ntk, std::void_t<decltype( std::declval<Ntk>().add_measurement_based_uncompute( td::qubit_id(), td::qubit_id(), td::qubit_id() ) )>> : std::true_type
+{
+};
+
+template<class Ntk>
+inline constexpr bool has_add_measurement_based_uncompute_v = has_add_measurement_based_uncompute<Ntk>::value;
+#pragma endregion
+
+struct decompose_with_ands_params
+{
+  /*! \brief Compute logical ANDs with T-depth 1 using a helper qubit. */
+  bool use_tdepth1{false};
+
+  /*! \brief Qubits of `rnet` that hold 0 throughout the circuit and serve as helpers.
+   *
+   * E.g., `logic_network_synthesis_stats::helper_qubits`.  Additional helpers
+   * are only added if more ANDs share a layer than qubits are given.
+   */
+  std::vector<uint32_t> helper_qubits;
+};
+
+struct decompose_with_ands_stats
+{
+  /*! \brief Number of logical ANDs computed with 4 T gates. */
+  uint32_t num_and_computes{0u};
+
+  /*! \brief Number of logical ANDs uncomputed without T gates. */
+  uint32_t num_and_uncomputes{0u};
+
+  /*! \brief Number of helper qubits added for T-depth-1 ANDs (not counting `helper_qubits`). */
+  uint32_t num_helpers{0u};
+
+  /*! \brief T-depth of the emitted circuit. */
+  uint32_t t_depth{0u};
+};
+
+namespace detail
+{
+
+/* controls of a Toffoli gate as sorted literals shifted by one, such that 0 marks a clean target */
+inline std::pair<uint32_t, uint32_t> and_key( std::vector<td::qubit_id> const& cs )
+{
+  auto key = std::make_pair( cs[0].literal() + 1, cs[1].literal() + 1 );
+  if ( key.first > key.second )
+  {
+    std::swap( key.first, key.second );
+  }
+  return key;
+}
+
+/* helper slot of each AND computation in `rnet`, such that ANDs in the same
+ * layer of `rnet` use different helpers; `num_helpers` is the largest number
+ * of ANDs in one layer */
+inline std::vector<uint32_t> assign_and_helpers( td::netlist<stg_gate> const& rnet, uint32_t& num_helpers )
+{
+  std::vector<uint32_t> layer( rnet.num_qubits(), 0u );
+  std::vector<std::pair<uint32_t, uint32_t>> ands( rnet.num_qubits(), {0u, 0u} );
+  std::vector<uint32_t> ands_in_layer;
+  std::vector<uint32_t> slots;
+  num_helpers = 0u;
+
+  rnet.foreach_cgate( [&]( auto const& rgate ) {
+    auto const& gate = rgate.gate;
+    uint32_t l{0u};
+    gate.foreach_control( [&]( auto const& q ) { l = std::max( l, layer[q.index()] ); } );
+    gate.foreach_target( [&]( auto const& q ) { l = std::max( l, layer[q.index()] ); } );
+    ++l;
+    gate.foreach_control( [&]( auto const& q ) { layer[q.index()] = l; } );
+    gate.foreach_target( [&]( auto const& q ) { layer[q.index()] = l; } );
+
+    const auto t = gate.targets()[0].index();
+    if ( gate.is_measurement() )
+    {
+      ands[t] = {0u, 0u};
+      return;
+    }
+    if ( gate.num_controls() != 2u )
+    {
+      return;
+    }
+
+    const auto key = and_key( gate.controls() );
+    if ( ands[t] == key )
+    {
+      ands[t] = {0u, 0u};
+      return;
+    }
+    ands[t] = key;
+
+    if ( ands_in_layer.size() <= l )
+    {
+      ands_in_layer.resize( l + 1u, 0u );
+    }
+    slots.push_back( ands_in_layer[l]++ );
+    num_helpers = std::max( num_helpers, slots.back() + 1u );
+  } );
+
+  return slots;
+}
+
+} // namespace detail
+
+/*! \brief Lowers a reversible network of the XAG strategy into Clifford+T.
+ *
+ * Each Toffoli gate of `rnet` either computes a logical AND onto a clean
+ * target, which is implemented with 4 T gates, or uncomputes the AND that
+ * has last been computed onto the same target with the same controls.
+ * Linear gates acting on the target in between (e.g., in-place XORs that are
+ * undone before the uncomputation) do not break the pairing.
+ * Pairing is done with one slot per target qubit, hence the lowering takes
+ * linear time in the number of gates and gates are added to `qnet` as they
+ * are produced.
+ *
+ * If `qnet` implements `add_measurement_based_uncompute` (e.g.,
+ * `qasm_stream`), uncomputation is an X-basis measurement of the target
+ * followed by a classically controlled CZ on the controls.  Otherwise, the
+ * measurement is deferred and the uncomputation is emitted as
+ * H(t) CCZ(t, a, b) H(t), i.e., a Toffoli gate that restores the target,
+ * where the CCZ is decomposed into 7 T gates in 3 layers.
+ *
+ * Gates created by `stg_gate::measured_and_uncompute` are always lowered as
+ * uncomputation.
+ *
+ * With `use_tdepth1`, the controls and the target are XORed into a helper
+ * qubit, such that the 4 T gates of an AND act on 4 different qubits and
+ * form a single T layer (Selinger's construction).  The helper is restored
+ * to 0 afterwards.  Helpers are shared by all layers of `rnet`, where ANDs in
+ * the same layer use different helpers, such that they remain parallel.
+ * The qubits in `helper_qubits` are used first, further helpers are added
+ * to `qnet` after the qubits of `rnet`.
+ *
+ * The T-depth in the statistics is the number of T layers in an
+ * as-soon-as-possible schedule of the T gates, in which S gates (emitted as
+ * two T gates) are not counted.
+ *
+ * Negated controls are implemented by conjugation with X gates.
+ */
+template<class QuantumNetwork>
+void decompose_with_ands( QuantumNetwork& qnet, td::netlist<stg_gate> const& rnet, decompose_with_ands_params const& ps, decompose_with_ands_stats* pst = nullptr )
+{
+  decompose_with_ands_stats st;
+
+  std::vector<uint32_t> helper_slots;
+  uint32_t num_slots{0u};
+  if ( ps.use_tdepth1 )
+  {
+    helper_slots = detail::assign_and_helpers( rnet, num_slots );
+  }
+
+  /* qubit of rnet to qubit of qnet, followed by the added helpers */
+  std::vector<td::qubit_id> qubits;
+  qubits.reserve( rnet.num_qubits() + num_slots );
+  rnet.foreach_cqubit( [&]( auto ) { qubits.emplace_back( qnet.add_qubit() ); } );
+  const auto num_rnet_qubits = static_cast<uint32_t>( qubits.size() );
+
+  /* qubit of each helper slot, given helpers first */
+  std::vector<uint32_t> helpers( ps.helper_qubits.begin(), ps.helper_qubits.begin() + std::min<std::size_t>( num_slots, ps.helper_qubits.size() ) );
+  while ( helpers.size() < num_slots )
+  {
+    helpers.push_back( static_cast<uint32_t>( qubits.size() ) );
+    qubits.emplace_back( qnet.add_qubit() );
+    ++st.num_helpers;
+  }
+
+  /* controls (as literals) of the AND currently held by each target, 0 if clean */
+  std::vector<std::pair<uint32_t, uint32_t>> ands( num_rnet_qubits, {0u, 0u} );
 
+  /* number of T layers before each qubit is free */
+  std::vector<uint32_t> t_levels( qubits.size(), 0u );
+
+  const auto add_gate = [&]( td::gate_base op, uint32_t q ) {
+    if ( op.is( td::gate_set::t ) || op.is( td::gate_set::t_dagger ) )
+    {
+      st.t_depth = std::max( st.t_depth, ++t_levels[q] );
+    }
+    qnet.add_gate( op, qubits[q] );
+  };
+  const auto add_cx = [&]( uint32_t c, uint32_t t ) {
+    t_levels[c] = t_levels[t] = std::max( t_levels[c], t_levels[t] );
+    qnet.add_gate( td::gate::cx, qubits[c], qubits[t] );
+  };
+  const auto add_s = [&]( uint32_t q ) {
+    qnet.add_gate( td::gate::t, qubits[q] );
+    qnet.add_gate( td::gate::t, qubits[q] );
+  };
+
+  const auto negate_controls = [&]( std::vector<td::qubit_id> const& cs ) {
+    for ( auto const& c : cs )
+    {
+      if ( c.is_complemented() )
+      {
+        add_gate( td::gate::pauli_x, c.index() );
       }
-      else if (rgate.gate.num_controls() == 2)
+    }
+  };
+
+  const auto compute_and = [&]( uint32_t a, uint32_t b, uint32_t c ) {
+    add_gate( td::gate::hadamard, c );
+    add_gate( td::gate::t, c );
+    add_cx( a, c );
+    add_cx( b, c );
+    add_cx( c, a );
+    add_cx( c, b );
+    add_gate( td::gate::t_dagger, a );
+    add_gate( td::gate::t_dagger, b );
+    add_gate( td::gate::t, c );
+    add_cx( c, a );
+    add_cx( c, b );
+    add_gate( td::gate::hadamard, c );
+    add_s( c );
+  };
+
+  /* T gates on c, a ^ c, b ^ c, and a ^ b ^ c (in helper h) */
+  const auto compute_and_tdepth1 = [&]( uint32_t a, uint32_t b, uint32_t c, uint32_t h ) {
+    add_gate( td::gate::hadamard, c );
+    add_cx( c, a );
+    add_cx( c, b );
+    add_cx( a, h );
+    add_cx( b, h );
+    add_cx( c, h );
+    add_gate( td::gate::t, c );
+    add_gate( td::gate::t_dagger, a );
+    add_gate( td::gate::t_dagger, b );
+    add_gate( td::gate::t, h );
+    add_cx( c, h );
+    add_cx( b, h );
+    add_cx( a, h );
+    add_cx( c, b );
+    add_cx( c, a );
+    add_gate( td::gate::hadamard, c );
+    add_s( c );
+  };
+
+  /* phases T on a, b, c, and a ^ b ^ c, and T^dagger on a ^ b, a ^ c, and b ^ c */
+  const auto add_ccz = [&]( uint32_t a, uint32_t b, uint32_t c ) {
+    add_gate( td::gate::t, a );
+    add_gate( td::gate::t, b );
+    add_gate( td::gate::t, c );
+    add_cx( a, b );
+    add_cx( c, a );
+    add_cx( b, c );
+    add_gate( td::gate::t_dagger, a );
+    add_gate( td::gate::t_dagger, b );
+    add_gate( td::gate::t, c );
+    add_cx( a, b );
+    add_gate( td::gate::t_dagger, b );
+    add_cx( a, b );
+    add_cx( b, c );
+    add_cx( c, a );
+    add_cx( a, b );
+  };
+
+  const auto uncompute_and = [&]( uint32_t a, uint32_t b, uint32_t c ) {
+    if constexpr ( has_add_measurement_based_uncompute_v<QuantumNetwork> )
+    {
+      const auto level = std::max( {t_levels[a], t_levels[b], t_levels[c]} );
+      t_levels[a] = t_levels[b] = t_levels[c] = level;
+      qnet.add_measurement_based_uncompute( qubits[c], qubits[a], qubits[b] );
+    }
+    else
+    {
+      add_gate( td::gate::hadamard, c );
+      add_ccz( a, b, c );
+      add_gate( td::gate::hadamard, c );
+    }
+  };
+
+  uint32_t next_and{0u};
+  rnet.foreach_cgate( [&]( auto const& rgate ) {
+    auto const& gate = rgate.gate;
+    assert( gate.num_controls() <= 2 && gate.num_targets() == 1 );
+
+    const auto cs = gate.controls();
+    const auto t = gate.targets()[0].index();
+
+    if ( gate.is_measurement() )
+    {
+      assert( ands[t] == detail::and_key( cs ) && "measured uncomputation of an AND that the target does not hold" );
+      negate_controls( cs );
+      uncompute_and( cs[0].index(), cs[1].index(), t );
+      negate_controls( cs );
+
+      ands[t] = {0u, 0u};
+      ++st.num_and_uncomputes;
+      return;
+    }
+
+    switch ( gate.num_controls() )
+    {
+    case 0u:
+      add_gate( td::gate::pauli_x, t );
+      break;
+
+    case 1u:
+      add_cx( cs[0].index(), t );
+      if ( cs[0].is_complemented() )
       {
-        //AND
-        auto a = q_to_rev_id[ cs[0] ];
-        auto b = q_to_rev_id[ cs[1] ];
-        auto c = q_to_rev_id[ ts[0] ];
+        add_gate( td::gate::pauli_x, t );
+      }
+      break;
+
+    case 2u:
+    {
+      const auto a = cs[0].index();
+      const auto b = cs[1].index();
+      const auto key = detail::and_key( cs );
 
-        if (std::find(ash.begin(), ash.end(), std::make_tuple(a, b, c)) == ash.end())
+      negate_controls( cs );
+      if ( ands[t] != key )
+      {
+        /* the AND constructions assume a clean target */
+        assert( ands[t] == std::make_pair( 0u, 0u ) && "AND computed onto a target that holds another AND" );
+        if ( ps.use_tdepth1 )
         {
-          qnet.add_gate(gate::hadamard, c);
-          qnet.add_gate(gate::t, c);
-          qnet.add_gate(gate::cx, a, c);
-          qnet.add_gate(gate::cx, b, c);
-          qnet.add_gate(gate::cx, c, a);
-          qnet.add_gate(gate::cx, c, b);
-          qnet.add_gate(gate::t_dagger, a);
-          qnet.add_gate(gate::t_dagger, b);
-          qnet.add_gate(gate::t, c);
-          qnet.add_gate(gate::cx, c, a);
-          qnet.add_gate(gate::cx, c, b);
-          qnet.add_gate(gate::hadamard, c);
-          //s gate
-          qnet.add_gate(gate::t, c);
-          qnet.add_gate(gate::t, c);
-
-          ash.push_back(std::make_tuple(a, b, c));
+          compute_and_tdepth1( a, b, t, helpers[helper_slots[next_and++]] );
         }
         else
         {
-          // worst case uncomputing 
-          // >>>>>>>>>>>>>> error in functionality <<<<<<<<<<<<<<<<<<<
-          //creg out[1];
-          qnet.add_gate(gate::hadamard, c);
-          qnet.add_gate(gate::cz, a, b);
-          qnet.add_gate(gate::pauli_x, c);
+          compute_and( a, b, t );
         }
 
+        ands[t] = key;
+        ++st.num_and_computes;
       }
+      else
+      {
+        uncompute_and( a, b, t );
 
-    });
-
+        ands[t] = {0u, 0u};
+        ++st.num_and_uncomputes;
+      }
+      negate_controls( cs );
+    }
+    break;
+    }
+  } );
 
+  if ( pst )
+  {
+    *pst = st;
   }
+}
+
+/*! \brief Lowers a reversible network of the XAG strategy into Clifford+T (default parameters). */
+template<class QuantumNetwork>
+void decompose_with_ands( QuantumNetwork& qnet, td::netlist<stg_gate> const& rnet, decompose_with_ands_stats* pst = nullptr )
+{
+  decompose_with_ands( qnet, rnet, {}, pst );
+}
 
-}
\ No newline at end of file
+} // namespace caterpillar
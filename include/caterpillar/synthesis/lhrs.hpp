@@ -5,9 +5,16 @@
 | Author(s): Giulia Meuli
 *-----------------------------------------------------------------------------*/
 #pragma once
+#include "../details/ancilla_pool.hpp"
+#include "../details/node_classification.hpp"
+#include "../details/peephole.hpp"
+#include "../details/synthesis_profile.hpp"
+#include "../details/trace.hpp"
 #include "../structures/stg_gate.hpp"
+#include "decompose_with_ands.hpp"
 #include "strategies/mapping_strategy.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <fmt/format.h>
@@ -17,8 +24,9 @@
 #include <mockturtle/utils/stopwatch.hpp>
 #include <mockturtle/views/topo_view.hpp>
 #include <tweedledum/algorithms/synthesis/stg.hpp>
-#include <stack>
+#include <optional>
 #include <fmt/format.h>
+#include <type_traits>
 #include <variant>
 #include <vector>
 
@@ -35,8 +43,29 @@ struct logic_network_synthesis_params
   /*! \brief Be verbose. */
   bool verbose{false};
 
+  /*! \brief Reserve helper qubits to emit ANDs with T-depth 1.
+   *
+   * For strategies that compute levels (XAG strategies), as many qubits as
+   * the largest level has ANDs are added before the first gate and never
+   * used; they are listed in `logic_network_synthesis_stats::helper_qubits`
+   * and are meant for `decompose_with_ands_params::helper_qubits`.
+   */
   bool low_tdepth_AND{false};
 
+  /*! \brief Order in which released ancillae are reused (default: the strategy's preference). */
+  std::optional<ancilla_policy> ancilla_allocation;
+
+  /*! \brief Cancel inverse pairs and merge X gates into control polarities before adding gates to the circuit. */
+  bool peephole{false};
+
+  /*! \brief Uncompute 2-input AND and OR nodes by measurement instead of a Toffoli gate.
+   *
+   * Requires a quantum network of `stg_gate`s, which receives
+   * `stg_gate::measured_and_uncompute` gates, or a network that implements
+   * `add_measurement_based_uncompute` (e.g., `resource_estimator`); for other
+   * networks the Toffoli gate is kept.
+   */
+  bool measurement_based_uncompute{false};
 };
 
 struct logic_network_synthesis_stats
@@ -53,15 +82,32 @@ struct logic_network_synthesis_stats
   /*! \brief input qubits. */
   std::vector<uint32_t> i_indexes;
 
+  /*! \brief Qubits reserved with `low_tdepth_AND`, which hold 0 throughout the circuit. */
+  std::vector<uint32_t> helper_qubits;
+
+  /*! \brief Per-phase timers and counters. */
+  synthesis_profile profile;
+
   void report() const
   {
     std::cout << fmt::format( "[i] total time = {:>5.2f} secs\n", mockturtle::to_seconds( time_total ) );
+    profile.report();
   }
 };
 
 namespace detail
 {
 
+template<class QuantumNetwork, class = void>
+struct has_stg_gates : std::false_type
+{
+};
+
+template<class QuantumNetwork>
+struct has_stg_gates<QuantumNetwork, std::enable_if_t<std::is_same_v<typename QuantumNetwork::gate_type, stg_gate>>> : std::true_type
+{
+};
+
 template<class QuantumNetwork, class LogicNetwork, class SingleTargetGateSynthesisFn>
 class logic_network_synthesis_impl
 {
@@ -72,25 +118,60 @@ public:
                                 SingleTargetGateSynthesisFn const& stg_fn,
                                 logic_network_synthesis_params const& ps,
                                 logic_network_synthesis_stats& st )
-      : qnet( qnet ), ntk( ntk ), strategy( strategy ), stg_fn( stg_fn ), ps( ps ), st( st )
+      : qnet( qnet ), ntk( ntk ), strategy( strategy ), stg_fn( stg_fn ), ps( ps ), st( st ),
+        free_ancillae( ps.ancilla_allocation.value_or( strategy.preferred_ancilla_policy() ) ),
+        node_classes( ntk )
   {
+    if ( ps.peephole )
+    {
+      peephole.emplace( qnet );
+    }
   }
 
   bool run()
   {
     mockturtle::stopwatch t( st.time_total );
-    prepare_inputs();
-    prepare_constant( false );
-    if ( ntk.get_node( ntk.get_constant( false ) ) != ntk.get_node( ntk.get_constant( true ) ) )
-      prepare_constant( true );
+    const peak_memory_tracker memory;
+    const auto gates_before = num_emitted_gates();
+    {
+      mockturtle::stopwatch t_inputs( st.profile.time_inputs );
+      prepare_inputs();
+      prepare_constant( false );
+      if ( ntk.get_node( ntk.get_constant( false ) ) != ntk.get_node( ntk.get_constant( true ) ) )
+        prepare_constant( true );
+    }
 
-    if ( const auto result = strategy.compute_steps( ntk ); !result )
+    const auto result = mockturtle::call_with_stopwatch( st.profile.time_strategy, [&]() {
+      CATERPILLAR_TRACE_SPAN( "compute_steps" );
+      return strategy.compute_steps( ntk );
+    } );
+    if ( !result )
     {
     
       std::cout << "[i] strategy could not be computed\n";
       return false;
     }
-    strategy.foreach_step( [&]( auto node, auto action ) {
+    if constexpr ( !mt::has_is_nary_xor_v<LogicNetwork> )
+    {
+      /* levels are emitted from the XOR fan-ins of XAG nodes */
+      auto has_levels = false;
+      strategy.foreach_step( [&]( auto const&, auto const& action ) {
+        has_levels = has_levels || std::holds_alternative<compute_level_action>( action ) || std::holds_alternative<uncompute_level_action>( action );
+      } );
+      if ( has_levels )
+      {
+        std::cerr << "[e] level steps require a network with n-ary XORs\n";
+        return false;
+      }
+    }
+    if ( ps.low_tdepth_AND )
+    {
+      reserve_helpers();
+    }
+
+    const auto emission_start = std::chrono::steady_clock::now();
+    strategy.foreach_step( [&]( auto const& node, auto const& action ) {
+      st.profile.count_action( action );
       std::visit(
           overloaded{
               []( auto ) {},
@@ -136,7 +217,9 @@ public:
                 }
                 else
                 {
+                  uncomputing = ps.measurement_based_uncompute;
                   compute_node( node, t );
+                  uncomputing = false;
                 }
                 release_ancilla( t );
               },
@@ -161,6 +244,12 @@ public:
               },
               [&]( uncompute_inplace_action const& action ) {
                 const auto t = node_to_qubit[node].top();
+
+                /* the target is restored into the qubit of node */
+                auto target_qubits = node_to_qubit[ntk.index_to_node( action.target_index )];
+                if ( target_qubits.empty() || target_qubits.top() != t )
+                  target_qubits.push( t );
+
                 if ( ps.verbose )
                 {
                   fmt::print("[i] uncompute {} inplace to {}\n", node , action.target_index);
@@ -188,7 +277,11 @@ public:
                 {
                   fmt::print("[i] compute level with node {}\n", action.level[0].first);
                 }
-                compute_level_with_copies(action.level);
+                /* rejected in run() for networks without n-ary XORs */
+                if constexpr ( mt::has_is_nary_xor_v<LogicNetwork> )
+                {
+                  compute_level_with_copies(action.level);
+                }
               },
               [&] (uncompute_level_action const& action){
                 if(!action.level.empty())
@@ -197,31 +290,129 @@ public:
                   {
                     fmt::print("[i] uncompute level with node {}\n", action.level[0].first);
                   }
-                  uncompute_level(action.level);
+                  if constexpr ( mt::has_is_nary_xor_v<LogicNetwork> )
+                  {
+                    uncompute_level(action.level);
+                  }
                 }
               }},
           action );
     } );
+    st.profile.time_emission += std::chrono::steady_clock::now() - emission_start;
 
-    prepare_outputs();
+    mockturtle::call_with_stopwatch( st.profile.time_outputs, [&]() {
+      CATERPILLAR_TRACE_SPAN( "prepare_outputs" );
+      prepare_outputs();
+    } );
+    if ( peephole )
+    {
+      peephole->flush();
+      st.profile.num_peephole_removed = peephole->num_removed();
+    }
+    st.profile.num_gates = num_emitted_gates() - gates_before;
+    st.profile.peak_memory_increase_bytes = memory.increase();
     return true;
   }
 
 private:
+  uint64_t num_emitted_gates() const
+  {
+    if constexpr ( mt::has_num_gates_v<QuantumNetwork> )
+    {
+      return qnet.num_gates();
+    }
+    else if constexpr ( mt::has_size_v<QuantumNetwork> )
+    {
+      return qnet.size();
+    }
+    else
+    {
+      return 0u;
+    }
+  }
+
+  /* layer after which qubit q is idle, in an ASAP schedule of the emitted gates */
+  uint32_t& ready_time( uint32_t q )
+  {
+    if ( q >= qubit_ready.size() )
+    {
+      qubit_ready.resize( q + 1u, 0u );
+    }
+    return qubit_ready[q];
+  }
+
+  /* schedules a block of `layers` layers acting on `qubits` */
+  void schedule( SetQubits const& qubits, uint32_t layers )
+  {
+    uint32_t level{0u};
+    for ( auto q : qubits )
+    {
+      level = std::max( level, ready_time( q ) );
+    }
+    for ( auto q : qubits )
+    {
+      ready_time( q ) = level + layers;
+    }
+  }
+
+  void add_gate( tweedledum::gate_base op, Qubit t )
+  {
+    ++ready_time( t );
+    if ( peephole )
+    {
+      peephole->add_gate( op, t );
+      return;
+    }
+    qnet.add_gate( op, t );
+  }
+
+  void add_gate( tweedledum::gate_base op, Qubit c, Qubit t )
+  {
+    ready_time( t ) = ready_time( c ) = std::max( ready_time( c ), ready_time( t ) ) + 1u;
+    if ( peephole )
+    {
+      peephole->add_gate( op, c, t );
+      return;
+    }
+    qnet.add_gate( op, c, t );
+  }
+
+  void add_gate( tweedledum::gate_base op, SetQubits const& controls, SetQubits const& targets )
+  {
+    uint32_t level{0u};
+    for ( auto q : controls )
+    {
+      level = std::max( level, ready_time( q ) );
+    }
+    for ( auto q : targets )
+    {
+      level = std::max( level, ready_time( q ) );
+    }
+    for ( auto q : controls )
+    {
+      ready_time( q ) = level + 1u;
+    }
+    for ( auto q : targets )
+    {
+      ready_time( q ) = level + 1u;
+    }
+    if ( peephole )
+    {
+      peephole->add_gate( op, controls, targets );
+      return;
+    }
+    qnet.add_gate( op, controls, targets );
+  }
+
   void prepare_inputs()
   {
     /* prepare primary inputs of logic network */
+    node_to_qubit.resize( ntk.size() );
     ntk.foreach_pi( [&]( auto n ) {
-      std::stack<uint32_t> sta;
-      sta.push( qnet.num_qubits() );
-      node_to_qubit[n] = sta;
+      node_to_qubit[n].push( qnet.num_qubits() );
       st.i_indexes.push_back( node_to_qubit[n].top() );
       qnet.add_qubit();
     } );
-    ntk.foreach_gate( [&]( auto n ) {
-      std::stack<uint32_t> sta;
-      node_to_qubit[n] = sta;
-    } );
   }
 
   void prepare_constant( bool value )
@@ -234,7 +425,28 @@ private:
     node_to_qubit[n].push( qnet.num_qubits() );
     qnet.add_qubit();
     if ( v )
-      qnet.add_gate( tweedledum::gate::pauli_x, node_to_qubit[n].top() );
+      add_gate( tweedledum::gate::pauli_x, node_to_qubit[n].top() );
+  }
+
+  /* qubits for the T-depth-1 ANDs of the largest level, added before any other ancilla */
+  void reserve_helpers()
+  {
+    if constexpr ( mt::has_is_nary_xor_v<LogicNetwork> )
+    {
+      std::size_t num_helpers{0u};
+      strategy.foreach_step( [&]( auto const&, auto const& action ) {
+        if ( const auto* level = std::get_if<compute_level_action>( &action ) )
+        {
+          num_helpers = std::max<std::size_t>( num_helpers, std::count_if( level->level.begin(), level->level.end(), [&]( auto const& p ) {
+                                                   return ntk.is_and( p.first );
+                                                 } ) );
+        }
+      } );
+      while ( st.helper_qubits.size() < num_helpers )
+      {
+        st.helper_qubits.push_back( request_ancilla() );
+      }
+    }
   }
 
   uint32_t request_ancilla()
@@ -244,12 +456,13 @@ private:
       const auto r = qnet.num_qubits();
       st.required_ancillae++;
       qnet.add_qubit();
+      st.profile.update_ancillae( st.required_ancillae - free_ancillae.size() );
       return r;
     }
     else
     {
-      const auto r = free_ancillae.top();
-      free_ancillae.pop();
+      const auto r = free_ancillae.acquire();
+      st.profile.update_ancillae( st.required_ancillae - free_ancillae.size() );
       return r;
     }
   }
@@ -264,10 +477,10 @@ private:
       {
         auto new_i = request_ancilla();
 
-        qnet.add_gate( tweedledum::gate::cx, node_to_qubit[ntk.node_to_index( node )].top(), new_i );
+        add_gate( tweedledum::gate::cx, node_to_qubit[ntk.node_to_index( node )].top(), new_i );
         if ( ntk.is_complemented( s ) != ntk.is_complemented( node_to_signals[node] ) )
         {
-          qnet.add_gate( tweedledum::gate::pauli_x, new_i );
+          add_gate( tweedledum::gate::pauli_x, new_i );
         }
         st.o_indexes.push_back( new_i );
       }
@@ -275,7 +488,7 @@ private:
       {
         if ( ntk.is_complemented( s ) )
         {
-          qnet.add_gate( tweedledum::gate::pauli_x, node_to_qubit[ntk.node_to_index( node )].top() );
+          add_gate( tweedledum::gate::pauli_x, node_to_qubit[ntk.node_to_index( node )].top() );
         }
         node_to_signals[node] = s;
         st.o_indexes.push_back( node_to_qubit[ntk.node_to_index( node )].top() );
@@ -285,7 +498,7 @@ private:
 
   void release_ancilla( uint32_t q )
   {
-    free_ancillae.push( q );
+    free_ancillae.release( q, ready_time( q ) );
   }
 
   template<int Fanin>
@@ -298,24 +511,80 @@ private:
     return controls;
   }
 
-  SetQubits get_fanin_as_qubits( mt::node<LogicNetwork> const& n )
+  SetQubits const& get_fanin_as_qubits( mt::node<LogicNetwork> const& n )
   {
-    SetQubits controls;
+    fanin_buffer.clear();
     ntk.foreach_fanin( n, [&]( auto const& f ) {
       assert( !ntk.is_complemented( f ) );
-      controls.push_back( tweedledum::qubit_id( node_to_qubit[ntk.node_to_index( ntk.get_node( f ) )].top() ) );
+      fanin_buffer.push_back( tweedledum::qubit_id( node_to_qubit[ntk.node_to_index( ntk.get_node( f ) )].top() ) );
     } );
-    return controls;
+    return fanin_buffer;
+  }
+
+  SetQubits const& make_controls( Qubit c1, Qubit c2 )
+  {
+    controls_buffer.clear();
+    controls_buffer.push_back( c1 );
+    controls_buffer.push_back( c2 );
+    return controls_buffer;
   }
 
-  void compute_big_xor( uint32_t const t, std::vector<uint32_t> const leaves)
+  /* complements the controls whose bit in polarity is set */
+  SetQubits const& with_polarity( SetQubits const& controls, uint32_t polarity )
+  {
+    controls_buffer.clear();
+    for ( auto i = 0u; i < controls.size(); ++i )
+    {
+      controls_buffer.emplace_back( controls[i].index(), ( polarity >> i ) & 1u );
+    }
+    return controls_buffer;
+  }
+
+  SetQubits const& make_target( uint32_t t )
+  {
+    target_buffer.clear();
+    target_buffer.push_back( tweedledum::qubit_id( t ) );
+    return target_buffer;
+  }
+
+  void compute_big_xor( uint32_t const t, std::vector<uint32_t> const& leaves )
   {
     for ( auto control : leaves )
     {
       auto c =  node_to_qubit[control].top();
       if (c != t)
       {     
-        qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c ), tweedledum::qubit_id( t ) );
+        add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c ), tweedledum::qubit_id( t ) );
+      }
+    }
+  }
+
+  /* XOR of the leaves that are in exactly one of the two sorted sets */
+  void compute_big_xor_difference( uint32_t const t, std::vector<uint32_t> const& leaves, std::vector<uint32_t> const& copies )
+  {
+    auto it = leaves.begin();
+    auto it2 = copies.begin();
+    const auto add = [&]( uint32_t control ) {
+      auto c = node_to_qubit[control].top();
+      if ( c != t )
+      {
+        add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c ), tweedledum::qubit_id( t ) );
+      }
+    };
+    while ( it != leaves.end() || it2 != copies.end() )
+    {
+      if ( it2 == copies.end() || ( it != leaves.end() && *it < *it2 ) )
+      {
+        add( *it++ );
+      }
+      else if ( it == leaves.end() || *it2 < *it )
+      {
+        add( *it2++ );
+      }
+      else
+      {
+        ++it;
+        ++it2;
       }
     }
   }
@@ -331,11 +600,8 @@ private:
         auto node0 = ntk.index_to_node( controls[0] >> 1 );
         auto node1 = ntk.index_to_node( controls[1] >> 1 );
 
-        SetQubits pol_controls;     
-        pol_controls.emplace_back( node_to_qubit[node0].top(), controls[0] & 1 );
-        pol_controls.emplace_back( node_to_qubit[node1].top(), controls[1] & 1 );
-        
-        compute_and( pol_controls, t );
+        compute_and( make_controls( Qubit( node_to_qubit[node0].top(), controls[0] & 1 ),
+                                    Qubit( node_to_qubit[node1].top(), controls[1] & 1 ) ), t );
         return;
       }
     }
@@ -345,11 +611,8 @@ private:
       {
         auto controls = get_fanin_as_literals<2>( node );
 
-        SetQubits pol_controls;
-        pol_controls.emplace_back( node_to_qubit[ntk.index_to_node( controls[0] >> 1 )].top(), !( controls[0] & 1 ) );
-        pol_controls.emplace_back( node_to_qubit[ntk.index_to_node( controls[1] >> 1 )].top(), !( controls[1] & 1 ) );
-
-        compute_or( pol_controls, t );
+        compute_or( make_controls( Qubit( node_to_qubit[ntk.index_to_node( controls[0] >> 1 )].top(), !( controls[0] & 1 ) ),
+                                   Qubit( node_to_qubit[ntk.index_to_node( controls[1] >> 1 )].top(), !( controls[1] & 1 ) ) ), t );
         return;
       }
     }
@@ -370,13 +633,13 @@ private:
       if ( ntk.is_nary_xor( node ) )
       {
         
-        std::vector<uint32_t> controls;
-        controls.reserve( ntk.fanin_size(node) );
-        ntk.foreach_fanin(node, [&] (auto f)
-        {
-          controls.push_back(ntk.get_node(f));
-        });
-        compute_big_xor( t, controls);
+        ntk.foreach_fanin( node, [&]( auto f ) {
+          auto c = node_to_qubit[ntk.get_node( f )].top();
+          if ( c != t )
+          {
+            add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c ), tweedledum::qubit_id( t ) );
+          }
+        } );
         return;
       }
     }
@@ -416,19 +679,13 @@ private:
         {
           if ( controls[0] & 1 )
           {
-            SetQubits pol_controls;
-            pol_controls.emplace_back( node_to_qubit[ntk.index_to_node( controls[1] >> 1 )].top(), !( controls[1] & 1 ) );
-            pol_controls.emplace_back( node_to_qubit[ntk.index_to_node( controls[2] >> 1 )].top(), !( controls[2] & 1 ) );
-
-            compute_or( pol_controls, tweedledum::qubit_id( t ) );
+            compute_or( make_controls( Qubit( node_to_qubit[ntk.index_to_node( controls[1] >> 1 )].top(), !( controls[1] & 1 ) ),
+                                       Qubit( node_to_qubit[ntk.index_to_node( controls[2] >> 1 )].top(), !( controls[2] & 1 ) ) ), t );
           }
           else
           {
-            SetQubits pol_controls;
-            pol_controls.emplace_back( node_to_qubit[ntk.index_to_node( controls[1] >> 1 )].top(), controls[1] & 1 );
-            pol_controls.emplace_back( node_to_qubit[ntk.index_to_node( controls[2] >> 1 )].top(), controls[2] & 1 );
-
-            compute_and( pol_controls, tweedledum::qubit_id( t ) );
+            compute_and( make_controls( Qubit( node_to_qubit[ntk.index_to_node( controls[1] >> 1 )].top(), controls[1] & 1 ),
+                                        Qubit( node_to_qubit[ntk.index_to_node( controls[2] >> 1 )].top(), controls[2] & 1 ) ), t );
           }
         }
         else
@@ -444,22 +701,29 @@ private:
     }
     if constexpr ( mt::has_node_function_v<LogicNetwork> )
     {
-      kitty::dynamic_truth_table tt = ntk.node_function( node );
-      auto clone = tt.construct();
-      kitty::create_parity( clone );
-
-      if ( tt == clone )
+      // In this case, the procedure works a bit different and retrieves the
+      // controls directly as mapped qubits.  We assume that the inputs cannot
+      // be complemented, e.g., in the case of k-LUT networks.
+      auto const& [function, cls] = node_classes[node];
+      auto const& controls = get_fanin_as_qubits( node );
+      switch ( cls.kind )
       {
-        const auto controls = get_fanin_as_qubits( node );
+      case gate_kind::parity:
         compute_xor_block( controls, tweedledum::qubit_id( t ) );
-      }
-      else
-      {
-        // In this case, the procedure works a bit different and retrieves the
-        // controls directly as mapped qubits.  We assume that the inputs cannot
-        // be complemented, e.g., in the case of k-LUT networks.
-        const auto controls = get_fanin_as_qubits( node );
-        compute_lut( ntk.node_function( node ), controls, tweedledum::qubit_id( t ) );
+        break;
+      case gate_kind::and_gate:
+        compute_and( with_polarity( controls, cls.polarity ), t );
+        break;
+      case gate_kind::or_gate:
+        compute_or( with_polarity( controls, ~cls.polarity ), t );
+        break;
+      case gate_kind::maj:
+        compute_maj( controls[0], controls[1], controls[2],
+                     cls.polarity & 1u, ( cls.polarity >> 1 ) & 1u, ( cls.polarity >> 2 ) & 1u, t );
+        break;
+      case gate_kind::lut:
+        compute_lut( function, controls, tweedledum::qubit_id( t ) );
+        break;
       }
     }
   }
@@ -469,13 +733,13 @@ private:
     (void)node;
 
     /* get control qubits */
-    SetQubits controls;
+    fanin_buffer.clear();
     for ( auto l : leave_indexes )
     {
-      controls.push_back( tweedledum::qubit_id( node_to_qubit[ntk.node_to_index( l )].top() ) );
+      fanin_buffer.push_back( tweedledum::qubit_id( node_to_qubit[ntk.node_to_index( l )].top() ) );
     }
 
-    compute_lut( func, controls, tweedledum::qubit_id( t ) );
+    compute_lut( func, fanin_buffer, tweedledum::qubit_id( t ) );
   }
 
   void compute_node_inplace( mt::node<LogicNetwork> const& node, uint32_t t )
@@ -520,66 +784,121 @@ private:
     }
     if constexpr ( mt::has_node_function_v<LogicNetwork> )
     {
-      const auto controls = get_fanin_as_qubits( node );
+      auto const& controls = get_fanin_as_qubits( node );
       compute_xor_block( controls, tweedledum::qubit_id( t ) );
     }
   }
 
-  void compute_and( SetQubits controls, uint32_t t )
+  void compute_and( SetQubits const& controls, uint32_t t )
   {
-    qnet.add_gate( tweedledum::gate::mcx, controls, SetQubits{{t}} );
+    if ( uncomputing && controls.size() == 2u && uncompute_and_by_measurement( controls, t ) )
+    {
+      return;
+    }
+    add_gate( tweedledum::gate::mcx, controls, make_target( t ) );
   }
 
-  void compute_or( SetQubits controls, uint32_t t )
+  void compute_or( SetQubits const& controls, uint32_t t )
   {
-    qnet.add_gate( tweedledum::gate::mcx, controls, SetQubits{{t}} );
-    qnet.add_gate( tweedledum::gate::pauli_x, tweedledum::qubit_id( t ) );
+    if ( uncomputing && controls.size() == 2u )
+    {
+      /* t holds the complement of the AND of the complemented controls */
+      add_gate( tweedledum::gate::pauli_x, tweedledum::qubit_id( t ) );
+      if ( !uncompute_and_by_measurement( controls, t ) )
+      {
+        add_gate( tweedledum::gate::mcx, controls, make_target( t ) );
+      }
+      return;
+    }
+    add_gate( tweedledum::gate::mcx, controls, make_target( t ) );
+    add_gate( tweedledum::gate::pauli_x, tweedledum::qubit_id( t ) );
+  }
+
+  /* resets t, which holds the AND of the controls, returns false if qnet cannot measure */
+  bool uncompute_and_by_measurement( SetQubits const& controls, uint32_t t )
+  {
+    if constexpr ( has_add_measurement_based_uncompute_v<QuantumNetwork> || has_stg_gates<QuantumNetwork>::value )
+    {
+      if ( peephole )
+      {
+        peephole->flush();
+      }
+      const auto a = controls[0].index();
+      const auto b = controls[1].index();
+      const auto level = std::max( {ready_time( a ), ready_time( b ), ready_time( t )} ) + 1u;
+      ready_time( a ) = ready_time( b ) = ready_time( t ) = level;
+
+      if constexpr ( has_add_measurement_based_uncompute_v<QuantumNetwork> )
+      {
+        /* the CZ acts on the literals */
+        for ( auto c : controls )
+        {
+          if ( c.is_complemented() )
+            qnet.add_gate( tweedledum::gate::pauli_x, tweedledum::qubit_id( c.index() ) );
+        }
+        qnet.add_measurement_based_uncompute( tweedledum::qubit_id( t ), tweedledum::qubit_id( a ), tweedledum::qubit_id( b ) );
+        for ( auto c : controls )
+        {
+          if ( c.is_complemented() )
+            qnet.add_gate( tweedledum::gate::pauli_x, tweedledum::qubit_id( c.index() ) );
+        }
+      }
+      else
+      {
+        qnet.add_gate( stg_gate::measured_and_uncompute( controls[0], controls[1], tweedledum::qubit_id( t ) ) );
+      }
+      ++st.profile.num_measured_uncomputes;
+      return true;
+    }
+    else
+    {
+      (void)controls;
+      (void)t;
+      return false;
+    }
   }
 
   void compute_xor( uint32_t c1, uint32_t c2, bool inv, uint32_t t)
   {
-    qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c1 ), tweedledum::qubit_id( t ) );
-    qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c2 ), tweedledum::qubit_id( t ) );
+    add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c1 ), tweedledum::qubit_id( t ) );
+    add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c2 ), tweedledum::qubit_id( t ) );
     if ( inv )
-      qnet.add_gate( tweedledum::gate::pauli_x, tweedledum::qubit_id( t ) );
+      add_gate( tweedledum::gate::pauli_x, tweedledum::qubit_id( t ) );
   }
 
   void compute_xor3( uint32_t c1, uint32_t c2, uint32_t c3, bool inv, uint32_t t )
   {
-    qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c1 ), tweedledum::qubit_id( t ) );
-    qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c2 ), tweedledum::qubit_id( t ) );
-    qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c3 ), tweedledum::qubit_id( t ) );
+    add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c1 ), tweedledum::qubit_id( t ) );
+    add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c2 ), tweedledum::qubit_id( t ) );
+    add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c3 ), tweedledum::qubit_id( t ) );
     if ( inv )
-      qnet.add_gate( tweedledum::gate::pauli_x, tweedledum::qubit_id( t ) );
+      add_gate( tweedledum::gate::pauli_x, tweedledum::qubit_id( t ) );
   }
 
   void compute_maj( uint32_t c1, uint32_t c2, uint32_t c3, bool p1, bool p2, bool p3, uint32_t t )
   {
     if ( p1 )
-      qnet.add_gate( tweedledum::gate::pauli_x, c1 );
+      add_gate( tweedledum::gate::pauli_x, c1 );
     if ( !p2 ) /* control 2 behaves opposite */
-      qnet.add_gate( tweedledum::gate::pauli_x, c2 );
+      add_gate( tweedledum::gate::pauli_x, c2 );
     if ( p3 )
-      qnet.add_gate( tweedledum::gate::pauli_x, c3 );
+      add_gate( tweedledum::gate::pauli_x, c3 );
 
-    qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c1 ), c2 );
-    qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c3 ), c1 );
-    qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c3 ), t );
+    add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c1 ), c2 );
+    add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c3 ), c1 );
+    add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c3 ), t );
 
-    SetQubits controls;
-    controls.push_back( tweedledum::qubit_id( c1 ) );
-    controls.push_back( tweedledum::qubit_id( c2 ) );
-    qnet.add_gate( tweedledum::gate::mcx, controls, SetQubits{{t}} );
+    add_gate( tweedledum::gate::mcx, make_controls( tweedledum::qubit_id( c1 ), tweedledum::qubit_id( c2 ) ), make_target( t ) );
 
-    qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c3 ), c1 );
-    qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c1 ), c2 );
+    add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c3 ), c1 );
+    add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c1 ), c2 );
 
     if ( p3 )
-      qnet.add_gate( tweedledum::gate::pauli_x, c3 );
+      add_gate( tweedledum::gate::pauli_x, c3 );
     if ( !p2 )
-      qnet.add_gate( tweedledum::gate::pauli_x, c2 );
+      add_gate( tweedledum::gate::pauli_x, c2 );
     if ( p1 )
-      qnet.add_gate( tweedledum::gate::pauli_x, c1 );
+      add_gate( tweedledum::gate::pauli_x, c1 );
   }
 
   void compute_xor_block( SetQubits const& controls, Qubit t )
@@ -587,16 +906,23 @@ private:
     for ( auto c : controls )
     {
       if ( c != t )
-        qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c ), t );
+        add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c ), t );
     }
   }
 
   void compute_lut( kitty::dynamic_truth_table const& function,
                     SetQubits const& controls, Qubit t )
   {
-    auto qubit_map = controls;
-    qubit_map.push_back( t );
-    stg_fn( qnet, qubit_map, function );
+    lut_buffer.assign( controls.begin(), controls.end() );
+    lut_buffer.push_back( t );
+    CATERPILLAR_TRACE_SPAN( "stg_fn" );
+    if ( peephole )
+    {
+      peephole->flush();
+    }
+    const auto gates_before = num_emitted_gates();
+    stg_fn( qnet, lut_buffer, function );
+    schedule( lut_buffer, static_cast<uint32_t>( std::max<uint64_t>( num_emitted_gates() - gates_before, 1u ) ) );
   }
 
   void compute_xor_inplace( uint32_t c1, uint32_t c2, bool inv, uint32_t t )
@@ -604,112 +930,106 @@ private:
 
     if ( c1 == t && c2 != t)
     {
-      qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c2 ), c1 );
+      add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c2 ), c1 );
     }
     else if ( c2 == t && c1 !=t)
     {
-      qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c1 ), c2 );
+      add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c1 ), c2 );
     }
     else if (c1 != t && c2!= t && c1 != c2)
     {
       //std::cerr << "[e] target does not match any control in in-place\n";
-      qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c1 ), t );
-      qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c2 ), t );
+      add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c1 ), t );
+      add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c2 ), t );
     }
     if ( inv )
-      qnet.add_gate( tweedledum::gate::pauli_x, t );
+      add_gate( tweedledum::gate::pauli_x, t );
   }
 
   void compute_xor3_inplace( uint32_t c1, uint32_t c2, uint32_t c3, bool inv, uint32_t t )
   {
     if ( c1 == t )
     {
-      qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c2 ), tweedledum::qubit_id( c1 ) );
-      qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c3 ), tweedledum::qubit_id( c1 ) );
+      add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c2 ), tweedledum::qubit_id( c1 ) );
+      add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c3 ), tweedledum::qubit_id( c1 ) );
     }
     else if ( c2 == t )
     {
-      qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c1 ), c2 );
-      qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c3 ), c2 );
+      add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c1 ), c2 );
+      add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c3 ), c2 );
     }
     else if ( c3 == t )
     {
-      qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c1 ), c3 );
-      qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c2 ), c3 );
+      add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c1 ), c3 );
+      add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c2 ), c3 );
     }
     else
     {
       //std::cerr << "[e] target does not match any control in in-place\n";
-      qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c1 ), t );
-      qnet.add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c2 ), t );
+      add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c1 ), t );
+      add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c2 ), t );
     }
     if ( inv )
-      qnet.add_gate( tweedledum::gate::pauli_x, t );
+      add_gate( tweedledum::gate::pauli_x, t );
   }
 
   /*  
-      For each node in the level inserts copies and returns the two 
+      For each node in the level inserts copies and stores the two 
       qubits where the roots of each node are stored.             
   */
-  void compute_copies ( std::map<node_t, std::vector<uint32_t>>& id_to_tcp,  caterpillar::level_info_t const& level)
+  void compute_copies( caterpillar::level_info_t const& level )
   {
-    for(auto node : level)
-    { 
-      auto &id = node.first;
-      if(ntk.is_nary_xor(id))
-      {
-        std::vector<uint32_t> fanins;
-        ntk.foreach_fanin(id, [&] (auto f)
-        {
-          fanins.push_back(ntk.get_node(f));
-        });
-        id_to_tcp[id] = fanins;
+    level_targets.resize( level.size() );
+    for ( auto k = 0u; k < level.size(); ++k )
+    {
+      auto const& [id, cones] = level[k];
+      if ( ntk.is_nary_xor( id ) )
         continue;
-      }     
-      std::vector<uint32_t> roots_targets (2);
-      for(auto i = 0; i < 2 ; i++)
+
+      for ( auto i = 0; i < 2; i++ )
       {
-        auto &cone = node.second[i];
-        if(cone.copies.empty())
+        auto const& cone = cones[i];
+        if ( cone.copies.empty() )
         {
-          if(cone.leaves.size() == 1)
+          if ( cone.leaves.size() == 1 )
           {
-            roots_targets[i] = node_to_qubit[cone.leaves[0]].top();
-            continue;
+            level_targets[k][i] = node_to_qubit[cone.leaves[0]].top();
           }
           else
           {
-            roots_targets[i] = cone.target.empty() ? request_ancilla() : node_to_qubit[cone.target[0]].top();
+            level_targets[k][i] = cone.target.empty() ? request_ancilla() : node_to_qubit[cone.target[0]].top();
           }
         }
         else
         {
           auto tcp = request_ancilla();
-          compute_big_xor(tcp, cone.copies);
-          roots_targets[i] = tcp;
+          compute_big_xor( tcp, cone.copies );
+          level_targets[k][i] = tcp;
         }
       }
-      id_to_tcp[id] = roots_targets;
     }
   }
 
-  void remove_copies( std::map<node_t, std::vector<uint32_t>>& id_to_tcp, caterpillar::level_info_t  const&  level )
+  void remove_copies( caterpillar::level_info_t const& level )
   {
-    for(auto node : level)
+    for ( auto k = 0u; k < level.size(); ++k )
     {
-      if(ntk.is_nary_xor(node.first)) continue;
-      for(auto i = 0; i < 2 ; i++)
+      auto const& [id, cones] = level[k];
+      if ( ntk.is_nary_xor( id ) )
+        continue;
+
+      for ( auto i = 0; i < 2; i++ )
       {
-        auto cone = node.second[i];
-        if(cone.copies.empty()) continue;
+        auto const& cone = cones[i];
+        if ( cone.copies.empty() )
+          continue;
 
-        auto tcp = id_to_tcp[node.first][i];
-        
-        for (auto c : cone.copies)
+        auto tcp = level_targets[k][i];
+        for ( auto c : cone.copies )
         {
-          qnet.add_gate(tweedledum::gate::cx, tweedledum::qubit_id( node_to_qubit[c].top() ), tcp );
+          add_gate( tweedledum::gate::cx, tweedledum::qubit_id( node_to_qubit[c].top() ), tcp );
         }
-        release_ancilla(tcp);
+        release_ancilla( tcp );
       }
     }
   }
@@ -728,81 +1048,41 @@ private:
     }
   }
 
-  void compute_level_with_copies(caterpillar::level_info_t const& level)
-  {      
-
-    std::map<node_t, std::vector<uint32_t>> id_to_tcp;
-    compute_copies(id_to_tcp, level);
-    std::vector<uint32_t> qubit_offset;
+  void compute_level_with_copies( caterpillar::level_info_t const& level )
+  {
+    compute_copies( level );
 
-    
-    for(auto node : level)
-    {      
-      auto &id = node.first;
+    for ( auto k = 0u; k < level.size(); ++k )
+    {
+      auto const& [id, cones] = level[k];
       auto target = request_ancilla();
 
       /* nary xor nodes directly point to AND nodes */
-      if(ntk.is_nary_xor(id))
+      if ( ntk.is_nary_xor( id ) )
       {
-        compute_node(id, target);
-        node_to_qubit[id].push(target);
+        compute_node( id, target );
+        node_to_qubit[id].push( target );
         continue;
       }
 
-      SetQubits pol_controls; 
-      for(auto i = 0; i < 2 ; i++)
+      /* leaves that are not copied are added to the root */
+      for ( auto i = 0; i < 2; i++ )
       {
-        auto &cone = node.second[i];
-        auto &tcp = id_to_tcp[id][i];
-        pol_controls.emplace_back(tcp, cone.complemented);
-
-        std::vector<uint32_t> rem_leaves;
-        std::set_symmetric_difference( 
-                  cone.leaves.begin(), cone.leaves.end(), cone.copies.begin(), cone.copies.end(), 
-                  std::back_inserter(rem_leaves) );
-        
-        compute_big_xor(tcp, rem_leaves);
-        node_to_qubit[cone.root].push(tcp);
+        compute_big_xor_difference( level_targets[k][i], cones[i].leaves, cones[i].copies );
+        node_to_qubit[cones[i].root].push( level_targets[k][i] );
       }
 
+      compute_and_xor_from_controls( id, make_controls( Qubit( level_targets[k][0], cones[0].complemented ), Qubit( level_targets[k][1], cones[1].complemented ) ), target );
+      node_to_qubit[id].push( target );
 
-      //  automatically take into account the extra qubit needed 
-      //  for the AND implementation with T-depth = 1
-      if (ntk.is_and(id))
-      { 
-        if (ps.low_tdepth_AND)
-        {
-          qubit_offset.push_back(request_ancilla());
-        }
-      }
-
-      compute_and_xor_from_controls(id, pol_controls, target);
-      node_to_qubit[id].push(target);
-
-      for(auto i = 1; i >= 0 ; i--)
+      for ( auto i = 1; i >= 0; i-- )
       {
-        auto& cone = node.second[i];
-        auto& tcp = id_to_tcp[id][i];
-
-        std::vector<uint32_t> rem_leaves;
-        std::set_symmetric_difference( 
-                  cone.leaves.begin(), cone.leaves.end(), cone.copies.begin(), cone.copies.end(), 
-                  std::back_inserter(rem_leaves) );
-        
-
-        compute_big_xor(tcp, rem_leaves);
+        compute_big_xor_difference( level_targets[k][i], cones[i].leaves, cones[i].copies );
       }
-      node_to_qubit[node.second[0].root].pop();
-      node_to_qubit[node.second[1].root].pop();
-
+      node_to_qubit[cones[0].root].pop();
+      node_to_qubit[cones[1].root].pop();
     }
-    assert(qubit_offset.size() <= level.size());
-    
-    for (auto q : qubit_offset)
-      release_ancilla(q);
-
-    remove_copies(id_to_tcp, level);
-
+    remove_copies( level );
   }
 
   void uncompute_level(caterpillar::level_info_t const& level)
@@ -811,34 +1091,35 @@ private:
     // only AND nodes are uncomputed
     for(int n = level.size()-1; n >=0; n--)
     {
-      SetQubits pol_controls; 
+      auto const& [id, cones] = level[n];
 
-      auto &id = level[n].first;
-      
+      std::array<Qubit, 2> pol_controls;
       for(auto i = 0; i < 2 ; i++)
       {
-        auto &cone = level[n].second[i];
+        auto const& cone = cones[i];
         
         if(cone.leaves.size() == 1)
         {
-          pol_controls.emplace_back(node_to_qubit[cone.leaves[0]].top(), cone.complemented);
+          pol_controls[i] = Qubit( node_to_qubit[cone.leaves[0]].top(), cone.complemented );
           continue;
         } 
 
         auto t = cone.target.empty() ? request_ancilla() : node_to_qubit[cone.target[0]].top();
-        pol_controls.emplace_back(t, cone.complemented);
+        pol_controls[i] = Qubit( t, cone.complemented );
 
         compute_big_xor(t, cone.leaves);
         node_to_qubit[cone.root].push(t);
       }
 
       auto target = node_to_qubit[id].top();
-      compute_and_xor_from_controls(id, pol_controls, target);
+      uncomputing = ps.measurement_based_uncompute;
+      compute_and_xor_from_controls( id, make_controls( pol_controls[0], pol_controls[1] ), target );
+      uncomputing = false;
       node_to_qubit[id].pop();
 
       for(int i = 1; i >= 0 ; i--)
       {
-        auto &cone = level[n].second[i];
+        auto const& cone = cones[i];
         if(cone.leaves.size() == 1) continue;
 
         auto t = node_to_qubit[cone.root].top();
@@ -858,10 +1139,21 @@ private:
   SingleTargetGateSynthesisFn const& stg_fn;
   logic_network_synthesis_params const& ps;
   logic_network_synthesis_stats& st;
-  std::unordered_map<uint32_t, std::stack<uint32_t>> node_to_qubit;
-  std::stack<uint32_t> free_ancillae;
-  /* stores for each root of the cone a queue of qubits where its copies are and its previous location */
-  std::unordered_map<uint32_t, std::queue<uint32_t>> copies;
+  qubit_stacks node_to_qubit;
+  ancilla_pool free_ancillae;
+  std::vector<uint32_t> qubit_ready;
+  std::optional<peephole_buffer<QuantumNetwork>> peephole;
+  node_classification<LogicNetwork> node_classes;
+
+  /* the node being emitted is uncomputed, see `measurement_based_uncompute` */
+  bool uncomputing{false};
+
+  /* reusable buffers, such that emitting a gate does not allocate */
+  SetQubits controls_buffer;
+  SetQubits target_buffer;
+  SetQubits fanin_buffer;
+  SetQubits lut_buffer;
+  std::vector<std::array<uint32_t, 2>> level_targets;
 }; // namespace detail
 
 } // namespace detail
@@ -907,3 +1199,9 @@ bool logic_network_synthesis( QuantumNetwork& qnet, LogicNetwork const& ntk,
 }
 
 } /* namespace caterpillar */
+
+/* instantiations in the precompiled library, see details/core_templates.hpp */
+#ifdef CATERPILLAR_CORE
+#include "../details/core_templates.hpp"
+CATERPILLAR_CORE_FOREACH_NETWORK( CATERPILLAR_CORE_LHRS_TEMPLATES, extern )
+#endif
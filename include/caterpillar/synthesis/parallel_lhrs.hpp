@@ -0,0 +1,408 @@
+/*------------------------------------------------------------------------------
+| This file is distributed under the MIT License.
+| See accompanying file /LICENSE for details.
+*-----------------------------------------------------------------------------*/
+#pragma once
+
+#include "../details/ancilla_pool.hpp"
+#include "../details/output_groups.hpp"
+#include "lhrs.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <fmt/format.h>
+#include <mockturtle/traits.hpp>
+#include <mockturtle/utils/stopwatch.hpp>
+#include <tweedledum/algorithms/synthesis/stg.hpp>
+
+namespace caterpillar
+{
+
+struct parallel_logic_network_synthesis_params
+{
+  /*! \brief Number of threads (0: hardware concurrency). */
+  uint32_t num_threads{0u};
+
+  /*! \brief Synthesize isomorphic groups once and replay the circuit. */
+  bool share_isomorphic_groups{true};
+
+  /*! \brief Parameters of the synthesis of each group. */
+  logic_network_synthesis_params synthesis;
+
+  /*! \brief Be verbose. */
+  bool verbose{false};
+};
+
+struct parallel_logic_network_synthesis_stats
+{
+  /*! \brief Total runtime. */
+  mockturtle::stopwatch<>::duration time_total{0};
+
+  /*! \brief Runtime of partitioning the outputs into groups. */
+  mockturtle::stopwatch<>::duration time_partition{0};
+
+  /*! \brief Runtime of synthesizing the groups (wall clock). */
+  mockturtle::stopwatch<>::duration time_synthesis{0};
+
+  /*! \brief Runtime of merging the sub-circuits. */
+  mockturtle::stopwatch<>::duration time_merge{0};
+
+  /*! \brief Number of output groups with disjoint transitive fanin. */
+  uint32_t num_groups{0u};
+
+  /*! \brief Number of synthesized groups, one per isomorphism class. */
+  uint32_t num_classes{0u};
+
+  /*! \brief Number of gates in the largest group. */
+  uint32_t largest_group{0u};
+
+  /*! \brief Number of threads used. */
+  uint32_t num_threads{0u};
+
+  /*! \brief Required number of ancilla. */
+  uint32_t required_ancillae{0u};
+
+  /*! \brief Helper qubits for ANDs with T-depth 1 of all groups (see `logic_network_synthesis_params::low_tdepth_AND`). */
+  std::vector<uint32_t> helper_qubits;
+
+  /*! \brief output qubits. */
+  std::vector<uint32_t> o_indexes;
+
+  /*! \brief input qubits. */
+  std::vector<uint32_t> i_indexes;
+
+  void report() const
+  {
+    std::cout << fmt::format( "[i] total time     = {:>5.2f} secs\n", mockturtle::to_seconds( time_total ) );
+    std::cout << fmt::format( "[i] partition time = {:>5.2f} secs\n", mockturtle::to_seconds( time_partition ) );
+    std::cout << fmt::format( "[i] synthesis time = {:>5.2f} secs\n", mockturtle::to_seconds( time_synthesis ) );
+    std::cout << fmt::format( "[i] merge time     = {:>5.2f} secs\n", mockturtle::to_seconds( time_merge ) );
+    std::cout << fmt::format( "[i] groups         = {} (largest {} gates, {} threads)\n", num_groups, largest_group, num_threads );
+    std::cout << fmt::format( "[i] classes        = {}\n", num_classes );
+    std::cout << fmt::format( "[i] ancillae       = {}\n", required_ancillae );
+    if ( !helper_qubits.empty() )
+    {
+      std::cout << fmt::format( "[i] helper qubits  = {}\n", helper_qubits.size() );
+    }
+  }
+};
+
+namespace detail
+{
+
+/* appends `sub` to `qnet` with its qubits renamed by `remap` */
+template<class QuantumNetwork>
+void append_remapped( QuantumNetwork& qnet, QuantumNetwork const& sub, std::vector<uint32_t> const& remap )
+{
+  using gate_t = typename QuantumNetwork::gate_type;
+
+  std::vector<tweedledum::qubit_id> controls, targets;
+  sub.foreach_cgate( [&]( auto const& n ) {
+    controls.clear();
+    targets.clear();
+    n.gate.foreach_control( [&]( auto const& c ) {
+      controls.emplace_back( remap[c.index()], c.is_complemented() );
+    } );
+    n.gate.foreach_target( [&]( auto const& t ) {
+      targets.emplace_back( remap[t.index()] );
+    } );
+
+    if constexpr ( std::is_same_v<gate_t, stg_gate> )
+    {
+      if ( n.gate.is_measurement() )
+      {
+        qnet.add_gate( stg_gate::measured_and_uncompute( controls[0], controls[1], targets[0] ) );
+        return;
+      }
+      if ( n.gate.operation() == tweedledum::gate_set::num_defined_ops )
+      {
+        qnet.add_gate( stg_gate( n.gate.function(), controls, targets[0] ) );
+        return;
+      }
+    }
+    qnet.add_gate( gate_t( static_cast<tweedledum::gate_base const&>( n.gate ), controls, targets ) );
+  } );
+}
+
+template<class QuantumNetwork, class LogicNetwork, class StrategyFn, class SingleTargetGateSynthesisFn>
+class parallel_logic_network_synthesis_impl
+{
+public:
+  parallel_logic_network_synthesis_impl( QuantumNetwork& qnet, LogicNetwork const& ntk,
+                                         StrategyFn& make_strategy,
+                                         SingleTargetGateSynthesisFn const& stg_fn,
+                                         parallel_logic_network_synthesis_params const& ps,
+                                         parallel_logic_network_synthesis_stats& st )
+      : qnet( qnet ), ntk( ntk ), make_strategy( make_strategy ), stg_fn( stg_fn ), ps( ps ), st( st )
+  {
+  }
+
+  bool run()
+  {
+    mockturtle::stopwatch t( st.time_total );
+
+    const auto groups = mockturtle::call_with_stopwatch( st.time_partition, [&]() {
+      output_groups<LogicNetwork> groups( ntk );
+      classify_groups( groups );
+      return groups;
+    } );
+    st.num_groups = groups.size();
+    st.num_classes = static_cast<uint32_t>( representatives.size() );
+    for ( auto g = 0u; g < groups.size(); ++g )
+    {
+      st.largest_group = std::max<uint32_t>( st.largest_group, groups.gates_of( g ).size() );
+    }
+
+    std::vector<QuantumNetwork> circuits( representatives.size() );
+    std::vector<logic_network_synthesis_stats> class_stats( representatives.size() );
+    const auto result = mockturtle::call_with_stopwatch( st.time_synthesis, [&]() {
+      return synthesize_classes( groups, circuits, class_stats );
+    } );
+    if ( !result )
+    {
+      return false;
+    }
+
+    mockturtle::call_with_stopwatch( st.time_merge, [&]() {
+      merge_groups( groups, circuits, class_stats );
+    } );
+    return true;
+  }
+
+private:
+  /* assigns each group to the class of the first group with the same canonical form */
+  void classify_groups( output_groups<LogicNetwork> const& groups )
+  {
+    std::unordered_map<std::vector<uint64_t>, uint32_t, signature_hash> classes;
+    for ( auto g = 0u; g < groups.size(); ++g )
+    {
+      forms.push_back( groups.canonicalize( g ) );
+
+      auto c = static_cast<uint32_t>( representatives.size() );
+      if ( ps.share_isomorphic_groups )
+      {
+        c = classes.emplace( std::move( forms.back().signature ), c ).first->second;
+      }
+      forms.back().signature.clear();
+      if ( c == representatives.size() )
+      {
+        representatives.push_back( g );
+      }
+      class_of.push_back( c );
+    }
+  }
+
+  /* synthesizes the representative of each class into its own circuit */
+  bool synthesize_classes( output_groups<LogicNetwork> const& groups,
+                           std::vector<QuantumNetwork>& circuits,
+                           std::vector<logic_network_synthesis_stats>& class_stats )
+  {
+    const auto num_classes = static_cast<uint32_t>( representatives.size() );
+    const auto hw_threads = std::max( 1u, std::thread::hardware_concurrency() );
+    st.num_threads = std::max( 1u, std::min( ps.num_threads ? ps.num_threads : hw_threads, num_classes ) );
+
+    /* strategies are created on this thread, such that make_strategy need not be thread-safe */
+    std::vector<decltype( make_strategy() )> strategies;
+    strategies.reserve( num_classes );
+    for ( auto c = 0u; c < num_classes; ++c )
+    {
+      strategies.push_back( make_strategy() );
+    }
+
+    std::vector<char> results( num_classes, false );
+    std::atomic<uint32_t> next{0u};
+    auto worker = [&]() {
+      auto local_stg_fn = stg_fn;
+      for ( auto c = next++; c < num_classes; c = next++ )
+      {
+        const auto g = representatives[c];
+        const auto sub = groups.extract( g, forms[g] );
+        results[c] = logic_network_synthesis( circuits[c], sub, *strategies[c], local_stg_fn, ps.synthesis, &class_stats[c] );
+      }
+    };
+
+    std::vector<std::thread> threads;
+    for ( auto i = 1u; i < st.num_threads; ++i )
+    {
+      threads.emplace_back( worker );
+    }
+    worker();
+    for ( auto& thread : threads )
+    {
+      thread.join();
+    }
+
+    return std::find( results.begin(), results.end(), false ) == results.end();
+  }
+
+  /* appends the circuit of each group's class to qnet, sharing input qubits and reusing clean ancillae */
+  void merge_groups( output_groups<LogicNetwork> const& groups,
+                     std::vector<QuantumNetwork> const& circuits,
+                     std::vector<logic_network_synthesis_stats> const& class_stats )
+  {
+    const auto qubits_before = qnet.num_qubits();
+    for ( auto i = 0u; i < ntk.num_pis(); ++i )
+    {
+      st.i_indexes.push_back( qnet.num_qubits() );
+      qnet.add_qubit();
+    }
+    st.o_indexes.resize( ntk.num_pos() );
+
+    /* helper qubits are clean outside the ANDs, but must not be used by any
+     * other gate; each group gets its own helpers, such that the ANDs of
+     * groups in the same layer remain parallel */
+    std::vector<uint32_t> helper_offset( groups.size(), 0u );
+    for ( auto g = 0u; g < groups.size(); ++g )
+    {
+      helper_offset[g] = st.helper_qubits.size();
+      for ( auto i = 0u; i < class_stats[class_of[g]].helper_qubits.size(); ++i )
+      {
+        st.helper_qubits.push_back( request_qubit() );
+      }
+    }
+
+    constexpr auto unmapped = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> remap, released;
+    for ( auto g = 0u; g < groups.size(); ++g )
+    {
+      const auto c = class_of[g];
+      auto const& sub_st = class_stats[c];
+      auto const& inputs = forms[g].inputs;
+      remap.assign( circuits[c].num_qubits(), unmapped );
+      released.clear();
+
+      for ( auto i = 0u; i < sub_st.i_indexes.size(); ++i )
+      {
+        remap[sub_st.i_indexes[i]] = st.i_indexes[inputs[i]];
+      }
+
+      /* qubits that are neither inputs nor ancillae hold constants and stay allocated */
+      const auto num_inputs = static_cast<uint32_t>( inputs.size() );
+      const auto num_constants = circuits[c].num_qubits() - num_inputs - sub_st.required_ancillae;
+      for ( auto q = num_inputs; q < num_inputs + num_constants; ++q )
+      {
+        remap[q] = request_qubit();
+      }
+
+      for ( auto i = 0u; i < sub_st.helper_qubits.size(); ++i )
+      {
+        remap[sub_st.helper_qubits[i]] = st.helper_qubits[helper_offset[g] + i];
+      }
+
+      auto const& outputs = groups.outputs_of( g );
+      for ( auto i = 0u; i < outputs.size(); ++i )
+      {
+        auto& q = remap[sub_st.o_indexes[i]];
+        if ( q == unmapped )
+        {
+          q = request_qubit();
+        }
+        st.o_indexes[outputs[i]] = q;
+      }
+
+      /* all other ancillae are restored to zero by the class's circuit */
+      for ( auto& q : remap )
+      {
+        if ( q == unmapped )
+        {
+          q = request_qubit();
+          released.push_back( q );
+        }
+      }
+
+      append_remapped( qnet, circuits[c], remap );
+
+      for ( auto q : released )
+      {
+        clean_ancillae.release( q );
+      }
+    }
+
+    st.required_ancillae = qnet.num_qubits() - qubits_before - ntk.num_pis();
+  }
+
+  uint32_t request_qubit()
+  {
+    if ( clean_ancillae.empty() )
+    {
+      const auto q = qnet.num_qubits();
+      qnet.add_qubit();
+      return q;
+    }
+    return clean_ancillae.acquire();
+  }
+
+private:
+  QuantumNetwork& qnet;
+  LogicNetwork const& ntk;
+  StrategyFn& make_strategy;
+  SingleTargetGateSynthesisFn const& stg_fn;
+  parallel_logic_network_synthesis_params const& ps;
+  parallel_logic_network_synthesis_stats& st;
+  ancilla_pool clean_ancillae;
+
+  std::vector<typename output_groups<LogicNetwork>::canonical_form> forms;
+  std::vector<uint32_t> class_of;
+  std::vector<uint32_t> representatives;
+};
+
+} // namespace detail
+
+/*! \brief Multi-threaded hierarchical synthesis of independent output cones
+ *
+ * The primary outputs are partitioned into groups whose transitive fanins
+ * share no gate.  Each group is copied into its own logic network and
+ * synthesized with `logic_network_synthesis` into a private circuit, on
+ * `ps.num_threads` threads.  `make_strategy` is called once per synthesized
+ * group and must return a `std::unique_ptr<mapping_strategy<LogicNetwork>>`;
+ * all calls happen on the calling thread before the workers start, so it
+ * need not be thread-safe.  `stg_fn` is copied for each thread.
+ *
+ * Groups with the same canonical structure, such as repeated S-boxes or
+ * adder cells, are synthesized once; the circuit is appended for every
+ * group with its qubits renamed (`ps.share_isomorphic_groups`).
+ *
+ * The circuits are appended to `qnet` in the order of the groups' first
+ * output.  Primary-input qubits are shared; the ancillae that a group
+ * restores to zero are reused by later groups, so the number of qubits is
+ * bounded by the sum of the output qubits plus the largest group's working
+ * ancillae.
+ */
+template<class QuantumNetwork, class LogicNetwork, class StrategyFn,
+         class SingleTargetGateSynthesisFn = tweedledum::stg_from_pprm>
+bool parallel_logic_network_synthesis( QuantumNetwork& qnet, LogicNetwork const& ntk,
+                                       StrategyFn&& make_strategy,
+                                       SingleTargetGateSynthesisFn const& stg_fn = {},
+                                       parallel_logic_network_synthesis_params const& ps = {},
+                                       parallel_logic_network_synthesis_stats* pst = nullptr )
+{
+  static_assert( mt::is_network_type_v<LogicNetwork>, "LogicNetwork is not a network type" );
+  static_assert( mt::has_clone_node_v<LogicNetwork>, "LogicNetwork does not implement the clone_node method" );
+
+  parallel_logic_network_synthesis_stats st;
+  detail::parallel_logic_network_synthesis_impl<QuantumNetwork, LogicNetwork, std::remove_reference_t<StrategyFn>, SingleTargetGateSynthesisFn>
+      impl( qnet, ntk, make_strategy, stg_fn, ps, st );
+  const auto result = impl.run();
+  if ( ps.verbose )
+  {
+    st.report();
+  }
+
+  if ( pst )
+  {
+    *pst = st;
+  }
+
+  return result;
+}
+
+} // namespace caterpillar
@@ -6,17 +6,31 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include <fmt/format.h>
 #include <mockturtle/utils/stopwatch.hpp>
-#include <percy/solvers/bsat2.hpp>
+#include <tweedledum/algorithms/synthesis/cnot_patel.hpp>
+#include <tweedledum/algorithms/synthesis/gray_synth.hpp>
 #include <tweedledum/gates/gate_base.hpp>
+#include <tweedledum/gates/mcst_gate.hpp>
+#include <tweedledum/networks/netlist.hpp>
 #include <tweedledum/networks/qubit.hpp>
 #include <tweedledum/utils/bit_matrix_rm.hpp>
 #include <tweedledum/utils/parity_terms.hpp>
 
+#include "../details/synthesis_profile.hpp"
+#include "../solvers/sat_backends.hpp"
+
 namespace caterpillar
 {
 
@@ -29,6 +43,24 @@ struct satbased_cnotrz_params
 
   /*! \brief Be verbose. */
   bool verbose{false};
+
+  /*! \brief Start from a heuristic solution and search for fewer steps.
+   *
+   * The upper bound is obtained with `gray_synth` followed by `cnot_patel`.
+   * Each number of steps below the bound is encoded and solved separately,
+   * on `num_threads` threads.  If `timeout` expires, the best solution found
+   * so far is returned.
+   */
+  bool warm_start{false};
+
+  /*! \brief Number of step horizons solved concurrently (with `warm_start`). */
+  uint32_t num_threads{1u};
+
+  /*! \brief Timeout in seconds (with `warm_start`, 0 means no timeout). */
+  uint32_t timeout{0u};
+
+  /*! \brief Conflicts per SAT call between two timeout checks (with `warm_start`). */
+  int chunk_conflicts{1000};
 };
 
 struct satbased_cnotrz_stats
@@ -36,20 +68,160 @@ struct satbased_cnotrz_stats
   /*! \brief Total runtime */
   mockturtle::stopwatch<>::duration time_total{};
 
-  /*! \brief Solving time */
+  /*! \brief Solving time (summed over all threads) */
   mockturtle::stopwatch<>::duration time_solving{};
 
+  /*! \brief Number of CNOTs in the heuristic solution (with `warm_start`) */
+  uint32_t upper_bound{0};
+
+  /*! \brief Number of CNOTs in the returned solution */
+  uint32_t num_cnots{0};
+
+  /*! \brief Solution is proven to be optimum */
+  bool optimal{false};
+
+  /*! \brief Per-phase timers and counters.
+   *
+   * The strategy phase is the heuristic and SAT solving, the input phase is
+   * the CNF encoding, and the emission phase builds the returned network.
+   */
+  synthesis_profile profile;
+
   void report()
   {
+    std::cout << fmt::format( "[i] CNOTs              = {} (upper bound = {}, optimal = {})\n", num_cnots, upper_bound, optimal );
     std::cout << fmt::format( "[i] time (SAT solving) = {:7.2f} secs\n", mockturtle::to_seconds( time_solving ) );
     std::cout << fmt::format( "[i] time (total)       = {:7.2f} secs\n", mockturtle::to_seconds( time_total ) );
+    profile.report();
   }
 };
 
 namespace detail
 {
 
+/* CNOT sequence with a rotation after each CNOT that hits a parity term */
 template<class Network>
+Network make_cnotrz_network( uint32_t num_qubits, std::vector<std::pair<uint32_t, uint32_t>> const& gates, parity_terms parities )
+{
+  Network netlist;
+
+  std::vector<uint32_t> qubits_states;
+  for ( auto i = 0u; i < num_qubits; ++i )
+  {
+    netlist.add_qubit();
+    qubits_states.emplace_back( ( 1u << i ) );
+
+    if ( auto rotation = parities.extract_term( qubits_states[i] ); rotation != 0.0 )
+    {
+      netlist.add_gate( gate_base( gate_set::rotation_z, rotation ), i );
+    }
+  }
+
+  for ( auto const& [c, t] : gates )
+  {
+    netlist.add_gate( gate::cx, c, t );
+    qubits_states[t] ^= qubits_states[c];
+    if ( auto rotation = parities.extract_term( qubits_states[t] ); rotation != 0.0 )
+    {
+      netlist.add_gate( gate_base( gate_set::rotation_z, rotation ), t );
+    }
+  }
+
+  return netlist;
+}
+
+/* upper bound: phase part from gray_synth, linear part from cnot_patel */
+inline std::vector<std::pair<uint32_t, uint32_t>> heuristic_cnotrz( bit_matrix_rm<> const& transform, parity_terms const& parities )
+{
+  const auto num_qubits = transform.num_rows();
+  const auto cnots_of = [&]( netlist<mcst_gate> const& circ, std::vector<std::pair<uint32_t, uint32_t>>& gates, uint32_t& last_rotation ) {
+    circ.foreach_cgate( [&]( auto const& node ) {
+      if ( node.gate.is( gate_set::cx ) )
+      {
+        uint32_t c{}, t{};
+        node.gate.foreach_control( [&]( auto q ) { c = q; } );
+        node.gate.foreach_target( [&]( auto q ) { t = q; } );
+        gates.emplace_back( c, t );
+      }
+      else if ( node.gate.is( gate_set::rotation_z ) )
+      {
+        last_rotation = gates.size();
+      }
+    } );
+  };
+
+  netlist<mcst_gate> phases;
+  std::vector<qubit_id> qubits;
+  for ( auto i = 0u; i < num_qubits; ++i )
+  {
+    qubits.push_back( phases.add_qubit() );
+  }
+  gray_synth_params gps;
+  gps.cp_params.allow_rewiring = false;
+  gps.cp_params.best_partition_size = false;
+  gray_synth( phases, qubits, parities, gps );
+
+  /* the linear part of gray_synth restores the identity, drop it */
+  std::vector<std::pair<uint32_t, uint32_t>> gates;
+  uint32_t last_rotation{0};
+  cnots_of( phases, gates, last_rotation );
+  gates.resize( last_rotation );
+
+  std::vector<uint32_t> state( num_qubits ), inverse( num_qubits );
+  for ( auto i = 0u; i < num_qubits; ++i )
+  {
+    state[i] = inverse[i] = 1u << i;
+  }
+  for ( auto const& [c, t] : gates )
+  {
+    state[t] ^= state[c];
+  }
+
+  /* Gauss-Jordan elimination */
+  for ( auto column = 0u; column < num_qubits; ++column )
+  {
+    auto pivot = column;
+    while ( !( ( state[pivot] >> column ) & 1 ) )
+    {
+      ++pivot;
+    }
+    std::swap( state[pivot], state[column] );
+    std::swap( inverse[pivot], inverse[column] );
+    for ( auto row = 0u; row < num_qubits; ++row )
+    {
+      if ( row != column && ( ( state[row] >> column ) & 1 ) )
+      {
+        state[row] ^= state[column];
+        inverse[row] ^= inverse[column];
+      }
+    }
+  }
+
+  /* remaining linear transformation is transform * state^-1 */
+  std::vector<uint32_t> rows( num_qubits );
+  for ( auto row = 0u; row < num_qubits; ++row )
+  {
+    for ( auto column = 0u; column < num_qubits; ++column )
+    {
+      if ( transform.at( row, column ) )
+      {
+        rows[row] ^= inverse[column];
+      }
+    }
+  }
+
+  netlist<mcst_gate> linear;
+  for ( auto i = 0u; i < num_qubits; ++i )
+  {
+    linear.add_qubit();
+  }
+  cnot_patel( linear, qubits, bit_matrix_rm<>( num_qubits, rows ), {false, true, 1u} );
+  cnots_of( linear, gates, last_rotation );
+
+  return gates;
+}
+
+template<class Network, class Solver>
 class satbased_cnotrz_impl
 {
 public:
@@ -81,10 +253,17 @@ public:
       assert_hit_terms( time );
       assert_symmetry_break_matrix( time );
 
+      if constexpr ( has_freeze_v<Solver> )
+      {
+        freeze_interface( time );
+      }
+
       auto assumps = assume_final( time );
       const auto result = mockturtle::call_with_stopwatch( st.time_solving, [&]() { return solver.solve( &assumps[0], &assumps[0] + assumps.size(), ps.conflict_limit ); } );
       if ( result == percy::synth_result::success )
       {
+        st.num_cnots = time;
+        st.optimal = true;
         return extract_solution( time );
       }
 
@@ -104,7 +283,103 @@ public:
     return netlist;
   }
 
+  /*! \brief Encodes exactly `horizon` steps and solves the instance.
+   *
+   * The solver is called with `ps.chunk_conflicts` conflicts at a time, as
+   * long as `keep_going` returns true.
+   */
+  percy::synth_result solve_horizon( uint32_t horizon, std::function<bool()> const& keep_going )
+  {
+    assert_initial();
+    for ( auto time = 0u; time < horizon; ++time )
+    {
+      assert_hit_terms( time );
+      assert_symmetry_break_matrix( time );
+      assert_control_and_target( time );
+      assert_transition( time );
+
+      if ( time > 0 )
+      {
+        assert_symmetry_break( time );
+      }
+    }
+    assert_hit_terms( horizon );
+    assert_symmetry_break_matrix( horizon );
+
+    auto assumps = assume_final( horizon );
+    while ( true )
+    {
+      const auto result = mockturtle::call_with_stopwatch( st.time_solving, [&]() { return solver.solve( &assumps[0], &assumps[0] + assumps.size(), ps.chunk_conflicts ); } );
+      if ( result != percy::synth_result::timeout || !keep_going() )
+      {
+        return result;
+      }
+    }
+  }
+
+  Network extract_solution( uint32_t time )
+  {
+    mockturtle::stopwatch<> t( st.profile.time_emission );
+
+    std::vector<std::pair<uint32_t, uint32_t>> gates;
+    for ( auto i = 0u; i < time; ++i )
+    {
+      uint32_t c = 0u, t = 0u;
+      for ( auto row = 0u; row < num_qubits; ++row )
+      {
+        if ( solver.var_value( control_var( i, row ) ) )
+        {
+          c = row;
+        }
+        else if ( solver.var_value( target_var( i, row ) ) )
+        {
+          t = row;
+        }
+      }
+      gates.emplace_back( c, t );
+    }
+
+    return make_cnotrz_network<Network>( num_qubits, gates, parities );
+  }
+
 private:
+  /* variables referenced by clauses of the next time step */
+  void freeze_interface( uint32_t time )
+  {
+    const auto freeze_step = [&]( uint32_t t, bool value ) {
+      for ( auto row = 0u; row < num_qubits; ++row )
+      {
+        for ( auto column = 0u; column < num_qubits; ++column )
+        {
+          solver.freeze( matrix_var( t, row, column ), value );
+        }
+      }
+      for ( auto id = 0u; id < parities.num_terms(); ++id )
+      {
+        solver.freeze( parity_term_var( t, id ), value );
+      }
+    };
+    const auto freeze_gate = [&]( uint32_t t, bool value ) {
+      for ( auto row = 0u; row < num_qubits; ++row )
+      {
+        solver.freeze( control_var( t, row ), value );
+        solver.freeze( target_var( t, row ), value );
+      }
+    };
+
+    /* control and target variables of the current step are only used after solving */
+    if ( time > 0 )
+    {
+      freeze_step( time - 1, false );
+    }
+    if ( time > 1 )
+    {
+      freeze_gate( time - 2, false );
+    }
+    freeze_step( time, true );
+    freeze_gate( time, true );
+  }
+
   void assert_initial()
   {
     for ( auto row = 0u; row < num_qubits; ++row )
@@ -361,47 +636,6 @@ private:
     }
   }
 
-  Network extract_solution( uint32_t time )
-  {
-    Network netlist;
-
-    std::vector<uint32_t> qubits_states;
-    for ( auto i = 0u; i < num_qubits; ++i )
-    {
-      netlist.add_qubit();
-      qubits_states.emplace_back( ( 1u << i ) );
-
-      if ( auto rotation = parities.extract_term( qubits_states[i] ); rotation != 0.0 )
-      {
-        netlist.add_gate( gate_base( gate_set::rotation_z, rotation ), i );
-      }
-    }
-
-    for ( auto i = 0u; i < time; ++i )
-    {
-      uint32_t c = 0u, t = 0u;
-      for ( auto row = 0u; row < num_qubits; ++row )
-      {
-        if ( solver.var_value( control_var( i, row ) ) )
-        {
-          c = row;
-        }
-        else if ( solver.var_value( target_var( i, row ) ) )
-        {
-          t = row;
-        }
-      }
-      netlist.add_gate( gate::cx, c, t );
-      qubits_states[t] ^= qubits_states[c];
-      if ( auto rotation = parities.extract_term( qubits_states[t] ); rotation != 0.0 )
-      {
-        netlist.add_gate( gate_base( gate_set::rotation_z, rotation ), t );
-      }
-    }
-
-    return netlist;
-  }
-
 private:
   inline int matrix_var( uint32_t time, uint32_t row, uint32_t column ) const
   {
@@ -437,24 +671,148 @@ private:
 
   uint32_t offset;
 
-  percy::bsat_wrapper solver;
+  Solver solver;
 };
 
+template<class Network, class Solver>
+Network satbased_cnotrz_warm_start( bit_matrix_rm<> const& transform, parity_terms const& parities, satbased_cnotrz_params const& ps, satbased_cnotrz_stats& st )
+{
+  mockturtle::stopwatch<> t( st.time_total );
+
+  const auto start = std::chrono::steady_clock::now();
+  const auto timed_out = [&]() {
+    return ps.timeout != 0u && std::chrono::steady_clock::now() - start >= std::chrono::seconds( ps.timeout );
+  };
+
+  const auto gates = mockturtle::call_with_stopwatch( st.profile.time_strategy, [&]() { return heuristic_cnotrz( transform, parities ); } );
+  auto best = mockturtle::call_with_stopwatch( st.profile.time_emission, [&]() { return make_cnotrz_network<Network>( transform.num_rows(), gates, parities ); } );
+  st.upper_bound = gates.size();
+
+  /* SAT(k) implies SAT(k + 2), hence UNSAT(k) implies UNSAT(k - 2) */
+  std::atomic<uint32_t> best_steps = st.upper_bound;
+  std::vector<bool> unsat( st.upper_bound + 1u, false ), running( st.upper_bound + 1u, false );
+  std::mutex mutex;
+  std::condition_variable cv;
+
+  const auto implied_unsat = [&]( uint32_t k ) {
+    for ( auto u = k; u < unsat.size(); u += 2 )
+    {
+      if ( unsat[u] )
+        return true;
+    }
+    return false;
+  };
+  const auto next_horizon = [&]() -> std::optional<uint32_t> {
+    for ( auto k = best_steps.load(); k-- > 0; )
+    {
+      if ( !running[k] && !implied_unsat( k ) )
+        return k;
+    }
+    return std::nullopt;
+  };
+  const auto num_running = [&]() { return std::count( running.begin(), running.end(), true ); };
+
+  const auto worker = [&]() {
+    std::unique_lock lock( mutex );
+    while ( true )
+    {
+      std::optional<uint32_t> horizon;
+      while ( !timed_out() && !( horizon = next_horizon() ) && num_running() > 0 )
+      {
+        cv.wait_for( lock, std::chrono::milliseconds( 100 ) );
+      }
+      if ( timed_out() || !horizon )
+      {
+        return;
+      }
+
+      const auto k = *horizon;
+      running[k] = true;
+      lock.unlock();
+
+      if ( ps.verbose )
+      {
+        std::cout << "try with " << k << " steps\n";
+      }
+
+      satbased_cnotrz_stats local_st;
+      satbased_cnotrz_impl<Network, Solver> impl( transform, parities, ps, local_st );
+      const auto result = impl.solve_horizon( k, [&]() { return !timed_out() && k < best_steps; } );
+      auto solution = result == percy::synth_result::success ? std::optional<Network>( impl.extract_solution( k ) ) : std::nullopt;
+
+      lock.lock();
+      running[k] = false;
+      st.time_solving += local_st.time_solving;
+      st.profile.time_emission += local_st.profile.time_emission;
+      if ( solution && k < best_steps )
+      {
+        best = *solution;
+        best_steps = k;
+      }
+      else if ( result == percy::synth_result::failure )
+      {
+        unsat[k] = true;
+      }
+      cv.notify_all();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for ( auto i = 1u; i < ps.num_threads; ++i )
+  {
+    threads.emplace_back( worker );
+  }
+  worker();
+  for ( auto& thread : threads )
+  {
+    thread.join();
+  }
+
+  st.num_cnots = best_steps;
+  st.optimal = !next_horizon();
+  return best;
+}
+
 } // namespace detail
 
-template<class Network>
-Network satbased_cnotrz( bit_matrix_rm<> const& transform, parity_terms const& parities, satbased_cnotrz_params const& ps = {} )
+/*! \brief SAT-based CNOT-RZ synthesis.
+ *
+ * The SAT solver is set with `Solver`, see `sat_backends.hpp`.
+ */
+template<class Network, class Solver = bsat_backend>
+Network satbased_cnotrz( bit_matrix_rm<> const& transform, parity_terms const& parities, satbased_cnotrz_params const& ps = {}, satbased_cnotrz_stats* pst = nullptr )
 {
   satbased_cnotrz_stats st;
-  detail::satbased_cnotrz_impl<Network> impl( transform, parities, ps, st );
+  const detail::peak_memory_tracker memory;
+
+  Network result;
+  if ( ps.warm_start )
+  {
+    result = detail::satbased_cnotrz_warm_start<Network, Solver>( transform, parities, ps, st );
+  }
+  else
+  {
+    detail::satbased_cnotrz_impl<Network, Solver> impl( transform, parities, ps, st );
+    result = impl.run();
+  }
 
-  const auto result = impl.run();
+  /* solving time is summed over all threads and may exceed the total time */
+  st.profile.time_strategy += st.time_solving;
+  const auto accounted = st.profile.time_strategy + st.profile.time_emission;
+  st.profile.time_inputs = st.time_total > accounted ? st.time_total - accounted : decltype( st.time_total ){0};
+  st.profile.num_gates = result.num_gates();
+  st.profile.peak_memory_increase_bytes = memory.increase();
 
   if ( ps.verbose )
   {
     st.report();
   }
 
+  if ( pst )
+  {
+    *pst = st;
+  }
+
   return result;
 }
 
@@ -5,12 +5,14 @@
 *------------------------------------------------------------------------------------------------*/
 #pragma once
 
+#include "../details/reed_muller.hpp"
 #include "../optimization/optimization_graph.hpp"
 #include "../optimization/post_opt_esop.hpp"
 
 #include <cstdint>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <vector>
 
 #include <kitty/constructors.hpp>
@@ -35,8 +37,8 @@ namespace td = tweedledum;
 struct stg_from_esop
 {
   using esop_synthesis_fn_t = std::function<std::vector<kitty::cube>( kitty::dynamic_truth_table const& )>;
-  stg_from_esop( esop_synthesis_fn_t esop_synthesis, bool optimize_esop = false )
-      : esop_synthesis_( esop_synthesis ), optimize_esop_( optimize_esop )
+  stg_from_esop( esop_synthesis_fn_t esop_synthesis, bool optimize_esop = false, esop_matching_params const& matching_ps = {} )
+      : esop_synthesis_( esop_synthesis ), optimize_esop_( optimize_esop ), matching_ps_( matching_ps )
   {
   }
 
@@ -52,7 +54,7 @@ struct stg_from_esop
     optimized_esop opt_esop;
     if ( optimize_esop_ )
     {
-      opt_esop = match_pairing( cubes );
+      opt_esop = match_pairing( cubes, matching_ps_ );
     }
     else
     {
@@ -65,13 +67,24 @@ struct stg_from_esop
 private:
   esop_synthesis_fn_t esop_synthesis_;
   bool optimize_esop_{false};
+  esop_matching_params matching_ps_;
 };
 
+/*! \brief Single-target gate synthesis from exact and Reed-Muller ESOPs
+ *
+ * The optimum pseudo-Kronecker (PKRM) form is computed with
+ * `optimum_pkrm_cubes` from `reed_muller.hpp`.  Its search grows with the
+ * number of distinct sub-functions, which is exponential in the number of
+ * variables.  Functions with more than `max_pkrm_vars` variables use the
+ * optimum fixed-polarity Reed-Muller (FPRM) form instead, which is faster
+ * but never has fewer cubes than the PKRM form.  By default, the PKRM form
+ * is used for all functions.
+ */
 struct stg_from_exact_synthesis
 {
 public:
-  explicit stg_from_exact_synthesis( std::function<int( kitty::cube )> const& cost_fn = []( kitty::cube const& cube ) { (void)cube; return 1; } )
-      : cost_fn( cost_fn )
+  explicit stg_from_exact_synthesis( std::function<int( kitty::cube )> const& cost_fn = []( kitty::cube const& cube ) { (void)cube; return 1; }, uint32_t max_pkrm_vars = std::numeric_limits<uint32_t>::max() )
+      : cost_fn( cost_fn ), max_pkrm_vars( max_pkrm_vars )
   {
   }
 
@@ -111,13 +124,12 @@ public:
     }
     else if ( is_totally_symmetric( function ) )
     {
-      esop = kitty::esop_from_optimum_pkrm( function );
+      esop = optimum_krm( function );
       cache.emplace( function, esop );
     }
     else
     {
-      auto const& pprm = kitty::esop_from_pprm( function );
-      auto const& pkrm = kitty::esop_from_optimum_pkrm( function );
+      auto const& pkrm = optimum_krm( function );
 
       if ( function.num_vars() >= 5 && pkrm.size() >= 8 )
       {
@@ -126,6 +138,7 @@ public:
       }
       else
       {
+        auto const& pprm = pprm_cubes( function );
         auto const& exact = easy::esop::esop_from_tt<kitty::dynamic_truth_table, easy::sat2::maxsat_rc2, easy::esop::helliwell_maxsat>( stats, ps ).synthesize( function, cost_fn );
 
         auto const pprm_Tcost = easy::esop::T_count( pprm, num_controls );
@@ -170,7 +183,18 @@ public:
   }
 
 protected:
-  std::function<int( kitty::cube )> const& cost_fn;
+  easy::esop::esop_t optimum_krm( kitty::dynamic_truth_table const& function ) const
+  {
+    if ( function.num_vars() <= max_pkrm_vars )
+    {
+      return optimum_pkrm_cubes( function );
+    }
+    return optimum_fprm_cubes( function );
+  }
+
+protected:
+  std::function<int( kitty::cube )> cost_fn;
+  uint32_t max_pkrm_vars;
   mutable std::unordered_map<kitty::dynamic_truth_table, easy::esop::esop_t, kitty::hash<kitty::dynamic_truth_table>> cache;
 };
 
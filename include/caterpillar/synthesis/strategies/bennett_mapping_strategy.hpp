@@ -15,7 +15,9 @@
 #include <cstdint>
 #include <iostream>
 #include <unordered_set>
+#include <vector>
 
+#include "../../details/compute_order.hpp"
 #include "mapping_strategy.hpp"
 
 #include <mockturtle/views/topo_view.hpp>
@@ -31,6 +33,8 @@ namespace mt = mockturtle;
   \verbatim embed:rst
     A strategy that consists in computing all the nodes in topological order and uncomputing them in inverse topological order. 
     It has been described in :cite:`B89` and it provides a solution that always returns the smallest number of reversible gates and the highest number of ancillae, with respect to the other methods. 
+
+    The number of ancillae does not depend on ``order``, since all nodes are live after the compute steps.
   \endverbatim
  */
 template<class LogicNetwork>
@@ -38,7 +42,8 @@ class bennett_mapping_strategy : public mapping_strategy<LogicNetwork>
 {
 public:
 
-  bennett_mapping_strategy()
+  explicit bennett_mapping_strategy( compute_order order = compute_order::topological )
+      : _order( order )
   {
     static_assert( mt::is_network_type_v<LogicNetwork>, "LogicNetwork is not a network type" );
     static_assert( mt::has_foreach_po_v<LogicNetwork>, "LogicNetwork does not implement the foreach_po method" );
@@ -54,24 +59,23 @@ public:
     std::unordered_set<mt::node<LogicNetwork>> drivers;
     ntk.foreach_po( [&]( auto const& f ) { drivers.insert( ntk.get_node( f ) ); } );
 
-    auto it = this->steps().begin();
-    mt::topo_view view{ntk};
-    view.foreach_node( [&]( auto n ) {
-      if ( ntk.is_constant( n ) || ntk.is_pi( n ) )
-        return true;
-
-      /* compute step */
-      it = this->steps().insert( it, {n, compute_action{}} );
-      ++it;
-
+    /* compute all nodes, then uncompute the non-drivers in reverse order */
+    std::vector<mt::node<LogicNetwork>> uncompute;
+    foreach_gate_in_order( ntk, _order, [&]( auto n ) {
+      this->steps().emplace_back( n, compute_action{} );
       if ( !drivers.count( n ) )
-        it = this->steps().insert( it, {n, uncompute_action{}} );
-
-      return true;
+        uncompute.push_back( n );
     } );
+    for ( auto it = uncompute.rbegin(); it != uncompute.rend(); ++it )
+    {
+      this->steps().emplace_back( *it, uncompute_action{} );
+    }
 
     return true;
   }
+
+private:
+  compute_order _order;
 };
 
 template<class LogicNetwork>
@@ -168,4 +172,10 @@ public:
   }
 };
 
-} // namespace caterpillar
\ No newline at end of file
+} // namespace caterpillar
+
+/* instantiations in the precompiled library, see details/core_templates.hpp */
+#ifdef CATERPILLAR_CORE
+#include "../../details/core_templates.hpp"
+CATERPILLAR_CORE_FOREACH_NETWORK( CATERPILLAR_CORE_BENNETT_TEMPLATES, extern )
+#endif
@@ -23,6 +23,7 @@
 
 #include <fmt/format.h>
 
+#include "../../details/trace.hpp"
 #include "eager_mapping_strategy.hpp"
 #include "mapping_strategy.hpp"
 
@@ -100,6 +101,11 @@ public:
     return Ntk::num_cells();
   }
 
+  uint32_t fanout_size( node<Ntk> const& n ) const
+  {
+    return ( *_cell_fanout )[n];
+  }
+
   uint32_t node_to_index( node<Ntk> const& n ) const
   {
     return (*_node_to_index)[n];
@@ -186,6 +192,7 @@ private:
     /* map the cells */
     for ( auto const& [n, action, num_dirty_ancilla] : steps )
     {
+      CATERPILLAR_TRACE_SPAN( "remap_cell" );
       auto num_clean_ancilla = total_ancilla - num_dirty_ancilla;
 
       std::vector<mt::node<LogicNetwork>> leaves;
@@ -327,3 +334,9 @@ private:
 };
 
 } // namespace caterpillar
+
+/* instantiations in the precompiled library, see details/core_templates.hpp */
+#ifdef CATERPILLAR_CORE
+#include "../../details/core_templates.hpp"
+CATERPILLAR_CORE_FOREACH_NETWORK( CATERPILLAR_CORE_BEST_FIT_TEMPLATES, extern )
+#endif
@@ -11,8 +11,7 @@
 
 #include <mockturtle/traits.hpp>
 #include <mockturtle/utils/node_map.hpp>
-#include <mockturtle/views/topo_view.hpp>
-
+#include "../../details/compute_order.hpp"
 #include "mapping_strategy.hpp"
 
 namespace caterpillar
@@ -27,8 +26,8 @@ template<class LogicNetwork>
 class eager_mapping_strategy_impl
 {
 public:
-  eager_mapping_strategy_impl( LogicNetwork const& ntk, typename mapping_strategy<LogicNetwork>::step_vec_t& steps )
-   : _ntk( ntk ), _steps( steps ), _ref_counts( ntk, 0 )
+  eager_mapping_strategy_impl( LogicNetwork const& ntk, typename mapping_strategy<LogicNetwork>::step_vec_t& steps, compute_order order = compute_order::topological )
+   : _ntk( ntk ), _steps( steps ), _ref_counts( ntk, 0 ), _order( order )
   {
     static_assert( mt::is_network_type_v<LogicNetwork>, "LogicNetwork is not a network type" );
     static_assert( mt::has_is_constant_v<LogicNetwork>, "LogicNetwork does not implement the is_constant method" );
@@ -44,19 +43,12 @@ public:
   {
     init_refs();
 
-    mt::topo_view<LogicNetwork> topo{_ntk};
-
-    topo.foreach_node( [&]( auto n ) {
-      if ( _ntk.is_constant( n ) || _ntk.is_pi( n ) )
-        return true;
-
+    foreach_gate_in_order( _ntk, _order, [&]( auto n ) {
       _steps.emplace_back( n, compute_action{} );
       if ( _pos.count( n ) )
       {
         uncompute_eagerly( n );
       }
-
-      return true;
     } );
   }
 
@@ -95,6 +87,7 @@ private:
   typename mapping_strategy<LogicNetwork>::step_vec_t& _steps;
   mt::node_map<uint32_t, LogicNetwork> _ref_counts;
   std::unordered_set<mt::node<LogicNetwork>> _pos;
+  compute_order _order;
 };
 
 }
@@ -106,17 +99,35 @@ private:
     required any longer in successive steps.
   
     This strategy only finds compute and uncompute steps, but no inplace steps.
+
+    With ``compute_order::ancilla_aware`` the nodes are computed in the order
+    of ``ancilla_aware_order``, which computes outputs with shared logic
+    together, such that fewer values are live at the same time.
   \endverbatim
  */
 template<class LogicNetwork>
 class eager_mapping_strategy : public mapping_strategy<LogicNetwork>
 {
 public:
+  explicit eager_mapping_strategy( compute_order order = compute_order::topological )
+      : _order( order )
+  {
+  }
+
   bool compute_steps( LogicNetwork const& ntk ) override
   {
-    detail::eager_mapping_strategy_impl<LogicNetwork>( ntk, this->steps() ).run();
+    detail::eager_mapping_strategy_impl<LogicNetwork>( ntk, this->steps(), _order ).run();
     return true;
   }
+
+private:
+  compute_order _order;
 };
 
 } // namespace caterpillar
+
+/* instantiations in the precompiled library, see details/core_templates.hpp */
+#ifdef CATERPILLAR_CORE
+#include "../../details/core_templates.hpp"
+CATERPILLAR_CORE_FOREACH_NETWORK( CATERPILLAR_CORE_EAGER_TEMPLATES, extern )
+#endif
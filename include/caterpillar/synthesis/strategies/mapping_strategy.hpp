@@ -18,6 +18,7 @@
 
 #include <mockturtle/traits.hpp>
 
+#include "../../details/ancilla_pool.hpp"
 #include "action.hpp"
 
 namespace caterpillar
@@ -34,6 +35,14 @@ public:
    */
   virtual bool compute_steps( LogicNetwork const& ntk ) = 0;
 
+  /*! Order in which the synthesis reuses released ancillae, unless the
+   *  synthesis parameters override it.
+   */
+  virtual ancilla_policy preferred_ancilla_policy() const
+  {
+    return ancilla_policy::lifo;
+  }
+
   /*! Iterates through the strategy's steps applying the given function.
    */
   void foreach_step( step_function_t const& fn ) const
@@ -93,3 +102,9 @@ void print_mapping_strategy( MappingStrategy const& strategy, std::ostream& os =
 }
 
 } // namespace caterpillar
+
+/* instantiations in the precompiled library, see details/core_templates.hpp */
+#ifdef CATERPILLAR_CORE
+#include "../../details/core_templates.hpp"
+CATERPILLAR_CORE_FOREACH_NETWORK( CATERPILLAR_CORE_MAPPING_STRATEGY_TEMPLATES, extern )
+#endif
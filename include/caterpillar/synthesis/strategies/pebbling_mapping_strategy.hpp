@@ -30,8 +30,8 @@ template<class LogicNetwork, class Solver>
 class pebbling_mapping_strategy : public mapping_strategy<LogicNetwork>
 {
 public:
-  pebbling_mapping_strategy( pebbling_mapping_strategy_params const& ps = {} )
-    : ps( ps )
+  pebbling_mapping_strategy( pebbling_mapping_strategy_params const& ps = {}, pebbling_mapping_strategy_stats* pst = nullptr )
+    : ps( ps ), pst( pst )
   {
     static_assert( mt::is_network_type_v<LogicNetwork>, "LogicNetwork is not a network type" );
     static_assert( mt::has_is_pi_v<LogicNetwork>, "LogicNetwork does not implement the is_pi method" );
@@ -45,7 +45,7 @@ public:
   bool compute_steps( LogicNetwork const& ntk ) override
   {
     
-    this->steps() = pebble<Solver, LogicNetwork> (ntk, ps);
+    this->steps() = pebble<Solver, LogicNetwork> (ntk, ps, pst);
 
     if ( this->steps().empty() )
       return false;
@@ -56,6 +56,7 @@ public:
 
 private:
   pebbling_mapping_strategy_params ps;
+  pebbling_mapping_strategy_stats* pst;
 };
 
 #ifdef USE_Z3
@@ -63,8 +64,8 @@ template<class LogicNetwork>
 class weighted_pebbling_mapping_strategy : public mapping_strategy<LogicNetwork>
 {
 public:
-  weighted_pebbling_mapping_strategy( pebbling_mapping_strategy_params const& ps = {} )
-    : ps( ps )
+  weighted_pebbling_mapping_strategy( pebbling_mapping_strategy_params const& ps = {}, pebbling_mapping_strategy_stats* pst = nullptr )
+    : ps( ps ), pst( pst )
   {
     static_assert( has_get_weight_v<LogicNetwork>, "LogicNetwork does not implement the get_weight method");
     static_assert( mt::is_network_type_v<LogicNetwork>, "LogicNetwork is not a network type" );
@@ -80,7 +81,7 @@ public:
   {
     using Solver = z3_pebble_solver<LogicNetwork>;
 
-    this->steps() = pebble<Solver, LogicNetwork> (ntk, ps);
+    this->steps() = pebble<Solver, LogicNetwork> (ntk, ps, pst);
 
     if ( this->steps().empty() )
       return false;
@@ -90,6 +91,7 @@ public:
 
 private:
   pebbling_mapping_strategy_params ps;
+  pebbling_mapping_strategy_stats* pst;
 };
 
 #endif
@@ -557,6 +557,13 @@ public:
   xag_low_depth_mapping_strategy (bool use_alap = false)
   : _alap(use_alap){}
 
+  /* gates of a level are meant to run in parallel, so reuse the ancilla
+   * that became free the earliest to avoid false dependencies */
+  ancilla_policy preferred_ancilla_policy() const override
+  {
+    return ancilla_policy::least_recently_busy;
+  }
+
   bool compute_steps( xag_network const& ntk ) override
   {
     // the strategy proceeds in topological order and level by level
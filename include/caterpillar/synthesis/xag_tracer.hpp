@@ -4,6 +4,9 @@
 | Author(s): Giulia Meuli
 *-----------------------------------------------------------------------------*/
 #pragma once
+#include "../details/ancilla_pool.hpp"
+#include "../details/synthesis_profile.hpp"
+#include "../details/trace.hpp"
 #include "../structures/stg_gate.hpp"
 #include "strategies/mapping_strategy.hpp"
 #include "strategies/xag_mapping_strategy.hpp"
@@ -18,7 +21,7 @@
 #include <mockturtle/utils/node_map.hpp>
 #include <mockturtle/utils/stopwatch.hpp>
 #include <mockturtle/views/topo_view.hpp>
-#include <stack>
+#include <optional>
 #include <type_traits>
 #include <fmt/format.h>
 #include <variant>
@@ -35,8 +38,11 @@ struct xag_tracer_params
   /*! \brief Be verbose. */
   bool verbose{false};
 
+  /*! \brief Count ANDs with T-depth 1 (see `decompose_with_ands_params::use_tdepth1`). */
   bool low_tdepth_AND{false};
 
+  /*! \brief Order in which released ancillae are reused (default: the strategy's preference). */
+  std::optional<ancilla_policy> ancilla_allocation;
 };
 
 struct xag_tracer_stats
@@ -44,7 +50,7 @@ struct xag_tracer_stats
   /*! \brief Number of CNOT gates. */
   uint32_t CNOT_count{0};
 
-  /*! \brief Number of T gates. */
+  /*! \brief Number of T gates, ANDs are uncomputed by measurement without T gates. */
   uint32_t T_count{0};
 
   /*! \brief Number of T stages. */
@@ -65,9 +71,13 @@ struct xag_tracer_stats
   /*! \brief input qubits. */
   std::vector<uint32_t> i_indexes;
 
+  /*! \brief Per-phase timers and counters. */
+  synthesis_profile profile;
+
   void report() const
   {
     std::cout << fmt::format( "[i] total time = {:>5.2f} secs\n", mockturtle::to_seconds( time_total ) );
+    profile.report();
   }
 };
 
@@ -84,26 +94,37 @@ public:
                                 mapping_strategy<Ntk>& strategy,
                                 xag_tracer_params const& ps,
                                 xag_tracer_stats& st )
-      : ntk( ntk ), strategy( strategy ), ps( ps ), st( st )
+      : ntk( ntk ), strategy( strategy ), ps( ps ), st( st ),
+        free_ancillae( ps.ancilla_allocation.value_or( strategy.preferred_ancilla_policy() ) )
   {
   }
 
   bool run()
   {
     mockturtle::stopwatch t( st.time_total );
-    prepare_inputs();
-    prepare_constant( false );
-    if ( ntk.get_node( ntk.get_constant( false ) ) != ntk.get_node( ntk.get_constant( true ) ) )
-      prepare_constant( true );
+    const peak_memory_tracker memory;
+    {
+      mockturtle::stopwatch t_inputs( st.profile.time_inputs );
+      prepare_inputs();
+      prepare_constant( false );
+      if ( ntk.get_node( ntk.get_constant( false ) ) != ntk.get_node( ntk.get_constant( true ) ) )
+        prepare_constant( true );
+    }
 
-    if ( const auto result = strategy.compute_steps( ntk ); !result )
+    const auto result = mockturtle::call_with_stopwatch( st.profile.time_strategy, [&]() {
+      CATERPILLAR_TRACE_SPAN( "compute_steps" );
+      return strategy.compute_steps( ntk );
+    } );
+    if ( !result )
     {
     
       std::cout << "[i] strategy could not be computed\n";
       return false;
     }
 
-    strategy.foreach_step( [&]( auto node, auto action ) {
+    const auto emission_start = std::chrono::steady_clock::now();
+    strategy.foreach_step( [&]( auto const& node, auto const& action ) {
+      st.profile.count_action( action );
       std::visit(
           overloaded{
               []( auto ) {},
@@ -164,6 +185,12 @@ public:
               },
               [&]( uncompute_inplace_action const& action ) {
                 const auto t = node_to_qubit[node].top();
+
+                /* the target is restored into the qubit of node */
+                auto target_qubits = node_to_qubit[ntk.index_to_node( action.target_index )];
+                if ( target_qubits.empty() || target_qubits.top() != t )
+                  target_qubits.push( t );
+
                 if ( ps.verbose )
                 {
                   fmt::print("[i] uncompute {} inplace to {}\n", node , action.target_index);
@@ -186,7 +213,7 @@ public:
                 }
                 node_to_qubit[action.target].push( node_to_qubit[action.leaf].top() );
               },
-              [&] (compute_level_action& action){
+              [&] (compute_level_action const& action){
                 if(ps.verbose)
                 {
                   fmt::print("[i] compute level with node {}\n", action.level[0].first);
@@ -194,7 +221,7 @@ public:
 
                 compute_level_with_copies(action.level);
               },
-              [&] (uncompute_level_action& action){
+              [&] (uncompute_level_action const& action){
                 if(!action.level.empty())
                 {
                   if(ps.verbose)
@@ -206,10 +233,15 @@ public:
               }},
           action );
     } );
+    st.profile.time_emission += std::chrono::steady_clock::now() - emission_start;
 
-    prepare_outputs();
+    mockturtle::call_with_stopwatch( st.profile.time_outputs, [&]() {
+      CATERPILLAR_TRACE_SPAN( "prepare_outputs" );
+      prepare_outputs();
+    } );
     st.T_depth = depths[std::max_element(depths.begin(), depths.end()) - depths.begin()];
     st.qubit_count = num_qubits;
+    st.profile.peak_memory_increase_bytes = memory.increase();
     return true;
   }
 
@@ -226,6 +258,7 @@ private:
 	{
 		(void)op;
     (void)t;
+    st.profile.num_gates++;
 	}
 
 	void add_gate(const tweedledum::gate_base op, Qubit control, Qubit target)
@@ -239,10 +272,11 @@ private:
     assert(t < depths.size());
 
     st.CNOT_count++;
+    st.profile.num_gates++;
     depths[t] = std::max(depths[c], depths[t]);
   }
 
-  void add_gate(const tweedledum::gate_base op, SetQubits controls, SetQubits target)
+  void add_gate(const tweedledum::gate_base op, SetQubits const& controls, SetQubits const& target)
   {
     assert(op.operation() == tweedledum::gate_set::mcx);
     (void)op;
@@ -257,6 +291,7 @@ private:
     assert(t < depths.size());
     assert(t < mask.size());
 
+    st.profile.num_gates++;
 
     if (!mask[t])
     {
@@ -270,6 +305,11 @@ private:
       st.T_count = st.T_count + 4;
 
     }
+    else
+    {
+      /* every second AND onto the same target is uncomputed by measurement */
+      st.profile.num_measured_uncomputes++;
+    }
     mask[t] = !(mask[t]);
   }
 
@@ -281,17 +321,12 @@ private:
   void prepare_inputs()
   {
     /* prepare primary inputs of logic network */
+    node_to_qubit.resize( ntk.size() );
     ntk.foreach_pi( [&]( auto n ) {
-      std::stack<uint32_t> sta;
-      sta.push( num_qubits );
-      node_to_qubit[n] = sta;
+      node_to_qubit[n].push( num_qubits );
       st.i_indexes.push_back( node_to_qubit[n].top() );
       add_qubit();
     } );
-    ntk.foreach_gate( [&]( auto n ) {
-      std::stack<uint32_t> sta;
-      node_to_qubit[n] = sta;
-    } );
   }
 
   void prepare_constant( bool value )
@@ -314,12 +349,13 @@ private:
       auto r = num_qubits;
       st.required_ancillae++;
       add_qubit();
+      st.profile.update_ancillae( st.required_ancillae - free_ancillae.size() );
       return r;
     }
     else
     {
-      const auto r = free_ancillae.top();
-      free_ancillae.pop();
+      const auto r = free_ancillae.acquire();
+      st.profile.update_ancillae( st.required_ancillae - free_ancillae.size() );
       return r;
     }
   }
@@ -355,7 +391,8 @@ private:
 
   void release_ancilla( uint32_t q )
   {
-    free_ancillae.push( q );
+    /* the tracer schedules by T-depth */
+    free_ancillae.release( q, static_cast<uint32_t>( depths[q] ) );
   }
 
   template<int Fanin>
@@ -368,17 +405,32 @@ private:
     return controls;
   }
 
-  SetQubits get_fanin_as_qubits( node_t const& n )
+  SetQubits const& get_fanin_as_qubits( node_t const& n )
   {
-    SetQubits controls;
+    fanin_buffer.clear();
     ntk.foreach_fanin( n, [&]( auto const& f ) {
       assert( !ntk.is_complemented( f ) );
-      controls.push_back( tweedledum::qubit_id( node_to_qubit[ntk.node_to_index( ntk.get_node( f ) )].top() ) );
+      fanin_buffer.push_back( tweedledum::qubit_id( node_to_qubit[ntk.node_to_index( ntk.get_node( f ) )].top() ) );
     } );
-    return controls;
+    return fanin_buffer;
+  }
+
+  SetQubits const& make_controls( Qubit c1, Qubit c2 )
+  {
+    controls_buffer.clear();
+    controls_buffer.push_back( c1 );
+    controls_buffer.push_back( c2 );
+    return controls_buffer;
+  }
+
+  SetQubits const& make_target( uint32_t t )
+  {
+    target_buffer.clear();
+    target_buffer.push_back( tweedledum::qubit_id( t ) );
+    return target_buffer;
   }
 
-  void compute_big_xor( uint32_t const t, std::vector<uint32_t> const leaves)
+  void compute_big_xor( uint32_t const t, std::vector<uint32_t> const& leaves )
   {
     for ( auto control : leaves )
     {
@@ -390,6 +442,36 @@ private:
     }
   }
 
+  /* XOR of the leaves that are in exactly one of the two sorted sets */
+  void compute_big_xor_difference( uint32_t const t, std::vector<uint32_t> const& leaves, std::vector<uint32_t> const& copies )
+  {
+    auto it = leaves.begin();
+    auto it2 = copies.begin();
+    const auto add = [&]( uint32_t control ) {
+      auto c = node_to_qubit[control].top();
+      if ( c != t )
+      {
+        add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c ), tweedledum::qubit_id( t ) );
+      }
+    };
+    while ( it != leaves.end() || it2 != copies.end() )
+    {
+      if ( it2 == copies.end() || ( it != leaves.end() && *it < *it2 ) )
+      {
+        add( *it++ );
+      }
+      else if ( it == leaves.end() || *it2 < *it )
+      {
+        add( *it2++ );
+      }
+      else
+      {
+        ++it;
+        ++it2;
+      }
+    }
+  }
+
 
   void compute_node( node_t const& node, uint32_t t)
   {
@@ -399,11 +481,8 @@ private:
       auto node0 = ntk.index_to_node( controls[0] >> 1 );
       auto node1 = ntk.index_to_node( controls[1] >> 1 );
 
-      SetQubits pol_controls;     
-      pol_controls.emplace_back( node_to_qubit[node0].top(), controls[0] & 1 );
-      pol_controls.emplace_back( node_to_qubit[node1].top(), controls[1] & 1 );
-      
-      compute_and( pol_controls, t );
+      compute_and( make_controls( Qubit( node_to_qubit[node0].top(), controls[0] & 1 ),
+                                  Qubit( node_to_qubit[node1].top(), controls[1] & 1 ) ), t );
       return;
     }
     if ( ntk.is_xor( node ) )
@@ -418,13 +497,13 @@ private:
     if ( ntk.is_nary_xor( node ) )
     {
       
-      std::vector<uint32_t> controls;
-      controls.reserve( ntk.fanin_size(node) );
-      ntk.foreach_fanin(node, [&] (auto f)
-      {
-        controls.push_back(ntk.get_node(f));
-      });
-      compute_big_xor( t, controls);
+      ntk.foreach_fanin( node, [&]( auto f ) {
+        auto c = node_to_qubit[ntk.get_node( f )].top();
+        if ( c != t )
+        {
+          add_gate( tweedledum::gate::cx, tweedledum::qubit_id( c ), tweedledum::qubit_id( t ) );
+        }
+      } );
       return;
     }
   }
@@ -444,9 +523,9 @@ private:
     
   }
 
-  void compute_and( SetQubits controls, uint32_t t )
+  void compute_and( SetQubits const& controls, uint32_t t )
   {
-    add_gate( tweedledum::gate::mcx, controls, SetQubits{{t}} );
+    add_gate( tweedledum::gate::mcx, controls, make_target( t ) );
   }
 
   void compute_xor( uint32_t c1, uint32_t c2, bool inv, uint32_t t)
@@ -479,69 +558,62 @@ private:
   }
 
   /*  
-      For each node in the level inserts copies and returns the two 
+      For each node in the level inserts copies and stores the two 
       qubits where the roots of each node are stored.             
   */
-  void compute_copies ( std::map<node_t, std::vector<uint32_t>>& id_to_tcp,  caterpillar::level_info_t const& level)
+  void compute_copies( caterpillar::level_info_t const& level )
   {
-    for(auto node : level)
-    { 
-      auto &id = node.first;
-      if(ntk.is_nary_xor(id))
-      {
-        std::vector<uint32_t> fanins;
-        ntk.foreach_fanin(id, [&] (auto f)
-        {
-          fanins.push_back(ntk.get_node(f));
-        });
-        id_to_tcp[id] = fanins;
+    level_targets.resize( level.size() );
+    for ( auto k = 0u; k < level.size(); ++k )
+    {
+      auto const& [id, cones] = level[k];
+      if ( ntk.is_nary_xor( id ) )
         continue;
-      }     
-      std::vector<uint32_t> roots_targets (2);
-      for(auto i = 0; i < 2 ; i++)
+
+      for ( auto i = 0; i < 2; i++ )
       {
-        auto &cone = node.second[i];
-        if(cone.copies.empty())
+        auto const& cone = cones[i];
+        if ( cone.copies.empty() )
         {
-          if(cone.leaves.size() == 1)
+          if ( cone.leaves.size() == 1 )
           {
-            roots_targets[i] = node_to_qubit[cone.leaves[0]].top();
-            continue;
+            level_targets[k][i] = node_to_qubit[cone.leaves[0]].top();
           }
           else
           {
-            roots_targets[i] = cone.target.empty() ? request_ancilla() : node_to_qubit[cone.target[0]].top();
+            level_targets[k][i] = cone.target.empty() ? request_ancilla() : node_to_qubit[cone.target[0]].top();
           }
         }
         else
         {
           auto tcp = request_ancilla();
-          compute_big_xor(tcp, cone.copies);
-          roots_targets[i] = tcp;
+          compute_big_xor( tcp, cone.copies );
+          level_targets[k][i] = tcp;
         }
       }
-      id_to_tcp[id] = roots_targets;
     }
   }
 
-  void remove_copies( std::map<node_t, std::vector<uint32_t>>& id_to_tcp, caterpillar::level_info_t  const&  level )
+  void remove_copies( caterpillar::level_info_t const& level )
   {
-    for(auto node : level)
+    for ( auto k = 0u; k < level.size(); ++k )
     {
-      if(ntk.is_nary_xor(node.first)) continue;
+      auto const& [id, cones] = level[k];
+      if ( ntk.is_nary_xor( id ) )
+        continue;
 
-      for(auto i = 0; i < 2 ; i++)
+      for ( auto i = 0; i < 2; i++ )
       {
-        auto cone = node.second[i];
-        if(cone.copies.empty()) continue;
+        auto const& cone = cones[i];
+        if ( cone.copies.empty() )
+          continue;
 
-        auto tcp = id_to_tcp[node.first][i];
-        
-        for (auto c : cone.copies)
+        auto tcp = level_targets[k][i];
+        for ( auto c : cone.copies )
         {
-          add_gate(tweedledum::gate::cx, tweedledum::qubit_id( node_to_qubit[c].top() ), tcp );
+          add_gate( tweedledum::gate::cx, tweedledum::qubit_id( node_to_qubit[c].top() ), tcp );
         }
-        release_ancilla(tcp);
+        release_ancilla( tcp );
       }
     }
   }
@@ -560,80 +632,54 @@ private:
     }
   }
 
-  
-  void compute_level_with_copies(caterpillar::level_info_t const& level)
-  {      
-
-    std::map<node_t, std::vector<uint32_t>> id_to_tcp;
-    compute_copies(id_to_tcp, level);
-    std::vector<uint32_t> qubit_offset;
+  void compute_level_with_copies( caterpillar::level_info_t const& level )
+  {
+    compute_copies( level );
+    level_helpers.clear();
 
-    for(auto node : level)
-    {      
-      auto &id = node.first;
+    for ( auto k = 0u; k < level.size(); ++k )
+    {
+      auto const& [id, cones] = level[k];
       auto target = request_ancilla();
 
       /* nary xor nodes directly point to AND nodes */
-      if(ntk.is_nary_xor(id))
+      if ( ntk.is_nary_xor( id ) )
       {
-        compute_node(id, target);
-        node_to_qubit[id].push(target);
+        compute_node( id, target );
+        node_to_qubit[id].push( target );
         continue;
       }
 
-      SetQubits pol_controls; 
-      for(auto i = 0; i < 2 ; i++)
+      /* leaves that are not copied are added to the root */
+      for ( auto i = 0; i < 2; i++ )
       {
-        auto &cone = node.second[i];
-        auto &tcp = id_to_tcp[id][i];
-        pol_controls.emplace_back(tcp, cone.complemented);
-
-        std::vector<uint32_t> rem_leaves;
-        std::set_symmetric_difference( 
-                  cone.leaves.begin(), cone.leaves.end(), cone.copies.begin(), cone.copies.end(), 
-                  std::back_inserter(rem_leaves) );
-        
-        compute_big_xor(tcp, rem_leaves);
-        node_to_qubit[cone.root].push(tcp);
+        compute_big_xor_difference( level_targets[k][i], cones[i].leaves, cones[i].copies );
+        node_to_qubit[cones[i].root].push( level_targets[k][i] );
       }
 
-
       //  automatically take into account the extra qubit needed 
       //  for the AND implementation with T-depth = 1
-      if (ntk.is_and(id))
-      { 
-        if (ps.low_tdepth_AND)
-        {
-          qubit_offset.push_back(request_ancilla());
-        }
+      if ( ntk.is_and( id ) && ps.low_tdepth_AND )
+      {
+        level_helpers.push_back( request_ancilla() );
       }
 
-      compute_and_xor_from_controls(id, pol_controls, target);
-      node_to_qubit[id].push(target);
+      compute_and_xor_from_controls( id, make_controls( Qubit( level_targets[k][0], cones[0].complemented ), Qubit( level_targets[k][1], cones[1].complemented ) ), target );
+      node_to_qubit[id].push( target );
 
-      for(auto i = 1; i >= 0 ; i--)
+      for ( auto i = 1; i >= 0; i-- )
       {
-        auto& cone = node.second[i];
-        auto& tcp = id_to_tcp[id][i];
-
-        std::vector<uint32_t> rem_leaves;
-        std::set_symmetric_difference( 
-                  cone.leaves.begin(), cone.leaves.end(), cone.copies.begin(), cone.copies.end(), 
-                  std::back_inserter(rem_leaves) );
-        
-
-        compute_big_xor(tcp, rem_leaves);
+        compute_big_xor_difference( level_targets[k][i], cones[i].leaves, cones[i].copies );
       }
-      node_to_qubit[node.second[0].root].pop();
-      node_to_qubit[node.second[1].root].pop();
-
+      node_to_qubit[cones[0].root].pop();
+      node_to_qubit[cones[1].root].pop();
     }
-    assert(qubit_offset.size() <= level.size());
-    
-    for (auto q : qubit_offset)
-      release_ancilla(q);
+    assert( level_helpers.size() <= level.size() );
+
+    for ( auto q : level_helpers )
+      release_ancilla( q );
 
-    remove_copies(id_to_tcp, level);
+    remove_copies( level );
   }
 
   void uncompute_level(caterpillar::level_info_t const& level)
@@ -642,34 +688,33 @@ private:
     // only AND nodes are uncomputed
     for(int n = level.size()-1; n >=0; n--)
     {
-      SetQubits pol_controls; 
+      auto const& [id, cones] = level[n];
 
-      auto &id = level[n].first;
-      
+      std::array<Qubit, 2> pol_controls;
       for(auto i = 0; i < 2 ; i++)
       {
-        auto &cone = level[n].second[i];
+        auto const& cone = cones[i];
         
         if(cone.leaves.size() == 1)
         {
-          pol_controls.emplace_back(node_to_qubit[cone.leaves[0]].top(), cone.complemented);
+          pol_controls[i] = Qubit( node_to_qubit[cone.leaves[0]].top(), cone.complemented );
           continue;
         } 
 
         auto t = cone.target.empty() ? request_ancilla() : node_to_qubit[cone.target[0]].top();
-        pol_controls.emplace_back(t, cone.complemented);
+        pol_controls[i] = Qubit( t, cone.complemented );
 
         compute_big_xor(t, cone.leaves);
         node_to_qubit[cone.root].push(t);
       }
 
       auto target = node_to_qubit[id].top();
-      compute_and_xor_from_controls(id, pol_controls, target);
+      compute_and_xor_from_controls( id, make_controls( pol_controls[0], pol_controls[1] ), target );
       node_to_qubit[id].pop();
 
       for(int i = 1; i >= 0 ; i--)
       {
-        auto &cone = level[n].second[i];
+        auto const& cone = cones[i];
         if(cone.leaves.size() == 1) continue;
 
         auto t = node_to_qubit[cone.root].top();
@@ -693,8 +738,15 @@ private:
   std::vector<bool> mask;
   int num_qubits = 0;
 
-  std::unordered_map<uint32_t, std::stack<uint32_t>> node_to_qubit;
-  std::stack<uint32_t> free_ancillae;
+  qubit_stacks node_to_qubit;
+  ancilla_pool free_ancillae;
+
+  /* reusable buffers, such that emitting a gate does not allocate */
+  SetQubits controls_buffer;
+  SetQubits target_buffer;
+  SetQubits fanin_buffer;
+  std::vector<std::array<uint32_t, 2>> level_targets;
+  std::vector<uint32_t> level_helpers;
  
 }; // namespace detail
 
@@ -711,7 +763,7 @@ private:
  * function.
  */
 template<class Ntk>
-static bool xag_tracer(  Ntk const& ntk,
+bool xag_tracer(  Ntk const& ntk,
                               mapping_strategy<Ntk>& strategy,
                               xag_tracer_params const& ps = {},
                               xag_tracer_stats* pst = nullptr )
@@ -741,3 +793,9 @@ static bool xag_tracer(  Ntk const& ntk,
 }
 
 } /* namespace caterpillar */
+
+/* instantiations in the precompiled library, see details/core_templates.hpp */
+#ifdef CATERPILLAR_CORE
+#include "../details/core_templates.hpp"
+CATERPILLAR_CORE_FOREACH_XAG_NETWORK( CATERPILLAR_CORE_TRACER_TEMPLATES, extern )
+#endif
@@ -5,8 +5,11 @@
 *-----------------------------------------------------------------------------*/
 #pragma once
 
+#include <caterpillar/structures/stg_gate.hpp>
+
 #include <cstdint>
 #include <optional>
+#include <type_traits>
 #include <vector>
 
 #include <mockturtle/traits.hpp>
@@ -19,7 +22,10 @@ namespace caterpillar
  *
  * This function creates a logic network from a reversible circuit.  If the
  * quantum circuit contains a non-classical gate, it will return `std::nullopt`,
- * otherwise an optional value that contains a logic network.
+ * otherwise an optional value that contains a logic network.  Measured AND
+ * uncomputations of `stg_gate` are translated as `target ^= a & b`, such
+ * that an uncomputation of a target that does not hold the AND of its
+ * controls leaves the target dirty.
  *
  * \param circ Reversible quantum circuit
  * \param inputs Qubits which are primary inputs (all other qubits are assumed to be 0)
@@ -47,8 +53,15 @@ std::optional<LogicNetwork> circuit_to_logic_network( QuantumCircuit const& circ
 
   bool error{false};
   circ.foreach_cgate([&]( auto n ) {
+    /* measured AND uncomputations are translated as the Toffoli gates they replace */
+    bool is_measurement{false};
+    if constexpr ( std::is_same_v<std::decay_t<decltype( n.gate )>, stg_gate> )
+    {
+      is_measurement = n.gate.is_measurement();
+    }
+
     /* check whether gate is reversible */
-    if ( !( n.gate.is( gate_set::pauli_x ) || n.gate.is( gate_set::cx ) || n.gate.is( gate_set::mcx ) ) )
+    if ( !( is_measurement || n.gate.is( gate_set::pauli_x ) || n.gate.is( gate_set::cx ) || n.gate.is( gate_set::mcx ) ) )
     {
       error = true;
       return false;
@@ -0,0 +1,198 @@
+/*------------------------------------------------------------------------------
+| This file is distributed under the MIT License.
+| See accompanying file /LICENSE for details.
+*-----------------------------------------------------------------------------*/
+#pragma once
+
+#include <caterpillar/verification/circuit_to_logic_network.hpp>
+
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <vector>
+
+#include <fmt/format.h>
+#include <mockturtle/algorithms/cleanup.hpp>
+#include <mockturtle/algorithms/equivalence_checking.hpp>
+#include <mockturtle/algorithms/miter.hpp>
+#include <mockturtle/algorithms/simulation.hpp>
+#include <mockturtle/networks/xag.hpp>
+#include <mockturtle/traits.hpp>
+#include <mockturtle/utils/stopwatch.hpp>
+
+namespace caterpillar
+{
+
+struct sat_equivalence_checking_params
+{
+  /*! \brief Conflict limit for the SAT solver (0 means no limit). */
+  uint32_t conflict_limit{0u};
+
+  /*! \brief Check that all qubits that are neither inputs nor outputs are restored to 0. */
+  bool check_ancillae{true};
+
+  /*! \brief Be verbose. */
+  bool verbose{false};
+};
+
+struct sat_equivalence_checking_stats
+{
+  /*! \brief Total runtime. */
+  mockturtle::stopwatch<>::duration time_total{0};
+
+  /*! \brief Runtime to extract the logic network from the circuit. */
+  mockturtle::stopwatch<>::duration time_extract{0};
+
+  /*! \brief Runtime to build the miter. */
+  mockturtle::stopwatch<>::duration time_miter{0};
+
+  /*! \brief Runtime of the SAT solver. */
+  mockturtle::stopwatch<>::duration time_sat{0};
+
+  /*! \brief Number of gates in the miter. */
+  uint32_t miter_gates{0u};
+
+  /*! \brief Number of checked ancillae. */
+  uint32_t num_ancillae{0u};
+
+  /*! \brief Counter-example, in case the circuit is not equivalent. */
+  std::vector<bool> counter_example;
+
+  /*! \brief Qubit that is wrong under the counter-example (output or ancilla). */
+  std::optional<uint32_t> failing_qubit;
+
+  /*! \brief Whether the failing qubit is an ancilla that is not restored. */
+  bool ancilla_failure{false};
+
+  void report() const
+  {
+    std::cout << fmt::format( "[i] extract time   = {:>5.2f} secs\n", mockturtle::to_seconds( time_extract ) );
+    std::cout << fmt::format( "[i] miter time     = {:>5.2f} secs\n", mockturtle::to_seconds( time_miter ) );
+    std::cout << fmt::format( "[i] SAT time       = {:>5.2f} secs\n", mockturtle::to_seconds( time_sat ) );
+    std::cout << fmt::format( "[i] total time     = {:>5.2f} secs\n", mockturtle::to_seconds( time_total ) );
+    std::cout << fmt::format( "[i] miter gates    = {}\n", miter_gates );
+    std::cout << fmt::format( "[i] ancillae       = {}\n", num_ancillae );
+  }
+};
+
+/*! \brief SAT-based equivalence checking of a reversible circuit against a logic network.
+ *
+ * The circuit is translated into a logic network with
+ * `circuit_to_logic_network`, in which each ancilla (qubit that is neither in
+ * `inputs` nor in `outputs`) becomes an additional primary output.  The
+ * specification is extended by constant-0 outputs for these ancillae, such
+ * that a single miter checks both functional equivalence and that all
+ * ancillae are restored to 0.  Unlike simulation, the check does not grow
+ * exponentially with the number of inputs.
+ *
+ * The function returns `std::nullopt`, if the circuit contains non-classical
+ * gates, the number of inputs or outputs does not match, or the conflict
+ * limit is reached.  Otherwise it returns whether the circuit is equivalent.
+ * If not, a counter-example and the failing qubit are stored in the
+ * statistics.
+ *
+ * \param circ Reversible circuit
+ * \param ntk Specification, inputs and outputs in the order of `inputs` and `outputs`
+ * \param inputs Qubits which are primary inputs (all other qubits are assumed to be 0)
+ * \param outputs Qubits which hold the primary outputs
+ */
+template<class QuantumCircuit, class Ntk>
+std::optional<bool> sat_equivalence_checking( QuantumCircuit const& circ, Ntk const& ntk, std::vector<uint32_t> const& inputs, std::vector<uint32_t> const& outputs,
+                                              sat_equivalence_checking_params const& ps = {}, sat_equivalence_checking_stats* pst = nullptr )
+{
+  static_assert( mockturtle::is_network_type_v<Ntk>, "Ntk is not a network type" );
+  static_assert( mockturtle::has_num_pis_v<Ntk>, "Ntk does not implement the num_pis method" );
+  static_assert( mockturtle::has_num_pos_v<Ntk>, "Ntk does not implement the num_pos method" );
+
+  sat_equivalence_checking_stats st;
+  std::optional<bool> result;
+
+  {
+    mockturtle::stopwatch<> t_total( st.time_total );
+
+    /* qubits to be checked, outputs first */
+    std::vector<uint32_t> checked = outputs;
+    if ( ps.check_ancillae )
+    {
+      std::vector<bool> is_io( circ.num_qubits(), false );
+      for ( auto q : inputs )
+      {
+        is_io[q] = true;
+      }
+      for ( auto q : outputs )
+      {
+        is_io[q] = true;
+      }
+      for ( auto q = 0u; q < circ.num_qubits(); ++q )
+      {
+        if ( !is_io[q] )
+        {
+          checked.push_back( q );
+        }
+      }
+      st.num_ancillae = static_cast<uint32_t>( checked.size() - outputs.size() );
+    }
+
+    const auto impl = mockturtle::call_with_stopwatch( st.time_extract, [&]() {
+      return circuit_to_logic_network<mockturtle::xag_network>( circ, inputs, checked );
+    } );
+
+    const auto miter = mockturtle::call_with_stopwatch( st.time_miter, [&]() -> std::optional<mockturtle::xag_network> {
+      if ( !impl || ntk.num_pis() != inputs.size() || ntk.num_pos() != outputs.size() )
+      {
+        return std::nullopt;
+      }
+
+      auto spec = mockturtle::cleanup_dangling<Ntk, mockturtle::xag_network>( ntk );
+      for ( auto i = outputs.size(); i < checked.size(); ++i )
+      {
+        spec.create_po( spec.get_constant( false ) );
+      }
+      return mockturtle::miter<mockturtle::xag_network>( *impl, spec );
+    } );
+
+    if ( miter )
+    {
+      st.miter_gates = miter->num_gates();
+
+      mockturtle::equivalence_checking_params ec_ps;
+      ec_ps.conflict_limit = ps.conflict_limit;
+      mockturtle::equivalence_checking_stats ec_st;
+      result = mockturtle::equivalence_checking( *miter, ec_ps, &ec_st );
+      st.time_sat = ec_st.time_total;
+
+      if ( result && !*result )
+      {
+        st.counter_example = ec_st.counter_example;
+
+        /* locate the failing qubit */
+        mockturtle::default_simulator<bool> sim( st.counter_example );
+        const auto values_impl = mockturtle::simulate<bool>( *impl, sim );
+        const auto values_spec = mockturtle::simulate<bool>( ntk, sim );
+        for ( auto i = 0u; i < checked.size(); ++i )
+        {
+          if ( values_impl[i] != ( i < outputs.size() ? values_spec[i] : false ) )
+          {
+            st.failing_qubit = checked[i];
+            st.ancilla_failure = i >= outputs.size();
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  if ( ps.verbose )
+  {
+    st.report();
+  }
+
+  if ( pst )
+  {
+    *pst = st;
+  }
+
+  return result;
+}
+
+} // namespace caterpillar
@@ -0,0 +1,384 @@
+/*------------------------------------------------------------------------------
+| This file is distributed under the MIT License.
+| See accompanying file /LICENSE for details.
+*-----------------------------------------------------------------------------*/
+#pragma once
+
+#include <caterpillar/structures/stg_gate.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#if defined( __AVX2__ )
+#include <immintrin.h>
+#endif
+
+#include <fmt/format.h>
+#include <kitty/constructors.hpp>
+#include <kitty/cube.hpp>
+#include <kitty/dynamic_truth_table.hpp>
+#include <kitty/isop.hpp>
+#include <kitty/operations.hpp>
+#include <mockturtle/algorithms/simulation.hpp>
+#include <mockturtle/traits.hpp>
+#include <mockturtle/utils/stopwatch.hpp>
+#include <tweedledum/gates/gate_set.hpp>
+
+namespace caterpillar
+{
+
+namespace detail
+{
+
+/* dst &= src or ~src */
+inline void sim_and( uint64_t* dst, uint64_t const* src, std::size_t n, bool inv )
+{
+  const uint64_t m = inv ? ~UINT64_C( 0 ) : UINT64_C( 0 );
+  std::size_t i = 0u;
+#if defined( __AVX2__ )
+  const __m256i vm = _mm256_set1_epi64x( static_cast<int64_t>( m ) );
+  for ( ; i + 4u <= n; i += 4u )
+  {
+    const __m256i d = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( dst + i ) );
+    const __m256i s = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( src + i ) );
+    _mm256_storeu_si256( reinterpret_cast<__m256i*>( dst + i ), _mm256_and_si256( d, _mm256_xor_si256( s, vm ) ) );
+  }
+#endif
+  for ( ; i < n; ++i )
+  {
+    dst[i] &= src[i] ^ m;
+  }
+}
+
+/* dst ^= src or ~src */
+inline void sim_xor( uint64_t* dst, uint64_t const* src, std::size_t n, bool inv )
+{
+  const uint64_t m = inv ? ~UINT64_C( 0 ) : UINT64_C( 0 );
+  std::size_t i = 0u;
+#if defined( __AVX2__ )
+  const __m256i vm = _mm256_set1_epi64x( static_cast<int64_t>( m ) );
+  for ( ; i + 4u <= n; i += 4u )
+  {
+    const __m256i d = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( dst + i ) );
+    const __m256i s = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( src + i ) );
+    _mm256_storeu_si256( reinterpret_cast<__m256i*>( dst + i ), _mm256_xor_si256( d, _mm256_xor_si256( s, vm ) ) );
+  }
+#endif
+  for ( ; i < n; ++i )
+  {
+    dst[i] ^= src[i] ^ m;
+  }
+}
+
+/* dst |= src */
+inline void sim_or( uint64_t* dst, uint64_t const* src, std::size_t n )
+{
+  std::size_t i = 0u;
+#if defined( __AVX2__ )
+  for ( ; i + 4u <= n; i += 4u )
+  {
+    const __m256i d = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( dst + i ) );
+    const __m256i s = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( src + i ) );
+    _mm256_storeu_si256( reinterpret_cast<__m256i*>( dst + i ), _mm256_or_si256( d, s ) );
+  }
+#endif
+  for ( ; i < n; ++i )
+  {
+    dst[i] |= src[i];
+  }
+}
+
+} // namespace detail
+
+/*! \brief Creates simulation patterns for all input assignments.
+ *
+ * Pattern `i` is the projection function of the `i`-th variable, hence all
+ * 2^n assignments are simulated (at least 64 patterns, i.e., one word).
+ */
+inline std::vector<kitty::dynamic_truth_table> create_exhaustive_patterns( uint32_t num_inputs )
+{
+  const auto num_vars = std::max( num_inputs, 6u );
+  std::vector<kitty::dynamic_truth_table> patterns( num_inputs, kitty::dynamic_truth_table( num_vars ) );
+  for ( auto i = 0u; i < num_inputs; ++i )
+  {
+    kitty::create_nth_var( patterns[i], i );
+  }
+  return patterns;
+}
+
+/*! \brief Creates `64 * 2^num_words_log` random simulation patterns. */
+inline std::vector<kitty::dynamic_truth_table> create_random_patterns( uint32_t num_inputs, uint32_t num_words_log, uint64_t seed )
+{
+  std::mt19937_64 gen( seed );
+  std::vector<kitty::dynamic_truth_table> patterns( num_inputs, kitty::dynamic_truth_table( 6u + num_words_log ) );
+  for ( auto& tt : patterns )
+  {
+    std::generate( tt.begin(), tt.end(), [&]() { return gen(); } );
+  }
+  return patterns;
+}
+
+/*! \brief Bit-parallel simulation of a reversible circuit.
+ *
+ * Simulates all patterns at once, one bit per pattern, where `patterns[i]`
+ * holds the values of qubit `inputs[i]`.  All other qubits are initialized
+ * to 0.  Supported gates are X, CX, MCX (with negated controls), LUT
+ * single-target gates, and measured AND uncomputations, which are simulated
+ * as the Toffoli gates they replace (see `stg_gate::measured_and_uncompute`).  Word operations use AVX2 if it is available.
+ *
+ * Returns the final value of every qubit, or `std::nullopt` if the circuit
+ * contains another gate.
+ */
+template<class QuantumCircuit>
+std::optional<std::vector<kitty::dynamic_truth_table>> simulate_circuit( QuantumCircuit const& circ, std::vector<uint32_t> const& inputs, std::vector<kitty::dynamic_truth_table> const& patterns )
+{
+  assert( inputs.size() == patterns.size() );
+  assert( !patterns.empty() );
+
+  const auto num_vars = patterns.front().num_vars();
+  std::vector<kitty::dynamic_truth_table> values( circ.num_qubits(), kitty::dynamic_truth_table( num_vars ) );
+  for ( auto i = 0u; i < inputs.size(); ++i )
+  {
+    values[inputs[i]] = patterns[i];
+  }
+
+  const auto n = values.front().num_blocks();
+  std::vector<uint64_t> cond( n ), term( n );
+
+  bool error{false};
+  circ.foreach_cgate( [&]( auto const& node ) {
+    auto const& gate = node.gate;
+    const auto controls = gate.controls();
+
+    if ( gate.is( tweedledum::gate_set::pauli_x ) || gate.is( tweedledum::gate_set::cx ) || gate.is( tweedledum::gate_set::mcx ) )
+    {
+      std::fill( cond.begin(), cond.end(), ~UINT64_C( 0 ) );
+      for ( auto const& c : controls )
+      {
+        detail::sim_and( cond.data(), &*values[c.index()].cbegin(), n, c.is_complemented() );
+      }
+    }
+    else if constexpr ( std::is_same_v<std::decay_t<decltype( gate )>, stg_gate> )
+    {
+      if ( gate.operation() != tweedledum::gate_set::num_defined_ops )
+      {
+        error = true;
+        return false;
+      }
+
+      /* LUT gate, evaluate the ISOP of the control function */
+      std::fill( cond.begin(), cond.end(), UINT64_C( 0 ) );
+      for ( auto const& cube : kitty::isop( gate.function() ) )
+      {
+        std::fill( term.begin(), term.end(), ~UINT64_C( 0 ) );
+        for ( auto i = 0u; i < controls.size(); ++i )
+        {
+          if ( cube.get_mask( i ) )
+          {
+            detail::sim_and( term.data(), &*values[controls[i].index()].cbegin(), n, controls[i].is_complemented() != !cube.get_bit( i ) );
+          }
+        }
+        detail::sim_or( cond.data(), term.data(), n );
+      }
+    }
+    else
+    {
+      error = true;
+      return false;
+    }
+
+    gate.foreach_target( [&]( auto const& t ) {
+      detail::sim_xor( &*values[t.index()].begin(), cond.data(), n, false );
+    } );
+    return true;
+  } );
+
+  if ( error )
+  {
+    return std::nullopt;
+  }
+  return values;
+}
+
+struct simulation_checking_params
+{
+  /*! \brief Simulate all input assignments if there are at most this many inputs. */
+  uint32_t exhaustive_limit{16u};
+
+  /*! \brief Random patterns are `64 * 2^num_words_log` many. */
+  uint32_t num_words_log{4u};
+
+  /*! \brief Seed for random patterns. */
+  uint64_t seed{0xcaffe};
+
+  /*! \brief Check that all qubits that are neither inputs nor outputs are restored to 0. */
+  bool check_ancillae{true};
+
+  /*! \brief Be verbose. */
+  bool verbose{false};
+};
+
+struct simulation_checking_stats
+{
+  /*! \brief Total runtime. */
+  mockturtle::stopwatch<>::duration time_total{0};
+
+  /*! \brief Runtime to simulate the circuit. */
+  mockturtle::stopwatch<>::duration time_circuit{0};
+
+  /*! \brief Runtime to simulate the logic network. */
+  mockturtle::stopwatch<>::duration time_network{0};
+
+  /*! \brief Number of simulated patterns. */
+  uint64_t num_patterns{0u};
+
+  /*! \brief Whether all input assignments were simulated. */
+  bool exhaustive{false};
+
+  /*! \brief Qubit that is wrong for some pattern (output or ancilla). */
+  std::optional<uint32_t> failing_qubit;
+
+  /*! \brief Whether the failing qubit is an ancilla that is not restored. */
+  bool ancilla_failure{false};
+
+  void report() const
+  {
+    std::cout << fmt::format( "[i] patterns       = {}{}\n", num_patterns, exhaustive ? " (exhaustive)" : "" );
+    std::cout << fmt::format( "[i] circuit time   = {:>5.2f} secs\n", mockturtle::to_seconds( time_circuit ) );
+    std::cout << fmt::format( "[i] network time   = {:>5.2f} secs\n", mockturtle::to_seconds( time_network ) );
+    std::cout << fmt::format( "[i] total time     = {:>5.2f} secs\n", mockturtle::to_seconds( time_total ) );
+  }
+};
+
+namespace detail
+{
+
+/* assigns patterns to the primary inputs of a logic network */
+class pattern_simulator
+{
+public:
+  explicit pattern_simulator( std::vector<kitty::dynamic_truth_table> const& patterns )
+      : patterns( patterns )
+  {
+  }
+
+  kitty::dynamic_truth_table compute_constant( bool value ) const
+  {
+    kitty::dynamic_truth_table tt( patterns.front().num_vars() );
+    return value ? ~tt : tt;
+  }
+
+  kitty::dynamic_truth_table compute_pi( uint32_t index ) const
+  {
+    return patterns[index];
+  }
+
+  kitty::dynamic_truth_table compute_not( kitty::dynamic_truth_table const& value ) const
+  {
+    return ~value;
+  }
+
+private:
+  std::vector<kitty::dynamic_truth_table> const& patterns;
+};
+
+} // namespace detail
+
+/*! \brief Simulation-based checking of a reversible circuit against a logic network.
+ *
+ * Simulates circuit and network on the same patterns, exhaustively if the
+ * number of inputs is small enough and randomly otherwise, and compares the
+ * outputs.  Ancillae (qubits that are neither inputs nor outputs) must be 0
+ * for all patterns.  Returns `std::nullopt`, if the circuit contains a gate
+ * that cannot be simulated, or the number of inputs or outputs does not
+ * match.  A result of `true` for random patterns does not prove
+ * equivalence, see `sat_equivalence_checking` for a formal check.
+ *
+ * \param circ Reversible circuit
+ * \param ntk Specification, inputs and outputs in the order of `inputs` and `outputs`
+ * \param inputs Qubits which are primary inputs (all other qubits are assumed to be 0)
+ * \param outputs Qubits which hold the primary outputs
+ */
+template<class QuantumCircuit, class Ntk>
+std::optional<bool> simulation_checking( QuantumCircuit const& circ, Ntk const& ntk, std::vector<uint32_t> const& inputs, std::vector<uint32_t> const& outputs,
+                                         simulation_checking_params const& ps = {}, simulation_checking_stats* pst = nullptr )
+{
+  static_assert( mockturtle::is_network_type_v<Ntk>, "Ntk is not a network type" );
+  static_assert( mockturtle::has_num_pis_v<Ntk>, "Ntk does not implement the num_pis method" );
+  static_assert( mockturtle::has_num_pos_v<Ntk>, "Ntk does not implement the num_pos method" );
+
+  simulation_checking_stats st;
+  std::optional<bool> result;
+
+  if ( ntk.num_pis() == inputs.size() && ntk.num_pos() == outputs.size() && !inputs.empty() )
+  {
+    mockturtle::stopwatch<> t_total( st.time_total );
+
+    st.exhaustive = inputs.size() <= ps.exhaustive_limit;
+    const auto patterns = st.exhaustive ? create_exhaustive_patterns( static_cast<uint32_t>( inputs.size() ) )
+                                        : create_random_patterns( static_cast<uint32_t>( inputs.size() ), ps.num_words_log, ps.seed );
+    st.num_patterns = st.exhaustive ? ( UINT64_C( 1 ) << inputs.size() ) : patterns.front().num_bits();
+
+    const auto values = mockturtle::call_with_stopwatch( st.time_circuit, [&]() { return simulate_circuit( circ, inputs, patterns ); } );
+    if ( values )
+    {
+      const auto expected = mockturtle::call_with_stopwatch( st.time_network, [&]() {
+        return mockturtle::simulate<kitty::dynamic_truth_table>( ntk, detail::pattern_simulator( patterns ) );
+      } );
+
+      result = true;
+      for ( auto i = 0u; i < outputs.size(); ++i )
+      {
+        if ( ( *values )[outputs[i]] != expected[i] )
+        {
+          result = false;
+          st.failing_qubit = outputs[i];
+          break;
+        }
+      }
+
+      if ( *result && ps.check_ancillae )
+      {
+        std::vector<bool> is_io( circ.num_qubits(), false );
+        for ( auto q : inputs )
+        {
+          is_io[q] = true;
+        }
+        for ( auto q : outputs )
+        {
+          is_io[q] = true;
+        }
+        for ( auto q = 0u; q < circ.num_qubits(); ++q )
+        {
+          if ( !is_io[q] && !kitty::is_const0( ( *values )[q] ) )
+          {
+            result = false;
+            st.failing_qubit = q;
+            st.ancilla_failure = true;
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  if ( ps.verbose )
+  {
+    st.report();
+  }
+
+  if ( pst )
+  {
+    *pst = st;
+  }
+
+  return result;
+}
+
+} // namespace caterpillar
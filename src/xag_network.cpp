@@ -0,0 +1,8 @@
+/*------------------------------------------------------------------------------
+| This file is distributed under the MIT License.
+| See accompanying file /LICENSE for details.
+*-----------------------------------------------------------------------------*/
+#include <caterpillar/caterpillar_core.hpp>
+
+CATERPILLAR_CORE_SYNTHESIS_TEMPLATES( , mockturtle::xag_network )
+CATERPILLAR_CORE_TRACER_TEMPLATES( , mockturtle::xag_network )
@@ -0,0 +1,32 @@
+#include <catch.hpp>
+
+#include <caterpillar/details/ancilla_pool.hpp>
+
+#include <vector>
+
+using namespace caterpillar;
+
+static std::vector<uint32_t> drain( ancilla_policy policy )
+{
+  ancilla_pool pool( policy );
+  pool.release( 3u, 5u );
+  pool.release( 1u, 7u );
+  pool.release( 4u, 2u );
+  pool.release( 2u, 5u );
+  CHECK( pool.size() == 4u );
+
+  std::vector<uint32_t> order;
+  while ( !pool.empty() )
+  {
+    order.push_back( pool.acquire() );
+  }
+  return order;
+}
+
+TEST_CASE( "ancilla pool policies", "[ancilla_pool]" )
+{
+  CHECK( drain( ancilla_policy::lifo ) == std::vector<uint32_t>{2u, 4u, 1u, 3u} );
+  CHECK( drain( ancilla_policy::fifo ) == std::vector<uint32_t>{3u, 1u, 4u, 2u} );
+  CHECK( drain( ancilla_policy::least_recently_busy ) == std::vector<uint32_t>{4u, 2u, 3u, 1u} );
+  CHECK( drain( ancilla_policy::lowest_index ) == std::vector<uint32_t>{1u, 2u, 3u, 4u} );
+}
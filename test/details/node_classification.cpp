@@ -0,0 +1,57 @@
+#include <catch.hpp>
+
+#include <caterpillar/details/node_classification.hpp>
+
+#include <kitty/constructors.hpp>
+#include <kitty/dynamic_truth_table.hpp>
+#include <mockturtle/networks/klut.hpp>
+
+using namespace caterpillar;
+
+static function_class classify( uint32_t num_vars, std::string const& binary )
+{
+  kitty::dynamic_truth_table tt( num_vars );
+  kitty::create_from_binary_string( tt, binary );
+  return classify_function( tt );
+}
+
+TEST_CASE( "classify node functions", "[node_classification]" )
+{
+  auto cls = classify( 3u, "10010110" );
+  CHECK( cls.kind == gate_kind::parity );
+
+  /* a & !b */
+  cls = classify( 2u, "0010" );
+  CHECK( cls.kind == gate_kind::and_gate );
+  CHECK( cls.polarity == 2u );
+
+  /* !a | b | c */
+  cls = classify( 3u, "11111101" );
+  CHECK( cls.kind == gate_kind::or_gate );
+  CHECK( cls.polarity == 1u );
+
+  /* <!a b c> */
+  cls = classify( 3u, "11010100" );
+  CHECK( cls.kind == gate_kind::maj );
+  CHECK( cls.polarity == 1u );
+
+  cls = classify( 3u, "11100001" );
+  CHECK( cls.kind == gate_kind::lut );
+}
+
+TEST_CASE( "node classification shares equal functions", "[node_classification]" )
+{
+  mockturtle::klut_network klut;
+  const auto a = klut.create_pi();
+  const auto b = klut.create_pi();
+  const auto c = klut.create_pi();
+  const auto f = klut.create_and( a, b );
+  const auto g = klut.create_and( b, c );
+  const auto h = klut.create_xor( f, g );
+
+  node_classification<mockturtle::klut_network> classes( klut );
+  CHECK( classes[klut.get_node( f )].cls.kind == gate_kind::and_gate );
+  CHECK( classes[klut.get_node( g )].cls.kind == gate_kind::and_gate );
+  CHECK( classes[klut.get_node( h )].cls.kind == gate_kind::parity );
+  CHECK( classes.num_functions() == 2u );
+}
@@ -0,0 +1,102 @@
+#include <catch.hpp>
+
+#include <caterpillar/details/peephole.hpp>
+
+#include <tweedledum/gates/gate_set.hpp>
+#include <tweedledum/gates/mcst_gate.hpp>
+#include <tweedledum/networks/netlist.hpp>
+
+#include <vector>
+
+using namespace caterpillar;
+using namespace tweedledum;
+
+static netlist<mcst_gate> make_circuit( uint32_t num_qubits )
+{
+  netlist<mcst_gate> circ;
+  for ( auto i = 0u; i < num_qubits; ++i )
+  {
+    circ.add_qubit();
+  }
+  return circ;
+}
+
+TEST_CASE( "peephole cancels commuting inverse pairs", "[peephole]" )
+{
+  auto circ = make_circuit( 4u );
+  peephole_buffer buffer( circ );
+
+  /* the CNOT in between shares the target */
+  buffer.add_gate( gate::cx, qubit_id( 0 ), qubit_id( 2 ) );
+  buffer.add_gate( gate::cx, qubit_id( 1 ), qubit_id( 2 ) );
+  buffer.add_gate( gate::cx, qubit_id( 0 ), qubit_id( 2 ) );
+
+  /* the Toffoli gates differ in the order of their controls */
+  buffer.add_gate( gate::mcx, std::vector<qubit_id>{qubit_id( 0 ), qubit_id( 1 )}, std::vector<qubit_id>{qubit_id( 3 )} );
+  buffer.add_gate( gate::cx, qubit_id( 0 ), qubit_id( 2 ) );
+  buffer.add_gate( gate::mcx, std::vector<qubit_id>{qubit_id( 1 ), qubit_id( 0 )}, std::vector<qubit_id>{qubit_id( 3 )} );
+  buffer.flush();
+
+  CHECK( circ.num_gates() == 2u );
+  CHECK( buffer.num_cancelled() == 4u );
+  CHECK( buffer.num_merged() == 0u );
+}
+
+TEST_CASE( "peephole keeps pairs that do not commute", "[peephole]" )
+{
+  auto circ = make_circuit( 3u );
+  peephole_buffer buffer( circ );
+
+  /* X on the control */
+  buffer.add_gate( gate::cx, qubit_id( 0 ), qubit_id( 1 ) );
+  buffer.add_gate( gate::cx, qubit_id( 2 ), qubit_id( 0 ) );
+  buffer.add_gate( gate::cx, qubit_id( 0 ), qubit_id( 1 ) );
+
+  /* target used as control */
+  buffer.add_gate( gate::cx, qubit_id( 0 ), qubit_id( 2 ) );
+  buffer.add_gate( gate::cx, qubit_id( 2 ), qubit_id( 1 ) );
+  buffer.add_gate( gate::cx, qubit_id( 0 ), qubit_id( 2 ) );
+  buffer.flush();
+
+  CHECK( circ.num_gates() == 6u );
+  CHECK( buffer.num_removed() == 0u );
+}
+
+TEST_CASE( "peephole merges X gates into control polarities", "[peephole]" )
+{
+  auto circ = make_circuit( 3u );
+  peephole_buffer buffer( circ );
+
+  buffer.add_gate( gate::pauli_x, qubit_id( 0 ) );
+  buffer.add_gate( gate::cx, qubit_id( 0 ), qubit_id( 1 ) );
+  buffer.add_gate( gate::mcx, std::vector<qubit_id>{qubit_id( 0 ), qubit_id( 1 )}, std::vector<qubit_id>{qubit_id( 2 )} );
+  buffer.add_gate( gate::pauli_x, qubit_id( 0 ) );
+  buffer.flush();
+
+  CHECK( circ.num_gates() == 2u );
+  CHECK( buffer.num_merged() == 2u );
+  circ.foreach_cgate( [&]( auto const& n ) {
+    n.gate.foreach_control( [&]( auto const& c ) {
+      CHECK( c.is_complemented() == ( c.index() == 0u ) );
+    } );
+  } );
+}
+
+TEST_CASE( "peephole window emits gates in order", "[peephole]" )
+{
+  auto circ = make_circuit( 2u );
+  peephole_buffer buffer( circ, 2u );
+
+  /* the first gate leaves the window before its inverse arrives */
+  buffer.add_gate( gate::cx, qubit_id( 0 ), qubit_id( 1 ) );
+  buffer.add_gate( gate::pauli_x, qubit_id( 0 ) );
+  buffer.add_gate( gate::cx, qubit_id( 1 ), qubit_id( 0 ) );
+  buffer.add_gate( gate::pauli_x, qubit_id( 1 ) );
+  CHECK( circ.num_gates() == 2u );
+  buffer.add_gate( gate::pauli_x, qubit_id( 1 ) );
+  buffer.add_gate( gate::cx, qubit_id( 0 ), qubit_id( 1 ) );
+  buffer.flush();
+
+  CHECK( circ.num_gates() == 4u );
+  CHECK( buffer.num_cancelled() == 2u );
+}
@@ -0,0 +1,113 @@
+#include <catch.hpp>
+
+#include <caterpillar/details/reed_muller.hpp>
+#include <caterpillar/structures/stg_gate.hpp>
+#include <caterpillar/synthesis/stg_to_mcx.hpp>
+#include <caterpillar/verification/circuit_to_logic_network.hpp>
+
+#include <kitty/constructors.hpp>
+#include <kitty/dynamic_truth_table.hpp>
+#include <kitty/esop.hpp>
+#include <mockturtle/algorithms/simulation.hpp>
+#include <mockturtle/networks/xag.hpp>
+#include <tweedledum/networks/netlist.hpp>
+
+using namespace caterpillar;
+
+TEST_CASE( "word-parallel PPRM transform matches kitty", "[reed_muller]" )
+{
+  for ( auto num_vars = 1u; num_vars <= 10u; ++num_vars )
+  {
+    kitty::dynamic_truth_table tt( num_vars );
+    kitty::create_random( tt, num_vars );
+
+    const auto cubes = pprm_cubes( tt );
+    CHECK( cubes.size() == kitty::esop_from_pprm( tt ).size() );
+
+    auto f = tt.construct();
+    kitty::create_from_cubes( f, cubes, true );
+    CHECK( f == tt );
+  }
+}
+
+TEST_CASE( "optimum FPRM polarity search", "[reed_muller]" )
+{
+  for ( auto num_vars = 2u; num_vars <= 8u; ++num_vars )
+  {
+    kitty::dynamic_truth_table tt( num_vars );
+    kitty::create_random( tt, 100u + num_vars );
+
+    auto best = fprm_cubes( tt, 0u ).size();
+    for ( auto p = 1u; p < ( 1u << num_vars ); ++p )
+    {
+      best = std::min( best, fprm_cubes( tt, p ).size() );
+    }
+
+    const auto cubes = optimum_fprm_cubes( tt );
+    CHECK( cubes.size() == best );
+
+    auto f = tt.construct();
+    kitty::create_from_cubes( f, cubes, true );
+    CHECK( f == tt );
+
+    /* local search for larger functions */
+    const auto local = optimum_fprm_cubes( tt, 0u );
+    CHECK( local.size() >= best );
+    kitty::create_from_cubes( f, local, true );
+    CHECK( f == tt );
+  }
+}
+
+TEST_CASE( "optimum PKRM on sub-table halves", "[reed_muller]" )
+{
+  for ( auto num_vars = 0u; num_vars <= 9u; ++num_vars )
+  {
+    for ( auto seed = 0u; seed < 4u; ++seed )
+    {
+      kitty::dynamic_truth_table tt( num_vars );
+      kitty::create_random( tt, 200u + 4u * num_vars + seed );
+
+      const auto cubes = optimum_pkrm_cubes( tt );
+      CHECK( cubes.size() <= kitty::esop_from_optimum_pkrm( tt ).size() );
+      CHECK( cubes.size() <= optimum_fprm_cubes( tt ).size() );
+
+      auto f = tt.construct();
+      kitty::create_from_cubes( f, cubes, true );
+      CHECK( f == tt );
+    }
+  }
+
+  /* more than 64 bits per sub-table */
+  kitty::dynamic_truth_table tt( 14u );
+  kitty::create_random( tt, 14u );
+  const auto cubes = optimum_pkrm_cubes( tt );
+  CHECK( cubes.size() <= optimum_fprm_cubes( tt ).size() );
+  auto f = tt.construct();
+  kitty::create_from_cubes( f, cubes, true );
+  CHECK( f == tt );
+}
+
+TEST_CASE( "exact single-target gate synthesis from FPRM", "[reed_muller]" )
+{
+  kitty::dynamic_truth_table tt( 7u );
+  kitty::create_random( tt, 7u );
+
+  /* use the FPRM form for all functions with more than 5 variables */
+  stg_from_exact_synthesis synth( []( kitty::cube const& ) { return 1; }, 5u );
+
+  tweedledum::netlist<stg_gate> circ;
+  std::vector<tweedledum::qubit_id> qubit_map;
+  std::vector<uint32_t> i_indexes;
+  for ( auto i = 0u; i <= tt.num_vars(); ++i )
+  {
+    qubit_map.emplace_back( circ.add_qubit() );
+    i_indexes.push_back( i );
+  }
+  i_indexes.pop_back();
+  synth( circ, qubit_map, tt );
+
+  const auto xag = circuit_to_logic_network<mockturtle::xag_network>( circ, i_indexes, {tt.num_vars()} );
+  REQUIRE( xag );
+  mockturtle::default_simulator<kitty::dynamic_truth_table> sim( tt.num_vars() );
+  CHECK( mockturtle::simulate<kitty::dynamic_truth_table>( *xag, sim )[0] == tt );
+}
@@ -0,0 +1,187 @@
+#include <catch.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include <caterpillar/details/resource_estimation.hpp>
+#include <caterpillar/details/utils.hpp>
+#include <caterpillar/structures/stg_gate.hpp>
+#include <caterpillar/synthesis/decompose_with_ands.hpp>
+#include <caterpillar/synthesis/lhrs.hpp>
+#include <caterpillar/synthesis/strategies/xag_mapping_strategy.hpp>
+#include <kitty/constructors.hpp>
+#include <kitty/dynamic_truth_table.hpp>
+#include <mockturtle/generators/arithmetic.hpp>
+#include <mockturtle/networks/xag.hpp>
+#include <tweedledum/networks/netlist.hpp>
+
+TEST_CASE( "Resource estimation of small reversible circuit", "[resource_estimation]" )
+{
+  using namespace caterpillar;
+  using namespace tweedledum;
+
+  netlist<stg_gate> circ;
+  const auto a = circ.add_qubit();
+  const auto b = circ.add_qubit();
+  const auto c = circ.add_qubit();
+  const auto d = circ.add_qubit();
+  const auto e = circ.add_qubit();
+
+  circ.add_gate( gate::mcx, std::vector<qubit_id>( {a, b} ), {d} );
+  circ.add_gate( gate::cx, d, e );
+  circ.add_gate( gate::mcx, std::vector<qubit_id>( {a, b} ), {d} );
+  circ.add_gate( gate::mcx, std::vector<qubit_id>( {a, b, c} ), {e} );
+
+  const auto st = estimate_resources( circ );
+  CHECK( st.num_qubits == 5u );
+  CHECK( st.num_gates == 4u );
+  CHECK( st.cnot_count == 1u );
+  CHECK( st.depth == 4u );
+  CHECK( st.gates_by_controls == std::vector<uint64_t>{0u, 1u, 2u, 1u} );
+
+  /* compute (4 T) and uncompute (0 T) of the AND, 3-control gate with 8 T */
+  CHECK( st.t_count == 12u );
+  CHECK( st.t_layers.size() == st.t_depth );
+
+  /* d is live in layers 1-3, e in 2-4, a and b in 1-4, c in 4 */
+  CHECK( st.qubit_time_volume == 3u + 3u + 4u + 4u + 1u );
+  CHECK( st.peak_live_qubits == 4u );
+
+  resource_estimation_params ps;
+  ps.cost_model = mcx_cost_model::clean_ancilla;
+  CHECK( estimate_resources( circ, ps ).t_count == 7u + 7u + 21u );
+  ps.cost_model = mcx_cost_model::dirty_ancilla;
+  CHECK( estimate_resources( circ, ps ).t_count == 7u + 7u + 28u );
+  ps.cost_model = mcx_cost_model::relative_phase;
+  CHECK( estimate_resources( circ, ps ).t_count == 7u + 7u + 15u );
+
+  const auto json = st.to_json();
+  CHECK( json["t_count"] == 12u );
+  CHECK( json["peak_live_qubits"] == 4u );
+}
+
+TEST_CASE( "Statistics of circuits with large Toffoli gates", "[resource_estimation]" )
+{
+  using namespace caterpillar;
+  using namespace tweedledum;
+
+  tweedledum::netlist<stg_gate> circ;
+  std::vector<qubit_id> q;
+  for ( auto i = 0u; i < 5u; ++i )
+  {
+    q.push_back( circ.add_qubit() );
+  }
+  circ.add_gate( gate::mcx, std::vector<qubit_id>{q[0], q[1], q[2]}, std::vector<qubit_id>{q[4]} );
+  circ.add_gate( gate::cx, q[4], q[3] );
+  circ.add_gate( gate::mcx, std::vector<qubit_id>{q[0], q[1], q[2]}, std::vector<qubit_id>{q[4]} );
+
+  /* an AND of 3 literals is a chain of 2 logical ANDs, its uncomputation needs no T gates */
+  const auto [cnots, t_count, t_depth] = caterpillar::detail::qc_stats( circ );
+  CHECK( cnots == 1u );
+  CHECK( t_count == 8u );
+  CHECK( t_depth == 4u );
+}
+
+TEST_CASE( "Resource estimation of Toffoli gates with different controls onto one target", "[resource_estimation]" )
+{
+  using namespace caterpillar;
+  using namespace tweedledum;
+
+  netlist<stg_gate> circ;
+  const auto a = circ.add_qubit();
+  const auto b = circ.add_qubit();
+  const auto c = circ.add_qubit();
+  const auto t = circ.add_qubit();
+
+  /* the cubes of an ESOP onto the same target, none uncomputes another */
+  circ.add_gate( gate::mcx, std::vector<qubit_id>( {a, b} ), {t} );
+  circ.add_gate( gate::mcx, std::vector<qubit_id>( {b, c} ), {t} );
+  circ.add_gate( gate::mcx, std::vector<qubit_id>( {a, !c} ), {t} );
+  CHECK( estimate_resources( circ ).t_count == 12u );
+
+  /* same controls as the last AND onto the target */
+  circ.add_gate( gate::mcx, std::vector<qubit_id>( {!c, a} ), {t} );
+  CHECK( estimate_resources( circ ).t_count == 12u );
+}
+
+TEST_CASE( "Resource estimation of LUT gates", "[resource_estimation]" )
+{
+  using namespace caterpillar;
+  using namespace tweedledum;
+
+  netlist<stg_gate> circ;
+  const auto a = circ.add_qubit();
+  const auto b = circ.add_qubit();
+  const auto c = circ.add_qubit();
+  const auto t = circ.add_qubit();
+
+  /* majority as LUT gate, its cost depends on how it is synthesized */
+  kitty::dynamic_truth_table maj( 3u );
+  kitty::create_majority( maj );
+  circ.add_gate( stg_gate( maj, {a, b, c}, t ) );
+
+  auto st = estimate_resources( circ );
+  CHECK( st.num_gates == 1u );
+  CHECK( st.num_uncosted_gates == 1u );
+  CHECK( st.t_count == 0u );
+  CHECK( st.gates_by_controls == std::vector<uint64_t>{0u, 0u, 0u, 1u} );
+  CHECK( st.to_json()["uncosted_gates"] == 1u );
+
+  /* measured AND uncomputations are LUT gates that are costed */
+  netlist<stg_gate> ands;
+  const auto x = ands.add_qubit();
+  const auto y = ands.add_qubit();
+  const auto z = ands.add_qubit();
+  ands.add_gate( gate::mcx, std::vector<qubit_id>( {x, y} ), {z} );
+  ands.add_gate( stg_gate::measured_and_uncompute( x, y, z ) );
+
+  st = estimate_resources( ands );
+  CHECK( st.num_uncosted_gates == 0u );
+  CHECK( st.num_measurements == 1u );
+  CHECK( st.t_count == 4u );
+  CHECK( std::get<1>( caterpillar::detail::qc_stats( ands ) ) == 4u );
+}
+
+TEST_CASE( "Resource estimation as dry run of synthesis", "[resource_estimation]" )
+{
+  using namespace caterpillar;
+  using namespace mockturtle;
+
+  xag_network xag;
+  std::vector<xag_network::signal> a( 8u ), b( 8u );
+  std::generate( a.begin(), a.end(), [&]() { return xag.create_pi(); } );
+  std::generate( b.begin(), b.end(), [&]() { return xag.create_pi(); } );
+  auto carry = xag.get_constant( false );
+  carry_ripple_adder_inplace( xag, a, b, carry );
+  std::for_each( a.begin(), a.end(), [&]( auto f ) { xag.create_po( f ); } );
+  xag.create_po( carry );
+
+  tweedledum::netlist<stg_gate> circ;
+  xag_mapping_strategy strategy;
+  logic_network_synthesis( circ, xag, strategy );
+
+  resource_estimator estimator;
+  xag_mapping_strategy strategy2;
+  logic_network_synthesis( estimator, xag, strategy2 );
+
+  const auto st = estimator.stats();
+  const auto [cnots, t_count, t_depth] = caterpillar::detail::qc_stats( circ );
+  CHECK( st.num_qubits == circ.num_qubits() );
+  CHECK( st.num_gates == circ.num_gates() );
+  CHECK( st.cnot_count == cnots );
+  CHECK( st.t_count == t_count );
+  CHECK( st.t_depth == t_depth );
+
+  /* explicit T gates after lowering into Clifford+T */
+  resource_estimator estimator_ct;
+  decompose_with_ands( estimator_ct, circ );
+  const auto st_ct = estimator_ct.stats();
+  /* each AND contributes 4 T gates and an S gate written as two T gates */
+  CHECK( st_ct.t_count == 3u * t_count / 2u );
+  uint64_t sum{0u};
+  for ( auto n : st_ct.t_layers )
+  {
+    sum += n;
+  }
+  CHECK( sum == st_ct.t_count );
+}
@@ -0,0 +1,100 @@
+#include <catch.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <caterpillar/details/trace.hpp>
+#include <caterpillar/structures/stg_gate.hpp>
+#include <caterpillar/synthesis/lhrs.hpp>
+#include <caterpillar/synthesis/strategies/best_fit_mapping_strategy.hpp>
+#include <mockturtle/networks/aig.hpp>
+#include <tweedledum/networks/netlist.hpp>
+
+TEST_CASE( "Trace spans of logic network synthesis", "[trace]" )
+{
+  using namespace caterpillar;
+  using namespace mockturtle;
+  using namespace tweedledum;
+
+  aig_network aig;
+  const auto a = aig.create_pi();
+  const auto b = aig.create_pi();
+  const auto c = aig.create_pi();
+  aig.create_po( aig.create_and( aig.create_and( a, b ), c ) );
+
+  clear_trace();
+
+  netlist<stg_gate> circ;
+  best_fit_mapping_strategy<aig_network> strategy;
+  logic_network_synthesis_stats st;
+  logic_network_synthesis( circ, aig, strategy, stg_from_pprm(), {}, &st );
+
+  const std::string filename = "caterpillar_trace_test.json";
+#ifdef CATERPILLAR_TRACE
+  REQUIRE( write_trace( filename ) );
+
+  std::ifstream is( filename );
+  std::stringstream buffer;
+  buffer << is.rdbuf();
+  const auto trace = nlohmann::json::parse( buffer.str() );
+
+  uint32_t compute_steps{0u}, remap_cell{0u}, stg_fn{0u}, prepare_outputs{0u};
+  for ( auto const& event : trace["traceEvents"] )
+  {
+    CHECK( event["ph"] == "X" );
+    CHECK( event["dur"] >= 0 );
+    compute_steps += event["name"] == "compute_steps";
+    remap_cell += event["name"] == "remap_cell";
+    stg_fn += event["name"] == "stg_fn";
+    prepare_outputs += event["name"] == "prepare_outputs";
+  }
+  CHECK( compute_steps == 1u );
+  CHECK( remap_cell > 0u );
+  CHECK( stg_fn == st.profile.num_steps() );
+  CHECK( prepare_outputs == 1u );
+  std::remove( filename.c_str() );
+#else
+  CHECK( !write_trace( filename ) );
+#endif
+}
+
+TEST_CASE( "Write trace while threads record spans", "[trace]" )
+{
+  using namespace caterpillar;
+
+  clear_trace();
+
+  std::atomic<bool> done{false};
+  std::vector<std::thread> workers;
+  for ( auto i = 0u; i < 4u; ++i )
+  {
+    workers.emplace_back( [&]() {
+      for ( auto k = 0u; k < 10000u && !done; ++k )
+      {
+        CATERPILLAR_TRACE_SPAN( "worker" );
+      }
+    } );
+  }
+
+  const std::string filename = "caterpillar_trace_threads_test.json";
+  for ( auto i = 0u; i < 10u; ++i )
+  {
+#ifdef CATERPILLAR_TRACE
+    CHECK( write_trace( filename ) );
+#else
+    CHECK( !write_trace( filename ) );
+#endif
+  }
+  done = true;
+  for ( auto& worker : workers )
+  {
+    worker.join();
+  }
+  clear_trace();
+  std::remove( filename.c_str() );
+}
@@ -0,0 +1,62 @@
+#include <catch.hpp>
+
+#include <caterpillar/optimization/mc_optimization.hpp>
+#include <caterpillar/structures/stg_gate.hpp>
+#include <caterpillar/synthesis/lhrs.hpp>
+#include <caterpillar/synthesis/strategies/xag_mapping_strategy.hpp>
+#include <caterpillar/synthesis/xag_tracer.hpp>
+#include <caterpillar/verification/circuit_to_logic_network.hpp>
+#include <kitty/static_truth_table.hpp>
+#include <mockturtle/algorithms/simulation.hpp>
+#include <mockturtle/networks/xag.hpp>
+#include <tweedledum/networks/netlist.hpp>
+
+TEST_CASE( "reduce multiplicative complexity before synthesis", "[mc_optimization]" )
+{
+  using namespace caterpillar;
+  using namespace mockturtle;
+  using namespace tweedledum;
+
+  /* two 3-bit ripple-carry adders, the optimum is one AND per carry */
+  xag_network xag;
+  for ( auto k = 0u; k < 2u; ++k )
+  {
+    std::vector<xag_network::signal> a( 3u ), b( 3u );
+    std::generate( a.begin(), a.end(), [&]() { return xag.create_pi(); } );
+    std::generate( b.begin(), b.end(), [&]() { return xag.create_pi(); } );
+    auto carry = xag.get_constant( false );
+    for ( auto i = 0u; i < 3u; ++i )
+    {
+      xag.create_po( xag.create_xor( xag.create_xor( a[i], b[i] ), carry ) );
+      carry = xag.create_or( xag.create_and( a[i], b[i] ), xag.create_and( carry, xag.create_or( a[i], b[i] ) ) );
+    }
+    xag.create_po( carry );
+  }
+  const auto expected = simulate<kitty::static_truth_table<12>>( xag );
+
+  mc_optimization_params ps;
+  ps.num_threads = 2u;
+  mc_optimization_stats st;
+  const auto opt = mc_optimization( xag, ps, &st );
+
+  CHECK( simulate<kitty::static_truth_table<12>>( opt ) == expected );
+  CHECK( st.num_windows == 4u );
+  CHECK( st.ands_before == 20u );
+  CHECK( st.ands_after == 6u );
+  CHECK( st.and_depth_after <= st.and_depth_before );
+  CHECK( !st.timed_out );
+
+  /* the optimized network feeds directly into synthesis */
+  netlist<stg_gate> circ;
+  xag_mapping_strategy strategy;
+  logic_network_synthesis_stats sst;
+  logic_network_synthesis( circ, opt, strategy, {}, {}, &sst );
+  const auto ntk = circuit_to_logic_network<xag_network>( circ, sst.i_indexes, sst.o_indexes );
+  REQUIRE( ntk );
+  CHECK( simulate<kitty::static_truth_table<12>>( *ntk ) == expected );
+
+  xag_tracer_stats tst;
+  xag_mapping_strategy tracer_strategy;
+  xag_tracer( opt, tracer_strategy, {}, &tst );
+  CHECK( tst.T_count == 4u * st.ands_after );
+}
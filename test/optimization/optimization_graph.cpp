@@ -0,0 +1,112 @@
+#include <catch.hpp>
+
+#include <caterpillar/details/reed_muller.hpp>
+#include <caterpillar/optimization/post_opt_esop.hpp>
+#include <caterpillar/structures/stg_gate.hpp>
+#include <caterpillar/synthesis/stg_to_mcx.hpp>
+#include <caterpillar/verification/circuit_to_logic_network.hpp>
+#include <kitty/constructors.hpp>
+#include <kitty/cube.hpp>
+#include <kitty/dynamic_truth_table.hpp>
+#include <kitty/esop.hpp>
+#include <mockturtle/algorithms/simulation.hpp>
+#include <mockturtle/networks/xag.hpp>
+#include <tweedledum/networks/netlist.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace caterpillar;
+
+static bool same_cubes( std::vector<kitty::cube> a, std::vector<kitty::cube> b )
+{
+  const auto less = []( auto const& x, auto const& y ) { return x._value < y._value; };
+  std::sort( a.begin(), a.end(), less );
+  std::sort( b.begin(), b.end(), less );
+  return a == b;
+}
+
+TEST_CASE( "pair cubes with equal literals", "[optimization_graph]" )
+{
+  kitty::dynamic_truth_table tt( 3 );
+  kitty::create_from_binary_string( tt, "10000001" );
+  const auto esop = kitty::esop_from_optimum_pkrm( tt );
+
+  const auto opt = match_pairing( esop );
+  CHECK( opt.pairing == std::vector<int>{2} );
+  CHECK( same_cubes( opt.cubes, esop ) );
+
+  CHECK( match_pairing( {} ).cubes.empty() );
+}
+
+TEST_CASE( "greedy and exact pairing keep all cubes", "[optimization_graph]" )
+{
+  std::mt19937 gen( 42 );
+  for ( auto i = 0u; i < 20u; ++i )
+  {
+    kitty::dynamic_truth_table tt( 5 );
+    kitty::create_random( tt, gen() );
+    const auto esop = kitty::esop_from_pprm( tt );
+
+    const auto greedy = match_pairing( esop );
+    CHECK( same_cubes( greedy.cubes, esop ) );
+
+    esop_matching_params ps;
+    ps.exact = true;
+    ps.exact_time_budget = 0.5;
+    const auto exact = match_pairing( esop, ps );
+    CHECK( same_cubes( exact.cubes, esop ) );
+    CHECK( exact.pairing.size() * 2u <= esop.size() );
+  }
+}
+
+TEST_CASE( "exact pairing of a large ESOP", "[optimization_graph]" )
+{
+  /* the search is one level deep per cube */
+  kitty::dynamic_truth_table tt( 14 );
+  kitty::create_random( tt, 14 );
+  const auto esop = pprm_cubes( tt );
+  REQUIRE( esop.size() > 8000u );
+
+  /* greedy matching does not depend on time, the exact search is bounded */
+  CHECK( esop_matching_params{}.time_budget == 0.0 );
+  CHECK( esop_matching_params{}.exact_time_budget > 0.0 );
+
+  esop_matching_params ps;
+  ps.exact = true;
+  ps.exact_time_budget = 2.0;
+  const auto exact = match_pairing( esop, ps );
+  CHECK( same_cubes( exact.cubes, esop ) );
+  CHECK( exact.pairing.size() >= match_pairing( esop ).pairing.size() );
+}
+
+TEST_CASE( "synthesize paired cubes with different polarities", "[optimization_graph]" )
+{
+  /* pairs of cubes with equal literals, including negative common literals */
+  for ( auto a = 0u; a < 16u; ++a )
+  {
+    for ( auto b = a + 1u; b < 16u; ++b )
+    {
+      const std::vector<kitty::cube> esop = {kitty::cube( a, 0xf ), kitty::cube( b, 0xf )};
+      REQUIRE( match_pairing( esop ).pairing == std::vector<int>{2} );
+
+      kitty::dynamic_truth_table tt( 4 );
+      kitty::create_from_cubes( tt, esop, true );
+
+      tweedledum::netlist<stg_gate> circ;
+      std::vector<uint32_t> qubit_map;
+      for ( auto i = 0u; i <= 4u; ++i )
+      {
+        circ.add_qubit();
+        qubit_map.push_back( i );
+      }
+      stg_from_esop( [&]( kitty::dynamic_truth_table const& ) { return esop; }, true )( circ, tt, qubit_map );
+
+      const auto xag = circuit_to_logic_network<mockturtle::xag_network>( circ, {0u, 1u, 2u, 3u}, {4u} );
+      REQUIRE( xag );
+      mockturtle::default_simulator<kitty::dynamic_truth_table> sim( 4u );
+      CHECK( mockturtle::simulate<kitty::dynamic_truth_table>( *xag, sim )[0] == tt );
+    }
+  }
+}
@@ -0,0 +1,48 @@
+#include <catch.hpp>
+
+#include <vector>
+
+#include <caterpillar/solvers/sat_backends.hpp>
+
+using namespace caterpillar;
+
+template<class Backend>
+static void check_resolve()
+{
+  Backend solver;
+  solver.set_nr_vars( 2 );
+  if constexpr ( has_freeze_v<Backend> )
+  {
+    /* assumed variables must not be eliminated */
+    solver.freeze( 0 );
+    solver.freeze( 1 );
+  }
+
+  /* x0 or x1 */
+  std::vector<pabc::lit> clause{pabc::Abc_Var2Lit( 0, 0 ), pabc::Abc_Var2Lit( 1, 0 )};
+  solver.add_clause( clause.data(), clause.data() + clause.size() );
+
+  /* same solver, no new clauses, only the assumptions change */
+  const auto solve = [&]( std::vector<pabc::lit> assumptions ) {
+    return solver.solve( assumptions.data(), assumptions.data() + assumptions.size(), 0 );
+  };
+
+  CHECK( solve( {pabc::Abc_Var2Lit( 0, 1 )} ) == percy::success );
+  CHECK( solver.var_value( 0 ) == 0 );
+  CHECK( solver.var_value( 1 ) == 1 );
+
+  CHECK( solve( {pabc::Abc_Var2Lit( 0, 1 ), pabc::Abc_Var2Lit( 1, 1 )} ) == percy::failure );
+
+  CHECK( solve( {pabc::Abc_Var2Lit( 1, 1 )} ) == percy::success );
+  CHECK( solver.var_value( 0 ) == 1 );
+  CHECK( solver.var_value( 1 ) == 0 );
+}
+
+TEST_CASE( "Re-solve SAT backends with different assumptions", "[sat_backends]" )
+{
+  check_resolve<bsat_backend>();
+  check_resolve<bill_backend<bill::solvers::glucose_41>>();
+  check_resolve<bill_backend<bill::solvers::maple>>();
+  check_resolve<bill_backend<bill::solvers::bsat2>>();
+  check_resolve<glucose_simp_backend>();
+}
@@ -1,13 +1,17 @@
 #include <catch.hpp>
 
+#include <algorithm>
 #include <cstdint>
+#include <vector>
 
 #include <caterpillar/structures/stg_gate.hpp>
 #include <caterpillar/synthesis/lhrs.hpp>
 #include <caterpillar/synthesis/strategies/best_fit_mapping_strategy.hpp>
 #include <caterpillar/verification/circuit_to_logic_network.hpp>
+#include <caterpillar/verification/simulate_circuit.hpp>
 #include <kitty/static_truth_table.hpp>
 #include <mockturtle/algorithms/simulation.hpp>
+#include <mockturtle/generators/arithmetic.hpp>
 #include <mockturtle/networks/aig.hpp>
 #include <tweedledum/io/write_unicode.hpp>
 #include <tweedledum/networks/netlist.hpp>
@@ -44,3 +48,29 @@ TEST_CASE( "Best-fit mapping strategy for 3-bit sorting network", "[best_fit_map
   CHECK( sorter2 );
   CHECK( simulate<kitty::static_truth_table<3>>( sorter ) == simulate<kitty::static_truth_table<3>>( *sorter2 ) );
 }
+
+TEST_CASE( "Best-fit mapping strategy for cells with shared fanins", "[best_fit_mapping_strategy]" )
+{
+  using namespace caterpillar;
+  using namespace mockturtle;
+  using namespace tweedledum;
+
+  /* the last carry of the adder is read by the cells of both last outputs */
+  aig_network adder;
+  std::vector<aig_network::signal> a( 10u ), b( 10u );
+  std::generate( a.begin(), a.end(), [&]() { return adder.create_pi(); } );
+  std::generate( b.begin(), b.end(), [&]() { return adder.create_pi(); } );
+  auto carry = adder.get_constant( false );
+  carry_ripple_adder_inplace( adder, a, b, carry );
+  std::for_each( a.begin(), a.end(), [&]( auto f ) { adder.create_po( f ); } );
+  adder.create_po( carry );
+
+  netlist<stg_gate> circ;
+  logic_network_synthesis_stats st;
+  best_fit_mapping_strategy<aig_network> strategy;
+  logic_network_synthesis( circ, adder, strategy, {}, {}, &st );
+
+  const auto result = simulation_checking( circ, adder, st.i_indexes, st.o_indexes );
+  REQUIRE( result );
+  CHECK( *result );
+}
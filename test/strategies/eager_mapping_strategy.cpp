@@ -1,14 +1,20 @@
 #include <catch.hpp>
 
+#include <algorithm>
 #include <cstdint>
+#include <iterator>
+#include <vector>
 
 #include <caterpillar/structures/stg_gate.hpp>
 #include <caterpillar/synthesis/lhrs.hpp>
+#include <caterpillar/synthesis/strategies/bennett_mapping_strategy.hpp>
 #include <caterpillar/synthesis/strategies/eager_mapping_strategy.hpp>
 #include <caterpillar/verification/circuit_to_logic_network.hpp>
 #include <kitty/static_truth_table.hpp>
 #include <mockturtle/algorithms/simulation.hpp>
+#include <mockturtle/generators/arithmetic.hpp>
 #include <mockturtle/networks/aig.hpp>
+#include <mockturtle/networks/xag.hpp>
 #include <tweedledum/io/write_unicode.hpp>
 #include <tweedledum/networks/netlist.hpp>
 
@@ -72,3 +78,59 @@ TEST_CASE( "Eager mapping strategy for 3-bit sorting network", "[eager_mapping_s
 
   //write_unicode(circ, false);
 }
+
+TEST_CASE( "Ancilla-aware compute order for interleaved adders", "[eager_mapping_strategy]" )
+{
+  using namespace caterpillar;
+  using namespace mockturtle;
+  using namespace tweedledum;
+
+  /* four 2-bit adders whose gates and outputs are created bit by bit */
+  xag_network xag;
+  std::vector<std::vector<xag_network::signal>> a( 4u ), b( 4u );
+  std::vector<xag_network::signal> carry( 4u );
+  for ( auto k = 0u; k < 4u; ++k )
+  {
+    std::generate_n( std::back_inserter( a[k] ), 2u, [&]() { return xag.create_pi(); } );
+    std::generate_n( std::back_inserter( b[k] ), 2u, [&]() { return xag.create_pi(); } );
+    carry[k] = xag.get_constant( false );
+  }
+  for ( auto i = 0u; i < 2u; ++i )
+  {
+    for ( auto k = 0u; k < 4u; ++k )
+    {
+      const auto [s, c] = full_adder( xag, a[k][i], b[k][i], carry[k] );
+      xag.create_po( s );
+      carry[k] = c;
+    }
+  }
+  for ( auto k = 0u; k < 4u; ++k )
+  {
+    xag.create_po( carry[k] );
+  }
+  const auto expected = simulate<kitty::static_truth_table<16>>( xag );
+
+  const auto order = ancilla_aware_order( xag );
+  CHECK( order.size() == xag.num_gates() );
+
+  logic_network_synthesis_stats st_topo, st_aware;
+  netlist<stg_gate> circ_topo, circ_aware;
+  eager_mapping_strategy<xag_network> topo;
+  eager_mapping_strategy<xag_network> aware( compute_order::ancilla_aware );
+  logic_network_synthesis( circ_topo, xag, topo, {}, {}, &st_topo );
+  logic_network_synthesis( circ_aware, xag, aware, {}, {}, &st_aware );
+  CHECK( st_aware.required_ancillae < st_topo.required_ancillae );
+
+  const auto ntk = circuit_to_logic_network<xag_network>( circ_aware, st_aware.i_indexes, st_aware.o_indexes );
+  REQUIRE( ntk );
+  CHECK( simulate<kitty::static_truth_table<16>>( *ntk ) == expected );
+
+  /* Bennett keeps all values live, the order does not change the ancillae */
+  logic_network_synthesis_stats st_bennett;
+  netlist<stg_gate> circ_bennett;
+  bennett_mapping_strategy<xag_network> bennett( compute_order::ancilla_aware );
+  logic_network_synthesis( circ_bennett, xag, bennett, {}, {}, &st_bennett );
+  const auto ntk_bennett = circuit_to_logic_network<xag_network>( circ_bennett, st_bennett.i_indexes, st_bennett.o_indexes );
+  REQUIRE( ntk_bennett );
+  CHECK( simulate<kitty::static_truth_table<16>>( *ntk_bennett ) == expected );
+}
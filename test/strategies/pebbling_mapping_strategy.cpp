@@ -1,11 +1,16 @@
 #include <catch.hpp>
 
+#include <algorithm>
 #include <cstdint>
+#include <functional>
+#include <vector>
 
 #include <caterpillar/caterpillar.hpp>
+#include <caterpillar/verification/simulate_circuit.hpp>
 
 #include <kitty/static_truth_table.hpp>
 #include <mockturtle/algorithms/simulation.hpp>
+#include <mockturtle/generators/arithmetic.hpp>
 #include <mockturtle/networks/aig.hpp>
 #include <mockturtle/networks/xag.hpp>
 #include <tweedledum/io/write_unicode.hpp>
@@ -46,6 +51,252 @@ TEST_CASE( "Pebble mapping strategy for 3-bit sorting network bsat", "[pebbling_
   CHECK( simulate<kitty::static_truth_table<3>>( sorter ) == simulate<kitty::static_truth_table<3>>( *sorter2 ) );
 }
 
+TEST_CASE( "Pebble mapping strategy for 3-bit sorting network with other SAT backends", "[pebbling_mapping_strategy4]" )
+{
+  using namespace caterpillar;
+  using namespace mockturtle;
+  using namespace tweedledum;
+
+  aig_network sorter;
+  const auto a = sorter.create_pi();
+  const auto b = sorter.create_pi();
+  const auto c = sorter.create_pi();
+
+  const auto w1 = sorter.create_and( a, b );
+  const auto w2 = sorter.create_and( c, w1 );
+  const auto w3 = sorter.create_and( !a, !b );
+  const auto w4 = sorter.create_and( !c, !w1 );
+  const auto w5 = sorter.create_and( !w3, !w4 );
+  const auto w6 = sorter.create_or( c, !w3 );
+
+  sorter.create_po( w2 );
+  sorter.create_po( w5 );
+  sorter.create_po( w6 );
+
+  pebbling_mapping_strategy_params ps;
+  ps.pebble_limit = 5;
+
+  const auto check = [&]( auto& strategy ) {
+    netlist<stg_gate> circ;
+    logic_network_synthesis_stats st;
+    logic_network_synthesis( circ, sorter, strategy, {}, {}, &st );
+
+    CHECK( circ.num_gates() != 0 );
+
+    const auto sorter2 = circuit_to_logic_network<aig_network>( circ, st.i_indexes, st.o_indexes );
+    CHECK( sorter2 );
+    CHECK( simulate<kitty::static_truth_table<3>>( sorter ) == simulate<kitty::static_truth_table<3>>( *sorter2 ) );
+  };
+
+  pebbling_mapping_strategy<aig_network, bsat_pebble_solver<aig_network, bill_backend<bill::solvers::glucose_41>>> glucose_strategy( ps );
+  check( glucose_strategy );
+
+  pebbling_mapping_strategy<aig_network, bsat_pebble_solver<aig_network, bill_backend<bill::solvers::maple>>> maple_strategy( ps );
+  check( maple_strategy );
+
+  pebbling_mapping_strategy<aig_network, bsat_pebble_solver<aig_network, glucose_simp_backend>> simp_strategy( ps );
+  check( simp_strategy );
+}
+
+TEST_CASE( "Pebble XAG inplace bsat", "[pebbling_mapping_strategy3]" )
+{
+  using namespace caterpillar;
+  using namespace mockturtle;
+  using namespace tweedledum;
+
+  xag_network xag;
+
+  auto n1 = xag.create_pi();
+  auto n2 = xag.create_pi();
+  auto n3 = xag.create_pi();
+  auto n4 = xag.create_pi();
+
+  auto n5 = xag.create_and( n1, n2 );
+  auto n6 = xag.create_xor( n5, n3 );
+  auto n7 = xag.create_xor( n3, n4 );
+  auto n8 = xag.create_and( n6, n7 );
+
+  xag.create_po( n8 );
+
+  /* 3 pebbles are only enough if n6 is computed in-place onto n5 */
+  pebbling_mapping_strategy_params ps;
+  ps.pebble_limit = 3;
+  pebbling_mapping_strategy<xag_network, bsat_pebble_solver<xag_network>> strategy( ps );
+
+  netlist<stg_gate> rnet;
+  logic_network_synthesis_stats st;
+  logic_network_synthesis( rnet, xag, strategy, {}, {}, &st );
+
+  CHECK( rnet.num_gates() != 0 );
+  CHECK( rnet.num_qubits() <= 7u );
+
+  const auto circ = circuit_to_logic_network<xag_network>( rnet, st.i_indexes, st.o_indexes );
+  CHECK( circ );
+  CHECK( simulate<kitty::static_truth_table<4>>( xag ) == simulate<kitty::static_truth_table<4>>( *circ ) );
+}
+
+TEST_CASE( "Pebble XAG inplace onto a target without its children", "[pebbling_mapping_strategy3]" )
+{
+  using namespace caterpillar;
+  using namespace mockturtle;
+  using namespace tweedledum;
+
+  xag_network xag;
+  std::vector<xag_network::signal> x( 5u );
+  std::generate( x.begin(), x.end(), [&]() { return xag.create_pi(); } );
+
+  const auto a = xag.create_and( x[0], x[1] );
+  const auto b = xag.create_and( x[1], x[2] );
+  const auto c = xag.create_and( a, b );
+  const auto e = xag.create_and( x[3], x[4] );
+  const auto d = xag.create_and( e, x[0] );
+  xag.create_po( xag.create_xor( c, d ) );
+
+  /* 3 pebbles are only enough if the XOR is computed in-place onto c after
+   * a and b have been uncomputed, i.e., while c's children are not pebbled */
+  pebbling_mapping_strategy_params ps;
+  ps.pebble_limit = 3;
+  ps.max_steps = 20;
+  pebbling_mapping_strategy<xag_network, bsat_pebble_solver<xag_network>> strategy( ps );
+
+  netlist<stg_gate> rnet;
+  logic_network_synthesis_stats st;
+  REQUIRE( logic_network_synthesis( rnet, xag, strategy, {}, {}, &st ) );
+  CHECK( st.profile.num_actions[2] > 0u ); /* compute in-place */
+
+  const auto circ = circuit_to_logic_network<xag_network>( rnet, st.i_indexes, st.o_indexes );
+  REQUIRE( circ );
+  CHECK( simulate<kitty::static_truth_table<5>>( xag ) == simulate<kitty::static_truth_table<5>>( *circ ) );
+}
+
+TEST_CASE( "Anytime pebbling for 3-bit sorting network", "[pebbling_mapping_strategy5]" )
+{
+  using namespace caterpillar;
+  using namespace mockturtle;
+  using namespace tweedledum;
+
+  aig_network sorter;
+  const auto a = sorter.create_pi();
+  const auto b = sorter.create_pi();
+  const auto c = sorter.create_pi();
+
+  const auto w1 = sorter.create_and( a, b );
+  const auto w2 = sorter.create_and( c, w1 );
+  const auto w3 = sorter.create_and( !a, !b );
+  const auto w4 = sorter.create_and( !c, !w1 );
+  const auto w5 = sorter.create_and( !w3, !w4 );
+  const auto w6 = sorter.create_or( c, !w3 );
+
+  sorter.create_po( w2 );
+  sorter.create_po( w5 );
+  sorter.create_po( w6 );
+
+  std::vector<uint32_t> pebbles;
+  pebbling_mapping_strategy_params ps;
+  ps.anytime = true;
+  ps.max_steps = 20;
+  ps.search_timeout = 5;
+  ps.progress_callback = [&]( uint32_t p ) { pebbles.push_back( p ); };
+  pebbling_mapping_strategy_stats pst;
+  pebbling_mapping_strategy<aig_network, bsat_pebble_solver<aig_network>> strategy( ps, &pst );
+
+  netlist<stg_gate> circ;
+  logic_network_synthesis_stats st;
+  logic_network_synthesis( circ, sorter, strategy, {}, {}, &st );
+
+  /* the first solution is the incumbent, every other one improves it */
+  REQUIRE( pebbles.size() > 1u );
+  CHECK( std::is_sorted( pebbles.rbegin(), pebbles.rend() ) );
+  CHECK( std::adjacent_find( pebbles.begin(), pebbles.end() ) == pebbles.end() );
+
+  CHECK( pst.num_solver_calls > 0u );
+  CHECK( pst.profile.peak_ancillae == pebbles.back() );
+  CHECK( pst.profile.num_actions[0] == st.profile.num_actions[0] );
+
+  const auto sorter2 = circuit_to_logic_network<aig_network>( circ, st.i_indexes, st.o_indexes );
+  CHECK( sorter2 );
+  CHECK( simulate<kitty::static_truth_table<3>>( sorter ) == simulate<kitty::static_truth_table<3>>( *sorter2 ) );
+}
+
+TEST_CASE( "Anytime pebbling with a bill backend", "[pebbling_mapping_strategy5]" )
+{
+  using namespace caterpillar;
+  using namespace mockturtle;
+  using namespace tweedledum;
+
+  aig_network sorter;
+  const auto a = sorter.create_pi();
+  const auto b = sorter.create_pi();
+  const auto c = sorter.create_pi();
+
+  const auto w1 = sorter.create_and( a, b );
+  const auto w2 = sorter.create_and( c, w1 );
+  const auto w3 = sorter.create_and( !a, !b );
+  const auto w4 = sorter.create_and( !c, !w1 );
+  const auto w5 = sorter.create_and( !w3, !w4 );
+  const auto w6 = sorter.create_or( c, !w3 );
+
+  sorter.create_po( w2 );
+  sorter.create_po( w5 );
+  sorter.create_po( w6 );
+
+  /* the solver is reused for every limit, only the assumptions change */
+  std::vector<uint32_t> pebbles;
+  pebbling_mapping_strategy_params ps;
+  ps.anytime = true;
+  ps.max_steps = 20;
+  ps.search_timeout = 60;
+  ps.progress_callback = [&]( uint32_t p ) { pebbles.push_back( p ); };
+  pebbling_mapping_strategy_stats pst;
+  pebbling_mapping_strategy<aig_network, bsat_pebble_solver<aig_network, bill_backend<bill::solvers::glucose_41>>> strategy( ps, &pst );
+
+  netlist<stg_gate> circ;
+  logic_network_synthesis_stats st;
+  logic_network_synthesis( circ, sorter, strategy, {}, {}, &st );
+
+  REQUIRE( pebbles.size() > 1u );
+  CHECK( std::adjacent_find( pebbles.begin(), pebbles.end(), std::less_equal<uint32_t>() ) == pebbles.end() );
+  CHECK( !pst.timeout );
+  CHECK( pst.profile.peak_ancillae == pebbles.back() );
+
+  const auto sorter2 = circuit_to_logic_network<aig_network>( circ, st.i_indexes, st.o_indexes );
+  CHECK( sorter2 );
+  CHECK( simulate<kitty::static_truth_table<3>>( sorter ) == simulate<kitty::static_truth_table<3>>( *sorter2 ) );
+}
+
+TEST_CASE( "Anytime pebbling stops at the search timeout", "[pebbling_mapping_strategy6]" )
+{
+  using namespace caterpillar;
+  using namespace mockturtle;
+  using namespace tweedledum;
+
+  aig_network aig;
+  std::vector<aig_network::signal> a( 8u ), b( 8u );
+  std::generate( a.begin(), a.end(), [&]() { return aig.create_pi(); } );
+  std::generate( b.begin(), b.end(), [&]() { return aig.create_pi(); } );
+  auto carry = aig.get_constant( false );
+  carry_ripple_adder_inplace( aig, a, b, carry );
+  std::for_each( a.begin(), a.end(), [&]( auto f ) { aig.create_po( f ); } );
+  aig.create_po( carry );
+
+  /* a single pebble is never enough, such that the search runs into the timeout */
+  pebbling_mapping_strategy_params ps;
+  ps.anytime = true;
+  ps.search_timeout = 1;
+  pebbling_mapping_strategy_stats pst;
+  pebbling_mapping_strategy<aig_network, bsat_pebble_solver<aig_network>> strategy( ps, &pst );
+
+  netlist<stg_gate> circ;
+  logic_network_synthesis_stats st;
+  logic_network_synthesis( circ, aig, strategy, {}, {}, &st );
+
+  CHECK( pst.num_solver_calls > 0u );
+  CHECK( pst.timeout );
+  CHECK( to_seconds( pst.time_total ) < 30.0 );
+  CHECK( pst.profile.peak_ancillae < aig.num_gates() );
+  CHECK( *simulation_checking( circ, aig, st.i_indexes, st.o_indexes ) );
+}
+
 #ifdef USE_Z3
 TEST_CASE( "Pebble mapping strategy for 3-bit sorting network z3", "[pebbling_mapping_strategy2]" )
 {
@@ -7,6 +7,11 @@
 #include <tweedledum/tweedledum.hpp>
 #include <tweedledum/io/write_unicode.hpp>
 
+#include <cmath>
+#include <complex>
+#include <sstream>
+#include <vector>
+
 
 TEST_CASE("decompose simple xag", "[XAG decompose]")
 {
@@ -41,7 +46,8 @@ TEST_CASE("decompose simple xag", "[XAG decompose]")
   netlist<mcmt_gate> qcirc;
   decompose_with_ands(qcirc, qnet);
 
-  CHECK(caterpillar::detail::t_cost(qcirc) == 4);
+  /* 4 T gates to compute the AND and 4 in the CCZ of its uncomputation */
+  CHECK(caterpillar::detail::t_cost(qcirc) == 8);
   
 }
 
@@ -85,5 +91,201 @@ TEST_CASE("decompose circ with many ands", "[decopmpose circ with many ands]")
   netlist<mcmt_gate> qcirc;
   decompose_with_ands(qcirc, qnet);
 
-  CHECK(caterpillar::detail::t_cost(qcirc) == 16);
+  CHECK(caterpillar::detail::t_cost(qcirc) == 28);
+}
+
+TEST_CASE("decompose pairs AND computations with uncomputations", "[XAG decompose]")
+{
+  using namespace caterpillar;
+  using namespace tweedledum;
+
+  netlist<stg_gate> rnet;
+  const auto a = rnet.add_qubit();
+  const auto b = rnet.add_qubit();
+  const auto c = rnet.add_qubit();
+
+  /* compute, uncompute, and recompute of the same AND */
+  rnet.add_gate( gate::mcx, std::vector<qubit_id>{a, b}, std::vector<qubit_id>{c} );
+  rnet.add_gate( gate::mcx, std::vector<qubit_id>{b, a}, std::vector<qubit_id>{c} );
+  rnet.add_gate( gate::mcx, std::vector<qubit_id>{a, b}, std::vector<qubit_id>{c} );
+  rnet.add_gate( gate::mcx, std::vector<qubit_id>{a, b}, std::vector<qubit_id>{c} );
+
+  netlist<mcmt_gate> qcirc;
+  decompose_with_ands_stats st;
+  decompose_with_ands( qcirc, rnet, &st );
+
+  CHECK( st.num_and_computes == 2u );
+  CHECK( st.num_and_uncomputes == 2u );
+  CHECK( caterpillar::detail::t_cost( qcirc ) == 2 * 4 + 2 * 4 );
+
+  std::ostringstream os;
+  qasm_stream qasm( os );
+  decompose_with_ands( qasm, rnet );
+
+  const auto str = os.str();
+  CHECK( str.find( "qreg q[3];" ) != std::string::npos );
+  CHECK( str.find( "measure q[2] -> m[0];" ) != std::string::npos );
+  CHECK( str.find( "if(m==1) cz q[0],q[1];" ) != std::string::npos );
+  CHECK( qasm.size() == 2u * 14u + 2u * 4u );
+}
+
+/* state vector of a Clifford+T circuit applied to a basis state */
+static std::vector<std::complex<double>> simulate_clifford_t( tweedledum::netlist<tweedledum::mcmt_gate> const& circ, uint64_t input )
+{
+  using namespace tweedledum;
+
+  std::vector<std::complex<double>> state( uint64_t( 1u ) << circ.num_qubits() );
+  state[input] = 1.0;
+  const auto omega = std::polar( 1.0, M_PI / 4.0 );
+
+  circ.foreach_cgate( [&]( auto const& node ) {
+    auto const& gate = node.gate;
+    uint64_t controls{0u}, targets{0u};
+    gate.foreach_control( [&]( auto q ) { controls |= uint64_t( 1u ) << q.index(); } );
+    gate.foreach_target( [&]( auto q ) { targets |= uint64_t( 1u ) << q.index(); } );
+
+    if ( gate.is( gate_set::hadamard ) )
+    {
+      for ( auto k = 0u; k < state.size(); ++k )
+      {
+        if ( !( k & targets ) )
+        {
+          const auto a = state[k], b = state[k | targets];
+          state[k] = ( a + b ) / std::sqrt( 2.0 );
+          state[k | targets] = ( a - b ) / std::sqrt( 2.0 );
+        }
+      }
+      return;
+    }
+
+    for ( auto k = 0u; k < state.size(); ++k )
+    {
+      if ( ( k & controls ) != controls )
+      {
+        continue;
+      }
+      if ( gate.is( gate_set::pauli_x ) || gate.is( gate_set::cx ) )
+      {
+        if ( !( k & targets ) )
+        {
+          std::swap( state[k], state[k | targets] );
+        }
+      }
+      else if ( k & targets )
+      {
+        if ( gate.is( gate_set::t ) )
+          state[k] *= omega;
+        else if ( gate.is( gate_set::t_dagger ) )
+          state[k] *= std::conj( omega );
+        else if ( gate.is( gate_set::mcz ) )
+          state[k] = -state[k];
+      }
+    }
+  } );
+
+  return state;
+}
+
+TEST_CASE("decompose ANDs with T-depth 1", "[XAG decompose]")
+{
+  using namespace caterpillar;
+  using namespace tweedledum;
+
+  /* two parallel ANDs, one with a negated control, an AND of both, and their uncomputation */
+  netlist<stg_gate> rnet;
+  std::vector<qubit_id> q;
+  for ( auto i = 0u; i < 7u; ++i )
+  {
+    q.push_back( rnet.add_qubit() );
+  }
+  rnet.add_gate( gate::mcx, std::vector<qubit_id>{q[0], q[1]}, std::vector<qubit_id>{q[4]} );
+  rnet.add_gate( gate::mcx, std::vector<qubit_id>{!q[2], q[3]}, std::vector<qubit_id>{q[5]} );
+  rnet.add_gate( gate::mcx, std::vector<qubit_id>{q[4], q[5]}, std::vector<qubit_id>{q[6]} );
+  rnet.add_gate( gate::mcx, std::vector<qubit_id>{!q[2], q[3]}, std::vector<qubit_id>{q[5]} );
+  rnet.add_gate( gate::mcx, std::vector<qubit_id>{q[0], q[1]}, std::vector<qubit_id>{q[4]} );
+
+  decompose_with_ands_params ps;
+  decompose_with_ands_stats st, st1;
+  netlist<mcmt_gate> circ, circ1;
+  decompose_with_ands( circ, rnet, &st );
+  ps.use_tdepth1 = true;
+  decompose_with_ands( circ1, rnet, ps, &st1 );
+
+  CHECK( st1.num_and_computes == st.num_and_computes );
+  CHECK( st1.num_and_uncomputes == st.num_and_uncomputes );
+  CHECK( caterpillar::detail::t_cost( circ1 ) == caterpillar::detail::t_cost( circ ) );
+  CHECK( st.num_helpers == 0u );
+  CHECK( st1.num_helpers == 2u );
+  CHECK( circ1.num_qubits() == 9u );
+
+  /* the first T gate on the clean target of the second layer's AND overlaps
+   * with the first layer, both uncomputations are deferred CCZ gates with
+   * T-depth 3 */
+  CHECK( st.t_depth == 2u + 1u + 3u );
+  CHECK( st1.t_depth == 1u + 1u + 3u );
+
+  /* measured uncomputations need no T layers */
+  resource_estimator estimator, estimator1;
+  decompose_with_ands( estimator, rnet, &st );
+  decompose_with_ands( estimator1, rnet, ps, &st1 );
+  CHECK( st.t_depth == 3u );
+  CHECK( st1.t_depth == 2u );
+
+  /* both lowerings implement the reversible circuit and restore the helpers */
+  for ( auto x = 0u; x < 16u; ++x )
+  {
+    const auto a = x & 1u, b = ( x >> 1 ) & 1u, c = ( x >> 2 ) & 1u, d = ( x >> 3 ) & 1u;
+    const auto expected = x | ( ( a & b & !c & d ) << 6 );
+
+    const auto state = simulate_clifford_t( circ, x );
+    const auto state1 = simulate_clifford_t( circ1, x );
+    CHECK( std::abs( state[expected] - 1.0 ) < 1e-9 );
+    CHECK( std::abs( state1[expected] - 1.0 ) < 1e-9 );
+  }
+}
+
+TEST_CASE("decompose ANDs with T-depth 1 using helpers reserved by lhrs", "[XAG decompose]")
+{
+  using namespace caterpillar;
+  using namespace mockturtle;
+  using namespace tweedledum;
+
+  /* two ANDs in the first level, one in the second */
+  xag_network xag;
+  const auto a = xag.create_pi();
+  const auto b = xag.create_pi();
+  const auto c = xag.create_pi();
+  const auto d = xag.create_pi();
+  xag.create_po( xag.create_and( xag.create_and( a, b ), xag.create_and( c, !d ) ) );
+
+  netlist<stg_gate> rnet;
+  logic_network_synthesis_params ps;
+  ps.low_tdepth_AND = true;
+  logic_network_synthesis_stats st;
+  xag_low_depth_mapping_strategy strategy( true );
+  logic_network_synthesis( rnet, xag, strategy, {}, ps, &st );
+  CHECK( st.helper_qubits.size() == 2u );
+
+  decompose_with_ands_params dps;
+  dps.use_tdepth1 = true;
+  dps.helper_qubits = st.helper_qubits;
+  decompose_with_ands_stats dst;
+  netlist<mcmt_gate> circ;
+  decompose_with_ands( circ, rnet, dps, &dst );
+  CHECK( dst.num_helpers == 0u );
+  CHECK( circ.num_qubits() == rnet.num_qubits() );
+
+  for ( auto x = 0u; x < 16u; ++x )
+  {
+    uint64_t input{0u};
+    for ( auto i = 0u; i < 4u; ++i )
+    {
+      input |= uint64_t( ( x >> i ) & 1u ) << st.i_indexes[i];
+    }
+    const auto f = ( x & 1u ) & ( ( x >> 1 ) & 1u ) & ( ( x >> 2 ) & 1u ) & !( ( x >> 3 ) & 1u );
+    const auto expected = input | ( uint64_t( f ) << st.o_indexes[0] );
+
+    const auto state = simulate_clifford_t( circ, input );
+    CHECK( std::abs( state[expected] - 1.0 ) < 1e-9 );
+  }
 }
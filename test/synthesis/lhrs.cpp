@@ -1,15 +1,23 @@
 #include <catch.hpp>
 
 #include <mockturtle/algorithms/simulation.hpp>
+#include <mockturtle/generators/arithmetic.hpp>
 #include <mockturtle/networks/aig.hpp>
+#include <mockturtle/networks/klut.hpp>
 #include <mockturtle/networks/mig.hpp>
 #include <mockturtle/networks/xag.hpp>
 
 
+#include <caterpillar/details/resource_estimation.hpp>
+#include <caterpillar/details/utils.hpp>
 #include <caterpillar/synthesis/lhrs.hpp>
+#include <caterpillar/synthesis/strategies/abstract_xag_mapping_strategy.hpp>
 #include <caterpillar/synthesis/strategies/bennett_mapping_strategy.hpp>
+#include <caterpillar/synthesis/strategies/eager_mapping_strategy.hpp>
+#include <caterpillar/synthesis/strategies/xag_mapping_strategy.hpp>
 #include <caterpillar/structures/stg_gate.hpp>
 #include <caterpillar/verification/circuit_to_logic_network.hpp>
+#include <caterpillar/verification/simulate_circuit.hpp>
 
 
 #include <tweedledum/algorithms/synthesis/stg.hpp>
@@ -133,3 +141,282 @@ TEST_CASE( "synthesize multioutput maj3", "[multiout MAJ]" )
   CHECK( simulate<kitty::static_truth_table<3>>( *ntk )[1] == ~maj );
   CHECK( simulate<kitty::static_truth_table<3>>( *ntk )[2] == maj );
 }
+
+TEST_CASE( "per-phase profile of synthesis", "[lhrs profile]" )
+{
+  using namespace mockturtle;
+  using namespace caterpillar;
+  using namespace tweedledum;
+
+  aig_network aig;
+  const auto a = aig.create_pi();
+  const auto b = aig.create_pi();
+  const auto c = aig.create_pi();
+  aig.create_po( aig.create_and( aig.create_and( a, b ), c ) );
+
+  netlist<stg_gate> circ;
+  logic_network_synthesis_stats st;
+  bennett_mapping_strategy<aig_network> strategy;
+  logic_network_synthesis( circ, aig, strategy, stg_from_pprm(), {}, &st );
+
+  const auto& profile = st.profile;
+  CHECK( profile.num_actions[0] == 2u ); /* compute */
+  CHECK( profile.num_actions[1] == 1u ); /* uncompute */
+  CHECK( profile.num_steps() == 3u );
+  CHECK( profile.num_gates == circ.num_gates() );
+  CHECK( profile.peak_ancillae == 2u );
+  CHECK( profile.ancillae_watermarks == std::vector<std::pair<uint64_t, uint32_t>>{{1u, 1u}, {2u, 2u}} );
+  CHECK( profile.time_strategy + profile.time_inputs + profile.time_emission + profile.time_outputs <= st.time_total );
+  CHECK( profile.to_json()["compute"] == 2u );
+}
+
+TEST_CASE( "ancilla allocation policies", "[lhrs ancilla policy]" )
+{
+  using namespace mockturtle;
+  using namespace caterpillar;
+  using namespace tweedledum;
+
+  /* two independent chains of ANDs, such that eager uncomputation frees ancillae early */
+  xag_network xag;
+  std::vector<xag_network::signal> pis( 8u );
+  std::generate( pis.begin(), pis.end(), [&]() { return xag.create_pi(); } );
+  auto f = xag.create_and( pis[0], pis[1] );
+  auto g = xag.create_and( pis[4], pis[5] );
+  for ( auto i = 2u; i < 4u; ++i )
+  {
+    f = xag.create_and( f, pis[i] );
+    g = xag.create_and( g, pis[i + 4u] );
+  }
+  xag.create_po( f );
+  xag.create_po( g );
+  const auto expected = simulate<kitty::static_truth_table<8>>( xag );
+
+  /* sequence of qubits targeted by the emitted gates */
+  std::vector<std::vector<uint32_t>> targets;
+  for ( auto policy : {ancilla_policy::lifo, ancilla_policy::fifo, ancilla_policy::least_recently_busy, ancilla_policy::lowest_index} )
+  {
+    netlist<stg_gate> circ;
+    logic_network_synthesis_params ps;
+    ps.ancilla_allocation = policy;
+    logic_network_synthesis_stats st;
+    eager_mapping_strategy<xag_network> strategy;
+    logic_network_synthesis( circ, xag, strategy, stg_from_pprm(), ps, &st );
+
+    const auto ntk = circuit_to_logic_network<xag_network>( circ, st.i_indexes, st.o_indexes );
+    REQUIRE( ntk );
+    CHECK( simulate<kitty::static_truth_table<8>>( *ntk ) == expected );
+
+    auto& t = targets.emplace_back();
+    circ.foreach_cgate( [&]( auto const& node ) {
+      node.gate.foreach_target( [&]( auto q ) { t.push_back( q ); } );
+    } );
+  }
+  CHECK( targets[0] != targets[1] );
+  CHECK( targets[0] != targets[2] );
+  CHECK( targets[1] != targets[3] );
+
+  /* depth-oriented strategies reuse the ancilla that was released first */
+  CHECK( bennett_mapping_strategy<xag_network>().preferred_ancilla_policy() == ancilla_policy::lifo );
+  CHECK( xag_low_depth_mapping_strategy().preferred_ancilla_policy() == ancilla_policy::least_recently_busy );
+  CHECK( abstract_xag_low_depth_mapping_strategy().preferred_ancilla_policy() == ancilla_policy::least_recently_busy );
+}
+
+TEST_CASE( "peephole optimization of emitted gates", "[lhrs peephole]" )
+{
+  using namespace mockturtle;
+  using namespace caterpillar;
+  using namespace tweedledum;
+
+  /* 3-bit adder, whose XOR cones are computed and uncomputed around the ANDs */
+  xag_network xag;
+  std::vector<xag_network::signal> a( 3u ), b( 3u );
+  std::generate( a.begin(), a.end(), [&]() { return xag.create_pi(); } );
+  std::generate( b.begin(), b.end(), [&]() { return xag.create_pi(); } );
+  auto carry = xag.get_constant( false );
+  for ( auto i = 0u; i < 3u; ++i )
+  {
+    const auto p = xag.create_xor( a[i], b[i] );
+    xag.create_po( xag.create_xor( p, carry ) );
+    carry = xag.create_xor( xag.create_and( xag.create_xor( a[i], carry ), p ), a[i] );
+  }
+  xag.create_po( carry );
+  const auto expected = simulate<kitty::static_truth_table<6>>( xag );
+
+  uint32_t num_gates[2];
+  uint64_t num_removed[2];
+  for ( auto peephole : {false, true} )
+  {
+    netlist<stg_gate> circ;
+    logic_network_synthesis_params ps;
+    ps.peephole = peephole;
+    logic_network_synthesis_stats st;
+    xag_mapping_strategy strategy;
+    logic_network_synthesis( circ, xag, strategy, stg_from_pprm(), ps, &st );
+
+    const auto ntk = circuit_to_logic_network<xag_network>( circ, st.i_indexes, st.o_indexes );
+    REQUIRE( ntk );
+    CHECK( simulate<kitty::static_truth_table<6>>( *ntk ) == expected );
+    CHECK( st.profile.num_gates == circ.num_gates() );
+    num_gates[peephole] = circ.num_gates();
+    num_removed[peephole] = st.profile.num_peephole_removed;
+  }
+
+  CHECK( num_removed[0] == 0u );
+  CHECK( num_removed[1] > 0u );
+  CHECK( num_gates[1] + num_removed[1] == num_gates[0] );
+}
+
+TEST_CASE( "synthesize classified k-LUT nodes", "[lhrs klut]" )
+{
+  using namespace mockturtle;
+  using namespace caterpillar;
+  using namespace tweedledum;
+
+  klut_network klut;
+  const auto a = klut.create_pi();
+  const auto b = klut.create_pi();
+  const auto c = klut.create_pi();
+  const auto d = klut.create_pi();
+
+  kitty::dynamic_truth_table and_nb( 2u ), or_na( 3u ), maj_nc( 3u ), lut( 3u );
+  kitty::create_from_binary_string( and_nb, "0010" );
+  kitty::create_from_binary_string( or_na, "11111101" );
+  kitty::create_from_binary_string( maj_nc, "10110010" );
+  kitty::create_from_binary_string( lut, "11100001" );
+
+  const auto f1 = klut.create_node( {a, b}, and_nb );
+  const auto f2 = klut.create_node( {c, d, f1}, or_na );
+  const auto f3 = klut.create_node( {f1, f2, a}, maj_nc );
+  const auto f4 = klut.create_xor( f3, d );
+  const auto f5 = klut.create_node( {f4, b, c}, lut );
+  klut.create_po( f3 );
+  klut.create_po( f5 );
+
+  /* only the generic LUT is synthesized as a single-target gate */
+  auto num_luts = 0u;
+  const auto stg_fn = [&]( auto& circ, auto const& qubits, kitty::dynamic_truth_table const& function ) {
+    ++num_luts;
+    stg_from_pprm()( circ, qubits, function );
+  };
+
+  netlist<stg_gate> circ;
+  logic_network_synthesis_stats st;
+  bennett_mapping_strategy<klut_network> strategy;
+  logic_network_synthesis( circ, klut, strategy, stg_fn, {}, &st );
+  CHECK( num_luts == 1u );
+
+  const auto ntk = circuit_to_logic_network<xag_network>( circ, st.i_indexes, st.o_indexes );
+  REQUIRE( ntk );
+  CHECK( simulate<kitty::static_truth_table<4>>( *ntk ) == simulate<kitty::static_truth_table<4>>( klut ) );
+}
+
+TEST_CASE( "reject level steps for networks without n-ary XORs", "[lhrs levels]" )
+{
+  using namespace mockturtle;
+  using namespace caterpillar;
+  using namespace tweedledum;
+
+  struct level_strategy : mapping_strategy<klut_network>
+  {
+    bool compute_steps( klut_network const& ntk ) override
+    {
+      ntk.foreach_gate( [&]( auto const& n ) {
+        steps().emplace_back( n, compute_level_action{{{ntk.node_to_index( n ), {}}}} );
+      } );
+      return true;
+    }
+  };
+
+  klut_network klut;
+  klut.create_po( klut.create_and( klut.create_pi(), klut.create_pi() ) );
+
+  netlist<stg_gate> circ;
+  level_strategy strategy;
+  CHECK( !logic_network_synthesis( circ, klut, strategy ) );
+}
+
+TEST_CASE( "measurement-based uncomputation of AND nodes", "[lhrs measurement]" )
+{
+  using namespace mockturtle;
+  using namespace caterpillar;
+  using namespace tweedledum;
+
+  /* 3-bit adder, in which Bennett's strategy uncomputes all ANDs but the carry */
+  xag_network xag;
+  std::vector<xag_network::signal> a( 3u ), b( 3u );
+  std::generate( a.begin(), a.end(), [&]() { return xag.create_pi(); } );
+  std::generate( b.begin(), b.end(), [&]() { return xag.create_pi(); } );
+  auto carry = xag.get_constant( false );
+  for ( auto i = 0u; i < 3u; ++i )
+  {
+    const auto [s, c] = full_adder( xag, a[i], b[i], carry );
+    xag.create_po( s );
+    carry = c;
+  }
+  xag.create_po( carry );
+  const auto expected = simulate<kitty::static_truth_table<6>>( xag );
+
+  resource_estimation_params rps;
+  rps.cost_model = mcx_cost_model::clean_ancilla;
+
+  uint64_t t_count[2], num_measured[2];
+  uint32_t qc_t_count[2];
+  for ( auto measure : {false, true} )
+  {
+    netlist<stg_gate> circ;
+    logic_network_synthesis_params ps;
+    ps.measurement_based_uncompute = measure;
+    logic_network_synthesis_stats st;
+    bennett_mapping_strategy<xag_network> strategy;
+    logic_network_synthesis( circ, xag, strategy, {}, ps, &st );
+
+    const auto ntk = circuit_to_logic_network<xag_network>( circ, st.i_indexes, st.o_indexes );
+    REQUIRE( ntk );
+    CHECK( simulate<kitty::static_truth_table<6>>( *ntk ) == expected );
+    CHECK( *simulation_checking( circ, xag, st.i_indexes, st.o_indexes ) );
+
+    uint64_t gates_measured{0u};
+    circ.foreach_cgate( [&]( auto const& n ) {
+      if ( n.gate.is_measurement() )
+      {
+        CHECK( !n.gate.is( gate_set::cz ) );
+        ++gates_measured;
+      }
+    } );
+    CHECK( gates_measured == st.profile.num_measured_uncomputes );
+
+    const auto rst = estimate_resources( circ, rps );
+    CHECK( rst.num_measurements == st.profile.num_measured_uncomputes );
+    t_count[measure] = rst.t_count;
+    num_measured[measure] = st.profile.num_measured_uncomputes;
+
+    qc_t_count[measure] = std::get<1>( caterpillar::detail::qc_stats( circ ) );
+  }
+
+  CHECK( num_measured[0] == 0u );
+  CHECK( num_measured[1] == 3u );
+  CHECK( t_count[1] < t_count[0] );
+  CHECK( t_count[0] - t_count[1] == 7u * num_measured[1] );
+
+  /* the logical-AND model counts every second Toffoli onto a target as measured */
+  CHECK( qc_t_count[0] == qc_t_count[1] );
+
+  /* OR nodes of a MIG are uncomputed as ANDs of the complemented fanins */
+  mig_network mig;
+  const auto x = mig.create_pi();
+  const auto y = mig.create_pi();
+  const auto z = mig.create_pi();
+  mig.create_po( mig.create_and( mig.create_or( x, !y ), z ) );
+
+  netlist<stg_gate> circ;
+  logic_network_synthesis_params ps;
+  ps.measurement_based_uncompute = true;
+  logic_network_synthesis_stats st;
+  bennett_mapping_strategy<mig_network> strategy;
+  logic_network_synthesis( circ, mig, strategy, {}, ps, &st );
+  CHECK( st.profile.num_measured_uncomputes == 1u );
+
+  const auto ntk = circuit_to_logic_network<xag_network>( circ, st.i_indexes, st.o_indexes );
+  REQUIRE( ntk );
+  CHECK( simulate<kitty::static_truth_table<3>>( *ntk ) == simulate<kitty::static_truth_table<3>>( mig ) );
+}
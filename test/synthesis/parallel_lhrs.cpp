@@ -0,0 +1,175 @@
+#include <catch.hpp>
+
+#include <caterpillar/structures/stg_gate.hpp>
+#include <caterpillar/synthesis/decompose_with_ands.hpp>
+#include <caterpillar/synthesis/lhrs.hpp>
+#include <caterpillar/synthesis/parallel_lhrs.hpp>
+#include <caterpillar/synthesis/strategies/bennett_mapping_strategy.hpp>
+#include <caterpillar/synthesis/strategies/eager_mapping_strategy.hpp>
+#include <caterpillar/synthesis/strategies/xag_mapping_strategy.hpp>
+#include <caterpillar/verification/circuit_to_logic_network.hpp>
+#include <kitty/static_truth_table.hpp>
+#include <mockturtle/algorithms/simulation.hpp>
+#include <mockturtle/networks/xag.hpp>
+#include <tweedledum/gates/mcmt_gate.hpp>
+#include <tweedledum/networks/netlist.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+
+TEST_CASE( "parallel synthesis of independent output cones", "[parallel_lhrs]" )
+{
+  using namespace caterpillar;
+  using namespace mockturtle;
+  using namespace tweedledum;
+
+  /* four bit-sliced full adders, the first two share their carry input */
+  xag_network xag;
+  std::vector<xag_network::signal> pis( 11u );
+  std::generate( pis.begin(), pis.end(), [&]() { return xag.create_pi(); } );
+
+  const auto shared = xag.create_and( pis[8], pis[9] );
+  for ( auto i = 0u; i < 4u; ++i )
+  {
+    const auto a = pis[2 * i];
+    const auto b = pis[2 * i + 1];
+    const auto c = i < 2u ? shared : pis[10];
+    xag.create_po( xag.create_xor( xag.create_xor( a, b ), c ) );
+    xag.create_po( !xag.create_or( xag.create_and( a, b ), xag.create_and( c, xag.create_xor( a, b ) ) ) );
+  }
+  xag.create_po( pis[10] );
+  xag.create_po( !pis[10] );
+  const auto expected = simulate<kitty::static_truth_table<11>>( xag );
+
+  for ( auto num_threads : {1u, 4u} )
+  {
+    netlist<stg_gate> circ;
+    parallel_logic_network_synthesis_params ps;
+    ps.num_threads = num_threads;
+    parallel_logic_network_synthesis_stats st;
+    /* the factory is not thread-safe, it must only be called from this thread */
+    std::vector<std::thread::id> callers;
+    const auto make_strategy = [&]() {
+      callers.push_back( std::this_thread::get_id() );
+      return std::make_unique<eager_mapping_strategy<xag_network>>();
+    };
+    CHECK( parallel_logic_network_synthesis( circ, xag, make_strategy, stg_from_pprm(), ps, &st ) );
+    CHECK( callers.size() == st.num_classes );
+    CHECK( std::count( callers.begin(), callers.end(), std::this_thread::get_id() ) == callers.size() );
+
+    /* three cone groups and one group of outputs driven by inputs, the last two adders are isomorphic */
+    CHECK( st.num_groups == 4u );
+    CHECK( st.num_classes == 3u );
+    CHECK( st.num_threads == std::min( num_threads, st.num_classes ) );
+    CHECK( st.i_indexes.size() == xag.num_pis() );
+    CHECK( st.o_indexes.size() == xag.num_pos() );
+    CHECK( circ.num_qubits() == xag.num_pis() + st.required_ancillae );
+
+    const auto ntk = circuit_to_logic_network<xag_network>( circ, st.i_indexes, st.o_indexes );
+    REQUIRE( ntk );
+    CHECK( simulate<kitty::static_truth_table<11>>( *ntk ) == expected );
+
+    /* clean ancillae are reused across groups */
+    netlist<stg_gate> seq;
+    eager_mapping_strategy<xag_network> strategy;
+    logic_network_synthesis_stats seq_st;
+    logic_network_synthesis( seq, xag, strategy, stg_from_pprm(), {}, &seq_st );
+    CHECK( circ.num_qubits() <= seq.num_qubits() );
+  }
+}
+
+TEST_CASE( "memoized synthesis of isomorphic output groups", "[parallel_lhrs]" )
+{
+  using namespace caterpillar;
+  using namespace mockturtle;
+  using namespace tweedledum;
+
+  /* five full adders on disjoint inputs, the last one with a complemented carry */
+  xag_network xag;
+  std::vector<xag_network::signal> pis( 15u );
+  std::generate( pis.begin(), pis.end(), [&]() { return xag.create_pi(); } );
+  for ( auto i = 0u; i < 5u; ++i )
+  {
+    const auto a = pis[3 * i];
+    const auto b = pis[3 * i + 1];
+    const auto c = i < 4u ? pis[3 * i + 2] : !pis[3 * i + 2];
+    xag.create_po( xag.create_xor( xag.create_xor( a, b ), c ) );
+    xag.create_po( xag.create_maj( a, b, c ) );
+  }
+  const auto expected = simulate<kitty::static_truth_table<15>>( xag );
+
+  for ( auto share : {true, false} )
+  {
+    netlist<stg_gate> circ;
+    parallel_logic_network_synthesis_params ps;
+    ps.num_threads = 2u;
+    ps.share_isomorphic_groups = share;
+    parallel_logic_network_synthesis_stats st;
+    const auto make_strategy = []() { return std::make_unique<bennett_mapping_strategy<xag_network>>(); };
+    CHECK( parallel_logic_network_synthesis( circ, xag, make_strategy, stg_from_pprm(), ps, &st ) );
+
+    CHECK( st.num_groups == 5u );
+    CHECK( st.num_classes == ( share ? 2u : 5u ) );
+
+    const auto ntk = circuit_to_logic_network<xag_network>( circ, st.i_indexes, st.o_indexes );
+    REQUIRE( ntk );
+    CHECK( simulate<kitty::static_truth_table<15>>( *ntk ) == expected );
+  }
+}
+
+TEST_CASE( "parallel synthesis shares the helper qubits of T-depth 1 ANDs", "[parallel_lhrs]" )
+{
+  using namespace caterpillar;
+  using namespace mockturtle;
+  using namespace tweedledum;
+
+  /* two groups, each with a level of two ANDs that needs two helpers */
+  xag_network xag;
+  std::vector<xag_network::signal> pis( 8u );
+  std::generate( pis.begin(), pis.end(), [&]() { return xag.create_pi(); } );
+  for ( auto i = 0u; i < 2u; ++i )
+  {
+    const auto f = xag.create_and( pis[4 * i], pis[4 * i + 1] );
+    const auto g = xag.create_and( pis[4 * i + 2], !pis[4 * i + 3] );
+    xag.create_po( xag.create_and( f, g ) );
+  }
+  const auto expected = simulate<kitty::static_truth_table<8>>( xag );
+
+  netlist<stg_gate> circ;
+  parallel_logic_network_synthesis_params ps;
+  ps.num_threads = 2u;
+  ps.share_isomorphic_groups = false;
+  ps.synthesis.low_tdepth_AND = true;
+  parallel_logic_network_synthesis_stats st;
+  const auto make_strategy = []() { return std::make_unique<xag_low_depth_mapping_strategy>( true ); };
+  CHECK( parallel_logic_network_synthesis( circ, xag, make_strategy, stg_from_pprm(), ps, &st ) );
+
+  REQUIRE( st.num_groups == 2u );
+  CHECK( st.helper_qubits.size() == 4u );
+  CHECK( circ.num_qubits() == xag.num_pis() + st.required_ancillae );
+
+  /* helper qubits are not used by any gate */
+  std::vector<uint32_t> used;
+  circ.foreach_cgate( [&]( auto const& n ) {
+    n.gate.foreach_control( [&]( auto q ) { used.push_back( q.index() ); } );
+    n.gate.foreach_target( [&]( auto q ) { used.push_back( q.index() ); } );
+  } );
+  for ( auto h : st.helper_qubits )
+  {
+    CHECK( std::find( used.begin(), used.end(), h ) == used.end() );
+  }
+
+  const auto ntk = circuit_to_logic_network<xag_network>( circ, st.i_indexes, st.o_indexes );
+  REQUIRE( ntk );
+  CHECK( simulate<kitty::static_truth_table<8>>( *ntk ) == expected );
+
+  decompose_with_ands_params dps;
+  dps.use_tdepth1 = true;
+  dps.helper_qubits = st.helper_qubits;
+  decompose_with_ands_stats dst;
+  netlist<mcmt_gate> ct;
+  decompose_with_ands( ct, circ, dps, &dst );
+  CHECK( dst.num_helpers == 0u );
+  CHECK( ct.num_qubits() == circ.num_qubits() );
+}
@@ -34,6 +34,31 @@ TEST_CASE( "Optimum phase polynomial circuit for Toffoli with 2 controls", "[sat
   CHECK( circ.num_qubits() == 3u );
 }
 
+TEST_CASE( "Optimum phase polynomial circuit for Toffoli with 2 controls using variable elimination", "[satbased_cnotrz]" )
+{
+  tweedledum::bit_matrix_rm<> transform( 3u, 3u );
+  transform.at( 0, 0 ) = 1;
+  transform.at( 1, 1 ) = 1;
+  transform.at( 2, 2 ) = 1;
+
+  tweedledum::parity_terms terms;
+  constexpr auto T = tweedledum::symbolic_angles::one_eighth;
+  constexpr auto Tdag = tweedledum::symbolic_angles::seven_eighth;
+
+  terms.add_term( 0b001, T );
+  terms.add_term( 0b010, T );
+  terms.add_term( 0b011, Tdag );
+  terms.add_term( 0b100, T );
+  terms.add_term( 0b101, Tdag );
+  terms.add_term( 0b110, Tdag );
+  terms.add_term( 0b111, T );
+
+  const auto circ = caterpillar::satbased_cnotrz<tweedledum::netlist<tweedledum::mcst_gate>, caterpillar::glucose_simp_backend>( transform, terms );
+
+  CHECK( circ.num_gates() == 13u );
+  CHECK( circ.num_qubits() == 3u );
+}
+
 TEST_CASE( "Optimum phase polynomial circuit for Toffoli with 3 controls", "[satbased_cnotrz]" )
 {
   return; // ? (this test case takes a while, but works)
@@ -97,3 +122,86 @@ TEST_CASE( "Optimum phase polynomial circuit for smaller circuit with 4 qubits",
   CHECK( circ.num_gates() == 16u );
   CHECK( circ.num_qubits() == 4u );
 }
+
+TEST_CASE( "Warm-started phase polynomial synthesis", "[satbased_cnotrz]" )
+{
+  tweedledum::bit_matrix_rm<> transform( 3u, 3u );
+  transform.at( 0, 0 ) = 1;
+  transform.at( 1, 1 ) = 1;
+  transform.at( 2, 2 ) = 1;
+
+  tweedledum::parity_terms terms;
+  constexpr auto T = tweedledum::symbolic_angles::one_eighth;
+  constexpr auto Tdag = tweedledum::symbolic_angles::seven_eighth;
+
+  terms.add_term( 0b001, T );
+  terms.add_term( 0b010, T );
+  terms.add_term( 0b011, Tdag );
+  terms.add_term( 0b100, T );
+  terms.add_term( 0b101, Tdag );
+  terms.add_term( 0b110, Tdag );
+  terms.add_term( 0b111, T );
+
+  caterpillar::satbased_cnotrz_params ps;
+  ps.warm_start = true;
+  ps.num_threads = 2u;
+  caterpillar::satbased_cnotrz_stats st;
+  const auto circ = caterpillar::satbased_cnotrz<tweedledum::netlist<tweedledum::mcst_gate>>( transform, terms, ps, &st );
+
+  CHECK( circ.num_gates() == 13u );
+  CHECK( circ.num_qubits() == 3u );
+  CHECK( st.optimal );
+  CHECK( st.num_cnots <= st.upper_bound );
+}
+
+TEST_CASE( "Warm-started phase polynomial synthesis with timeout", "[satbased_cnotrz]" )
+{
+  tweedledum::bit_matrix_rm<> transform( 4u, 4u );
+  transform.at( 0, 1 ) = 1;
+  transform.at( 1, 0 ) = 1;
+  transform.at( 1, 1 ) = 1;
+  transform.at( 2, 2 ) = 1;
+  transform.at( 3, 3 ) = 1;
+  transform.at( 3, 0 ) = 1;
+
+  tweedledum::parity_terms terms;
+  for ( auto term = 1u; term < 16u; ++term )
+  {
+    terms.add_term( term, .1f );
+  }
+
+  caterpillar::satbased_cnotrz_params ps;
+  ps.warm_start = true;
+  ps.timeout = 1u;
+  caterpillar::satbased_cnotrz_stats st;
+  const auto circ = caterpillar::satbased_cnotrz<tweedledum::netlist<tweedledum::mcst_gate>>( transform, terms, ps, &st );
+
+  /* simulate the CNOTs to check the linear transformation */
+  std::vector<uint32_t> states{0b0001, 0b0010, 0b0100, 0b1000};
+  uint32_t num_cnots{0u}, num_rotations{0u};
+  circ.foreach_cgate( [&]( auto const& node ) {
+    if ( node.gate.is( tweedledum::gate_set::cx ) )
+    {
+      uint32_t c{}, t{};
+      node.gate.foreach_control( [&]( auto q ) { c = q; } );
+      node.gate.foreach_target( [&]( auto q ) { t = q; } );
+      states[t] ^= states[c];
+      ++num_cnots;
+    }
+    else
+    {
+      ++num_rotations;
+    }
+  } );
+
+  CHECK( num_cnots == st.num_cnots );
+  CHECK( num_cnots <= st.upper_bound );
+  CHECK( num_rotations == 15u );
+  for ( auto row = 0u; row < 4u; ++row )
+  {
+    for ( auto column = 0u; column < 4u; ++column )
+    {
+      CHECK( ( ( states[row] >> column ) & 1 ) == transform.at( row, column ) );
+    }
+  }
+}
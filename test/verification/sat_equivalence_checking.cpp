@@ -0,0 +1,130 @@
+#include <catch.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <caterpillar/structures/stg_gate.hpp>
+#include <caterpillar/synthesis/lhrs.hpp>
+#include <caterpillar/synthesis/strategies/xag_mapping_strategy.hpp>
+#include <caterpillar/verification/sat_equivalence_checking.hpp>
+#include <caterpillar/verification/simulate_circuit.hpp>
+#include <mockturtle/generators/arithmetic.hpp>
+#include <mockturtle/networks/xag.hpp>
+#include <tweedledum/gates/gate_set.hpp>
+#include <tweedledum/networks/netlist.hpp>
+
+TEST_CASE("SAT-based verification of simple reversible circuit", "[sat_equivalence_checking]")
+{
+  using namespace caterpillar;
+  using namespace mockturtle;
+  using namespace tweedledum;
+
+  netlist<stg_gate> circ;
+  const auto a = circ.add_qubit();
+  const auto b = circ.add_qubit();
+  const auto c = circ.add_qubit();
+  const auto d = circ.add_qubit();
+  const auto e = circ.add_qubit();
+
+  circ.add_gate( gate::mcx, std::vector<qubit_id>( {a, b} ), {d} );
+  circ.add_gate( gate::mcx, std::vector<qubit_id>( {c, d} ), {e} );
+
+  xag_network xag;
+  const auto x1 = xag.create_pi();
+  const auto x2 = xag.create_pi();
+  const auto x3 = xag.create_pi();
+  xag.create_po( xag.create_and( xag.create_and( x1, x2 ), x3 ) );
+
+  sat_equivalence_checking_params ps;
+  ps.check_ancillae = false;
+  CHECK( *sat_equivalence_checking( circ, xag, {a, b, c}, {e}, ps ) );
+
+  /* qubit d is not uncomputed */
+  sat_equivalence_checking_stats st;
+  ps.check_ancillae = true;
+  CHECK( !*sat_equivalence_checking( circ, xag, {a, b, c}, {e}, ps, &st ) );
+  CHECK( st.num_ancillae == 1u );
+  CHECK( st.ancilla_failure );
+  CHECK( st.failing_qubit == d );
+
+  circ.add_gate( gate::mcx, std::vector<qubit_id>( {a, b} ), {d} );
+  CHECK( *sat_equivalence_checking( circ, xag, {a, b, c}, {e}, ps ) );
+
+  /* wrong output */
+  circ.add_gate( gate::cx, a, e );
+  st = {};
+  CHECK( !*sat_equivalence_checking( circ, xag, {a, b, c}, {e}, ps, &st ) );
+  CHECK( !st.ancilla_failure );
+  CHECK( st.failing_qubit == e );
+  CHECK( st.counter_example.size() == 3u );
+  CHECK( st.counter_example[0] );
+}
+
+TEST_CASE("Verification of measured AND uncomputations", "[sat_equivalence_checking]")
+{
+  using namespace caterpillar;
+  using namespace mockturtle;
+  using namespace tweedledum;
+
+  xag_network xag;
+  const auto x1 = xag.create_pi();
+  const auto x2 = xag.create_pi();
+  const auto x3 = xag.create_pi();
+  xag.create_po( xag.create_and( xag.create_and( x1, !x2 ), x3 ) );
+
+  for ( auto wrong : {false, true} )
+  {
+    netlist<stg_gate> circ;
+    const auto a = circ.add_qubit();
+    const auto b = circ.add_qubit();
+    const auto c = circ.add_qubit();
+    const auto d = circ.add_qubit();
+    const auto e = circ.add_qubit();
+
+    circ.add_gate( gate::mcx, std::vector<qubit_id>( {a, qubit_id( b, true )} ), {d} );
+    circ.add_gate( gate::mcx, std::vector<qubit_id>( {c, d} ), {e} );
+
+    /* uncomputing with the wrong polarity of b leaves d = a */
+    circ.add_gate( stg_gate::measured_and_uncompute( a, qubit_id( b, !wrong ), d ) );
+
+    sat_equivalence_checking_stats st;
+    CHECK( *sat_equivalence_checking( circ, xag, {a, b, c}, {e}, {}, &st ) == !wrong );
+    CHECK( st.ancilla_failure == wrong );
+
+    simulation_checking_stats sim_st;
+    CHECK( *simulation_checking( circ, xag, {a, b, c}, {e}, {}, &sim_st ) == !wrong );
+    CHECK( sim_st.ancilla_failure == wrong );
+    if ( wrong )
+    {
+      CHECK( st.failing_qubit == d );
+      CHECK( sim_st.failing_qubit == d );
+    }
+  }
+}
+
+TEST_CASE("SAT-based verification of 64-bit adder", "[sat_equivalence_checking]")
+{
+  using namespace caterpillar;
+  using namespace mockturtle;
+
+  xag_network xag;
+  std::vector<xag_network::signal> a( 64u ), b( 64u );
+  std::generate( a.begin(), a.end(), [&]() { return xag.create_pi(); } );
+  std::generate( b.begin(), b.end(), [&]() { return xag.create_pi(); } );
+  auto carry = xag.get_constant( false );
+  carry_ripple_adder_inplace( xag, a, b, carry );
+  std::for_each( a.begin(), a.end(), [&]( auto f ) { xag.create_po( f ); } );
+  xag.create_po( carry );
+
+  tweedledum::netlist<stg_gate> circ;
+  logic_network_synthesis_stats st;
+  xag_mapping_strategy strategy;
+  logic_network_synthesis( circ, xag, strategy, {}, {}, &st );
+
+  sat_equivalence_checking_stats ec_st;
+  const auto result = sat_equivalence_checking( circ, xag, st.i_indexes, st.o_indexes, {}, &ec_st );
+  CHECK( result );
+  CHECK( *result );
+  CHECK( ec_st.num_ancillae > 0u );
+}
@@ -0,0 +1,102 @@
+#include <catch.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <caterpillar/structures/stg_gate.hpp>
+#include <caterpillar/synthesis/lhrs.hpp>
+#include <caterpillar/synthesis/strategies/bennett_mapping_strategy.hpp>
+#include <caterpillar/synthesis/strategies/xag_mapping_strategy.hpp>
+#include <caterpillar/verification/simulate_circuit.hpp>
+#include <kitty/constructors.hpp>
+#include <kitty/dynamic_truth_table.hpp>
+#include <mockturtle/generators/arithmetic.hpp>
+#include <mockturtle/networks/aig.hpp>
+#include <mockturtle/networks/xag.hpp>
+#include <tweedledum/networks/netlist.hpp>
+
+TEST_CASE("Bit-parallel simulation of circuit with LUT gates", "[simulate_circuit]")
+{
+  using namespace caterpillar;
+  using namespace tweedledum;
+
+  netlist<stg_gate> circ;
+  const auto a = circ.add_qubit();
+  const auto b = circ.add_qubit();
+  const auto c = circ.add_qubit();
+  const auto d = circ.add_qubit();
+
+  kitty::dynamic_truth_table maj( 3u );
+  kitty::create_majority( maj );
+  circ.add_gate( stg_gate( maj, {a, qubit_id( b, true ), c}, d ) );
+
+  const auto values = simulate_circuit( circ, {a, b, c}, create_exhaustive_patterns( 3u ) );
+  CHECK( values );
+
+  kitty::dynamic_truth_table x1( 6u ), x2( 6u ), x3( 6u );
+  kitty::create_nth_var( x1, 0u );
+  kitty::create_nth_var( x2, 1u );
+  kitty::create_nth_var( x3, 2u );
+  CHECK( ( *values )[d] == kitty::ternary_majority( x1, ~x2, x3 ) );
+  CHECK( ( *values )[b] == x2 );
+}
+
+TEST_CASE("Simulation checking of synthesized circuits", "[simulate_circuit]")
+{
+  using namespace caterpillar;
+  using namespace mockturtle;
+
+  xag_network xag;
+  std::vector<xag_network::signal> a( 16u ), b( 16u );
+  std::generate( a.begin(), a.end(), [&]() { return xag.create_pi(); } );
+  std::generate( b.begin(), b.end(), [&]() { return xag.create_pi(); } );
+  auto carry = xag.get_constant( false );
+  carry_ripple_adder_inplace( xag, a, b, carry );
+  std::for_each( a.begin(), a.end(), [&]( auto f ) { xag.create_po( f ); } );
+  xag.create_po( carry );
+
+  {
+    tweedledum::netlist<stg_gate> circ;
+    logic_network_synthesis_stats st;
+    xag_mapping_strategy strategy;
+    logic_network_synthesis( circ, xag, strategy, {}, {}, &st );
+
+    simulation_checking_stats sim_st;
+    CHECK( *simulation_checking( circ, xag, st.i_indexes, st.o_indexes, {}, &sim_st ) );
+    CHECK( !sim_st.exhaustive );
+    CHECK( sim_st.num_patterns == 1024u );
+
+    /* flip an output */
+    circ.add_gate( tweedledum::gate::pauli_x, tweedledum::qubit_id( st.o_indexes[3u] ) );
+    CHECK( !*simulation_checking( circ, xag, st.i_indexes, st.o_indexes, {}, &sim_st ) );
+    CHECK( sim_st.failing_qubit == st.o_indexes[3u] );
+  }
+
+  {
+    aig_network aig;
+    std::vector<aig_network::signal> a( 8u ), b( 8u );
+    std::generate( a.begin(), a.end(), [&]() { return aig.create_pi(); } );
+    std::generate( b.begin(), b.end(), [&]() { return aig.create_pi(); } );
+    auto carry = aig.get_constant( false );
+    carry_ripple_adder_inplace( aig, a, b, carry );
+    std::for_each( a.begin(), a.end(), [&]( auto f ) { aig.create_po( f ); } );
+    aig.create_po( carry );
+
+    /* keep LUT gates in the circuit */
+    const auto stg_fn = []( auto& net, auto const& qubit_map, kitty::dynamic_truth_table const& function ) {
+      std::vector<tweedledum::qubit_id> controls( qubit_map.begin(), qubit_map.end() - 1 );
+      net.add_gate( stg_gate( function, controls, qubit_map.back() ) );
+    };
+
+    tweedledum::netlist<stg_gate> circ;
+    logic_network_synthesis_stats st;
+    bennett_mapping_strategy<aig_network> strategy;
+    logic_network_synthesis( circ, aig, strategy, stg_fn, {}, &st );
+
+    simulation_checking_params ps_sim;
+    ps_sim.exhaustive_limit = 0u;
+    simulation_checking_stats sim_st;
+    CHECK( *simulation_checking( circ, aig, st.i_indexes, st.o_indexes, ps_sim, &sim_st ) );
+  }
+}